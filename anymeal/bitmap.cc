@@ -0,0 +1,385 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <algorithm>
+#include <iterator>
+#include "bitmap.hh"
+
+
+#define ARRAY_MAX 4096
+#define WORDS 1024
+
+using namespace std;
+
+Bitmap::const_iterator::const_iterator(const Bitmap *bitmap, size_t container, int position):
+  m_bitmap(bitmap), m_container(container), m_position(position)
+{
+  skip();
+}
+
+void Bitmap::const_iterator::skip(void) {
+  while (m_container < m_bitmap->m_containers.size()) {
+    const Container &container = m_bitmap->m_containers[m_container];
+    if (container.bits.empty()) {
+      if (m_position < (int)container.array.size())
+        return;
+    } else {
+      while (m_position < WORDS * 64) {
+        uint64_t word = container.bits[m_position >> 6] >> (m_position & 63);
+        if (word) {
+          m_position += __builtin_ctzll(word);
+          return;
+        };
+        m_position = (m_position | 63) + 1;
+      };
+    };
+    m_container++;
+    m_position = 0;
+  };
+}
+
+sqlite3_int64 Bitmap::const_iterator::operator*(void) const {
+  const Container &container = m_bitmap->m_containers[m_container];
+  int low = container.bits.empty() ? container.array[m_position] : m_position;
+  return (container.key << 16) | low;
+}
+
+Bitmap::const_iterator &Bitmap::const_iterator::operator++(void) {
+  m_position++;
+  skip();
+  return *this;
+}
+
+bool Bitmap::const_iterator::operator==(const const_iterator &other) const {
+  return m_bitmap == other.m_bitmap && m_container == other.m_container && m_position == other.m_position;
+}
+
+Bitmap::const_iterator Bitmap::begin(void) const {
+  return const_iterator(this, 0, 0);
+}
+
+Bitmap::const_iterator Bitmap::end(void) const {
+  return const_iterator(this, m_containers.size(), 0);
+}
+
+size_t Bitmap::find(sqlite3_int64 key) const {
+  size_t lower = 0;
+  size_t upper = m_containers.size();
+  while (lower < upper) {
+    size_t middle = (lower + upper) / 2;
+    if (m_containers[middle].key < key)
+      lower = middle + 1;
+    else
+      upper = middle;
+  };
+  return lower;
+}
+
+void Bitmap::to_bits(Container &container) {
+  container.bits.assign(WORDS, 0);
+  for (vector<uint16_t>::iterator i=container.array.begin(); i!=container.array.end(); i++)
+    container.bits[*i >> 6] |= 1ULL << (*i & 63);
+  vector<uint16_t>().swap(container.array);
+}
+
+void Bitmap::optimize(Container &container) {
+  if (container.bits.empty()) {
+    if (container.cardinality > ARRAY_MAX)
+      to_bits(container);
+  } else if (container.cardinality <= ARRAY_MAX) {
+    container.array.clear();
+    container.array.reserve(container.cardinality);
+    for (int i=0; i<WORDS; i++) {
+      uint64_t word = container.bits[i];
+      while (word) {
+        container.array.push_back(i * 64 + __builtin_ctzll(word));
+        word &= word - 1;
+      };
+    };
+    vector<uint64_t>().swap(container.bits);
+  };
+}
+
+bool Bitmap::contains(const Container &container, uint16_t low) {
+  if (container.bits.empty())
+    return binary_search(container.array.begin(), container.array.end(), low);
+  else
+    return (container.bits[low >> 6] >> (low & 63)) & 1;
+}
+
+static int count_bits(const vector<uint64_t> &bits) {
+  int result = 0;
+  for (vector<uint64_t>::const_iterator word=bits.begin(); word!=bits.end(); word++)
+    result += __builtin_popcountll(*word);
+  return result;
+}
+
+void Bitmap::intersect(Container &container, const Container &other) {
+  if (container.bits.empty()) {
+    vector<uint16_t> result;
+    if (other.bits.empty())
+      set_intersection(container.array.begin(), container.array.end(), other.array.begin(), other.array.end(),
+                       back_inserter(result));
+    else {
+      for (vector<uint16_t>::iterator i=container.array.begin(); i!=container.array.end(); i++)
+        if (contains(other, *i))
+          result.push_back(*i);
+    };
+    container.array.swap(result);
+    container.cardinality = container.array.size();
+  } else if (other.bits.empty()) {
+    for (vector<uint16_t>::const_iterator i=other.array.begin(); i!=other.array.end(); i++)
+      if (contains(container, *i))
+        container.array.push_back(*i);
+    vector<uint64_t>().swap(container.bits);
+    container.cardinality = container.array.size();
+  } else {
+    for (int i=0; i<WORDS; i++)
+      container.bits[i] &= other.bits[i];
+    container.cardinality = count_bits(container.bits);
+    optimize(container);
+  };
+}
+
+void Bitmap::subtract(Container &container, const Container &other) {
+  if (container.bits.empty()) {
+    vector<uint16_t> result;
+    for (vector<uint16_t>::iterator i=container.array.begin(); i!=container.array.end(); i++)
+      if (!contains(other, *i))
+        result.push_back(*i);
+    container.array.swap(result);
+    container.cardinality = container.array.size();
+  } else {
+    if (other.bits.empty()) {
+      for (vector<uint16_t>::const_iterator i=other.array.begin(); i!=other.array.end(); i++)
+        container.bits[*i >> 6] &= ~(1ULL << (*i & 63));
+    } else {
+      for (int i=0; i<WORDS; i++)
+        container.bits[i] &= ~other.bits[i];
+    };
+    container.cardinality = count_bits(container.bits);
+    optimize(container);
+  };
+}
+
+void Bitmap::unite(Container &container, const Container &other) {
+  if (container.bits.empty() && other.bits.empty()) {
+    vector<uint16_t> result;
+    set_union(container.array.begin(), container.array.end(), other.array.begin(), other.array.end(), back_inserter(result));
+    container.array.swap(result);
+    container.cardinality = container.array.size();
+  } else {
+    if (container.bits.empty())
+      to_bits(container);
+    if (other.bits.empty()) {
+      for (vector<uint16_t>::const_iterator i=other.array.begin(); i!=other.array.end(); i++)
+        container.bits[*i >> 6] |= 1ULL << (*i & 63);
+    } else {
+      for (int i=0; i<WORDS; i++)
+        container.bits[i] |= other.bits[i];
+    };
+    container.cardinality = count_bits(container.bits);
+  };
+  optimize(container);
+}
+
+void Bitmap::add(sqlite3_int64 id) {
+  sqlite3_int64 key = id >> 16;
+  uint16_t low = id & 0xFFFF;
+  size_t index;
+  // Ids are usually added in ascending order.
+  if (!m_containers.empty() && m_containers.back().key == key)
+    index = m_containers.size() - 1;
+  else {
+    index = find(key);
+    if (index == m_containers.size() || m_containers[index].key != key)
+      m_containers.insert(m_containers.begin() + index, Container(key));
+  };
+  Container &container = m_containers[index];
+  if (container.bits.empty()) {
+    vector<uint16_t>::iterator position = container.array.end();
+    if (!container.array.empty() && container.array.back() >= low) {
+      position = lower_bound(container.array.begin(), container.array.end(), low);
+      if (*position == low)
+        return;
+    };
+    container.array.insert(position, low);
+  } else {
+    uint64_t &word = container.bits[low >> 6];
+    uint64_t mask = 1ULL << (low & 63);
+    if (word & mask)
+      return;
+    word |= mask;
+  };
+  container.cardinality++;
+  m_size++;
+  optimize(container);
+}
+
+void Bitmap::remove(sqlite3_int64 id) {
+  sqlite3_int64 key = id >> 16;
+  uint16_t low = id & 0xFFFF;
+  size_t index = find(key);
+  if (index == m_containers.size() || m_containers[index].key != key)
+    return;
+  Container &container = m_containers[index];
+  if (!contains(container, low))
+    return;
+  if (container.bits.empty())
+    container.array.erase(lower_bound(container.array.begin(), container.array.end(), low));
+  else
+    container.bits[low >> 6] &= ~(1ULL << (low & 63));
+  container.cardinality--;
+  m_size--;
+  if (container.cardinality == 0)
+    m_containers.erase(m_containers.begin() + index);
+  else
+    optimize(container);
+}
+
+bool Bitmap::contains(sqlite3_int64 id) const {
+  size_t index = find(id >> 16);
+  if (index == m_containers.size() || m_containers[index].key != id >> 16)
+    return false;
+  return contains(m_containers[index], id & 0xFFFF);
+}
+
+void Bitmap::clear(void) {
+  m_containers.clear();
+  m_size = 0;
+}
+
+vector<sqlite3_int64> Bitmap::ids(void) const {
+  vector<sqlite3_int64> result;
+  result.reserve(m_size);
+  for (const_iterator i=begin(); i!=end(); ++i)
+    result.push_back(*i);
+  return result;
+}
+
+size_t Bitmap::memory(void) const {
+  size_t result = sizeof(Bitmap) + m_containers.capacity() * sizeof(Container);
+  for (vector<Container>::const_iterator container=m_containers.begin(); container!=m_containers.end(); container++)
+    result += container->array.capacity() * sizeof(uint16_t) + container->bits.capacity() * sizeof(uint64_t);
+  return result;
+}
+
+Bitmap &Bitmap::operator&=(const Bitmap &other) {
+  vector<Container> result;
+  vector<Container>::iterator a = m_containers.begin();
+  vector<Container>::const_iterator b = other.m_containers.begin();
+  m_size = 0;
+  while (a != m_containers.end() && b != other.m_containers.end()) {
+    if (a->key < b->key)
+      a++;
+    else if (b->key < a->key)
+      b++;
+    else {
+      intersect(*a, *b);
+      if (a->cardinality) {
+        m_size += a->cardinality;
+        result.push_back(Container(a->key));
+        result.back().cardinality = a->cardinality;
+        result.back().array.swap(a->array);
+        result.back().bits.swap(a->bits);
+      };
+      a++;
+      b++;
+    };
+  };
+  m_containers.swap(result);
+  return *this;
+}
+
+Bitmap &Bitmap::operator-=(const Bitmap &other) {
+  vector<Container> result;
+  vector<Container>::const_iterator b = other.m_containers.begin();
+  m_size = 0;
+  for (vector<Container>::iterator a=m_containers.begin(); a!=m_containers.end(); a++) {
+    while (b != other.m_containers.end() && b->key < a->key)
+      b++;
+    if (b != other.m_containers.end() && b->key == a->key)
+      subtract(*a, *b);
+    if (a->cardinality) {
+      m_size += a->cardinality;
+      result.push_back(Container(a->key));
+      result.back().cardinality = a->cardinality;
+      result.back().array.swap(a->array);
+      result.back().bits.swap(a->bits);
+    };
+  };
+  m_containers.swap(result);
+  return *this;
+}
+
+Bitmap &Bitmap::operator|=(const Bitmap &other) {
+  vector<Container> result;
+  vector<Container>::iterator a = m_containers.begin();
+  vector<Container>::const_iterator b = other.m_containers.begin();
+  m_size = 0;
+  while (a != m_containers.end() || b != other.m_containers.end()) {
+    if (b == other.m_containers.end() || (a != m_containers.end() && a->key < b->key)) {
+      result.push_back(Container(a->key));
+      result.back().cardinality = a->cardinality;
+      result.back().array.swap(a->array);
+      result.back().bits.swap(a->bits);
+      a++;
+    } else if (a == m_containers.end() || b->key < a->key) {
+      result.push_back(*b);
+      b++;
+    } else {
+      unite(*a, *b);
+      result.push_back(Container(a->key));
+      result.back().cardinality = a->cardinality;
+      result.back().array.swap(a->array);
+      result.back().bits.swap(a->bits);
+      a++;
+      b++;
+    };
+    m_size += result.back().cardinality;
+  };
+  m_containers.swap(result);
+  return *this;
+}
+
+bool Bitmap::operator==(const Bitmap &other) const {
+  if (m_size != other.m_size || m_containers.size() != other.m_containers.size())
+    return false;
+  for (size_t i=0; i<m_containers.size(); i++) {
+    const Container &a = m_containers[i];
+    const Container &b = other.m_containers[i];
+    if (a.key != b.key || a.cardinality != b.cardinality || a.array != b.array || a.bits != b.bits)
+      return false;
+  };
+  return true;
+}
+
+Bitmap operator&(const Bitmap &a, const Bitmap &b) {
+  Bitmap result = a;
+  result &= b;
+  return result;
+}
+
+Bitmap operator-(const Bitmap &a, const Bitmap &b) {
+  Bitmap result = a;
+  result -= b;
+  return result;
+}
+
+Bitmap operator|(const Bitmap &a, const Bitmap &b) {
+  Bitmap result = a;
+  result |= b;
+  return result;
+}
@@ -0,0 +1,81 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include <sqlite3.h>
+
+
+// Compressed set of recipe ids. The ids are grouped by their upper bits into containers of 65536 values. Each container
+// either stores a sorted array of the lower 16 bits or, once it holds more than 4096 values, a bitmap of 1024 words.
+class Bitmap
+{
+public:
+  class const_iterator
+  {
+  public:
+    const_iterator(void): m_bitmap(NULL), m_container(0), m_position(0) {}
+    const_iterator(const Bitmap *bitmap, size_t container, int position);
+    sqlite3_int64 operator*(void) const;
+    const_iterator &operator++(void);
+    bool operator==(const const_iterator &other) const;
+    bool operator!=(const const_iterator &other) const { return !(*this == other); }
+  protected:
+    void skip(void);
+    const Bitmap *m_bitmap;
+    size_t m_container;
+    int m_position;
+  };
+  Bitmap(void): m_size(0) {}
+  const_iterator begin(void) const;
+  const_iterator end(void) const;
+  void add(sqlite3_int64 id);
+  void remove(sqlite3_int64 id);
+  bool contains(sqlite3_int64 id) const;
+  sqlite3_int64 size(void) const { return m_size; }
+  bool empty(void) const { return m_size == 0; }
+  void clear(void);
+  std::vector<sqlite3_int64> ids(void) const;
+  size_t memory(void) const;
+  Bitmap &operator&=(const Bitmap &other);
+  Bitmap &operator-=(const Bitmap &other);
+  Bitmap &operator|=(const Bitmap &other);
+  bool operator==(const Bitmap &other) const;
+  bool operator!=(const Bitmap &other) const { return !(*this == other); }
+protected:
+  struct Container {
+    Container(sqlite3_int64 key_): key(key_), cardinality(0) {}
+    sqlite3_int64 key;
+    int cardinality;
+    std::vector<uint16_t> array;
+    std::vector<uint64_t> bits;
+  };
+  size_t find(sqlite3_int64 key) const;
+  static void to_bits(Container &container);
+  static void optimize(Container &container);
+  static bool contains(const Container &container, uint16_t low);
+  static void intersect(Container &container, const Container &other);
+  static void subtract(Container &container, const Container &other);
+  static void unite(Container &container, const Container &other);
+  std::vector<Container> m_containers;
+  sqlite3_int64 m_size;
+};
+
+Bitmap operator&(const Bitmap &a, const Bitmap &b);
+
+Bitmap operator-(const Bitmap &a, const Bitmap &b);
+
+Bitmap operator|(const Bitmap &a, const Bitmap &b);
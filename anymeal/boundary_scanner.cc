@@ -0,0 +1,114 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <cstring>
+#include "boundary_scanner.hh"
+#ifdef HAVE_SSE2_SCANNER
+#include <emmintrin.h>
+#endif
+#ifdef HAVE_AVX2_SCANNER
+#include <immintrin.h>
+#endif
+
+
+static inline bool delimiter_start(char c) {
+  return c == 'M' || c == '-';
+}
+
+static size_t scan_tail(const char *data, size_t size, size_t position) {
+  // Check the character following each line break.
+  while (position + 1 < size) {
+    const char *newline = (const char *)memchr(data + position, '\n', size - position - 1);
+    if (!newline)
+      break;
+    position = newline - data + 1;
+    if (delimiter_start(data[position]))
+      return position;
+  };
+  return size;
+}
+
+size_t next_delimiter_scalar(const char *data, size_t size, size_t position) {
+  if (position < size && delimiter_start(data[position]))
+    return position;
+  return scan_tail(data, size, position);
+}
+
+#ifdef HAVE_SSE2_SCANNER
+size_t next_delimiter_sse2(const char *data, size_t size, size_t position) {
+  if (position < size && delimiter_start(data[position]))
+    return position;
+  const __m128i newline = _mm_set1_epi8('\n');
+  const __m128i m = _mm_set1_epi8('M');
+  const __m128i minus = _mm_set1_epi8('-');
+  // Compare each block with the block shifted by one character to find line breaks followed by 'M' or '-'.
+  while (position + 17 <= size) {
+    __m128i current = _mm_loadu_si128((const __m128i *)(data + position));
+    __m128i following = _mm_loadu_si128((const __m128i *)(data + position + 1));
+    __m128i hit = _mm_and_si128(_mm_cmpeq_epi8(current, newline),
+                                _mm_or_si128(_mm_cmpeq_epi8(following, m), _mm_cmpeq_epi8(following, minus)));
+    int mask = _mm_movemask_epi8(hit);
+    if (mask)
+      return position + __builtin_ctz(mask) + 1;
+    position += 16;
+  };
+  return scan_tail(data, size, position);
+}
+#endif
+
+#ifdef HAVE_AVX2_SCANNER
+bool avx2_supported(void) {
+  return __builtin_cpu_supports("avx2");
+}
+
+__attribute__((target("avx2")))
+size_t next_delimiter_avx2(const char *data, size_t size, size_t position) {
+  if (position < size && delimiter_start(data[position]))
+    return position;
+  const __m256i newline = _mm256_set1_epi8('\n');
+  const __m256i m = _mm256_set1_epi8('M');
+  const __m256i minus = _mm256_set1_epi8('-');
+  while (position + 33 <= size) {
+    __m256i current = _mm256_loadu_si256((const __m256i *)(data + position));
+    __m256i following = _mm256_loadu_si256((const __m256i *)(data + position + 1));
+    __m256i hit = _mm256_and_si256(_mm256_cmpeq_epi8(current, newline),
+                                   _mm256_or_si256(_mm256_cmpeq_epi8(following, m), _mm256_cmpeq_epi8(following, minus)));
+    unsigned int mask = _mm256_movemask_epi8(hit);
+    if (mask)
+      return position + __builtin_ctz(mask) + 1;
+    position += 32;
+  };
+  return scan_tail(data, size, position);
+}
+#endif
+
+typedef size_t (*scanner_t)(const char *, size_t, size_t);
+
+static scanner_t select_scanner(void) {
+#ifdef HAVE_AVX2_SCANNER
+  if (avx2_supported())
+    return &next_delimiter_avx2;
+#endif
+#ifdef HAVE_SSE2_SCANNER
+  return &next_delimiter_sse2;
+#else
+  return &next_delimiter_scalar;
+#endif
+}
+
+size_t next_delimiter(const char *data, size_t size, size_t position) {
+  static scanner_t scanner = select_scanner();
+  return scanner(data, size, position);
+}
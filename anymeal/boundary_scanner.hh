@@ -0,0 +1,42 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <stddef.h>
+
+
+#if defined(__SSE2__)
+#define HAVE_SSE2_SCANNER
+#endif
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_AVX2_SCANNER
+#endif
+
+// Recipe delimiters are lines starting with "MMMMM" or "-----". The scanners return the offset of the next line at or
+// after the specified line start whose first character is 'M' or '-', or the size of the data if there is none. All
+// other lines can be skipped when looking for delimiters. The vectorised scanners compare 16 or 32 bytes at a time.
+size_t next_delimiter(const char *data, size_t size, size_t position);
+
+size_t next_delimiter_scalar(const char *data, size_t size, size_t position);
+
+#ifdef HAVE_SSE2_SCANNER
+size_t next_delimiter_sse2(const char *data, size_t size, size_t position);
+#endif
+
+#ifdef HAVE_AVX2_SCANNER
+bool avx2_supported(void);
+
+size_t next_delimiter_avx2(const char *data, size_t size, size_t position);
+#endif
@@ -16,20 +16,14 @@
 #pragma once
 #include <vector>
 #include <string>
-#include <QtCore/QAbstractListModel>
-#include "database.hh"
+#include "facets_model.hh"
 
 
-class CategoriesModel: public QAbstractListModel
+class CategoriesModel: public FacetsModel
 {
   Q_OBJECT
 public:
-  CategoriesModel(QObject *parent, Database *database);
-  void reset(void);
-  virtual int rowCount(const QModelIndex &parent=QModelIndex()) const;
-  virtual QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const;
-  std::vector<std::string> categories(void) { return m_categories; };
-protected:
-  Database *m_database;
-  std::vector<std::string> m_categories;
+  CategoriesModel(QObject *parent): FacetsModel(parent) {}
+  void reset(const std::vector<std::pair<std::string, int> > &categories) { FacetsModel::reset(categories); }
+  std::vector<std::string> categories(void);
 };
@@ -13,25 +13,156 @@
 
    You should have received a copy of the GNU General Public License
    along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <algorithm>
 #include <cassert>
+#include <cctype>
+#include <cstring>
 #include <sstream>
 #include "database.hh"
 
 
 using namespace std;
 
+#define BUSY_TIMEOUT 5000
+#define PROGRESS_INSTRUCTIONS 1000
+#define FILTER_CACHE_SIZE 64
+
+// Values stored in the full-text index. Deleting from the contentless index requires the same values again.
+#define RECIPE_TEXT "SELECT id, title, (SELECT group_concat(txt, char(10)) FROM (SELECT txt FROM instruction " \
+                    "WHERE recipeid = recipes.id ORDER BY line)) FROM recipes"
+
+static string text_query(const char *text) {
+  // Convert words to prefix queries so that punctuation in the search text does not cause syntax errors.
+  ostringstream query;
+  string word;
+  for (const char *p = text; ; p++) {
+    unsigned char c = *p;
+    if (c >= 0x80 || isalnum(c)) {
+      word += c;
+    } else {
+      if (!word.empty()) {
+        if (query.tellp() > 0)
+          query << " ";
+        query << "\"" << word << "\"*";
+        word.clear();
+      };
+      if (!c)
+        break;
+    };
+  };
+  return query.str();
+}
+
+// Schema migrations starting from version 1 as created by Database::create.
+const Migration Database::migrations[] = {
+  // Full-text index for recipe titles and instructions.
+  {2,
+   "CREATE VIRTUAL TABLE recipetext USING fts5(title, instructions, content='', tokenize='unicode61 remove_diacritics 2');\n"
+   "INSERT INTO recipetext(rowid, title, instructions) " RECIPE_TEXT ";\n",
+   NULL},
+  // Trigram index for ingredient substrings.
+  {3,
+   "CREATE VIRTUAL TABLE ingredienttext USING fts5(name, content='ingredients', content_rowid='id', tokenize='trigram');\n"
+   "INSERT INTO ingredienttext(ingredienttext) VALUES('rebuild');\n"
+   "CREATE TRIGGER ingredients_insert AFTER INSERT ON ingredients BEGIN\n"
+   "  INSERT INTO ingredienttext(rowid, name) VALUES(new.id, new.name);\n"
+   "END;\n"
+   "CREATE TRIGGER ingredients_delete AFTER DELETE ON ingredients BEGIN\n"
+   "  INSERT INTO ingredienttext(ingredienttext, rowid, name) VALUES('delete', old.id, old.name);\n"
+   "END;\n"
+   "CREATE TRIGGER ingredients_update AFTER UPDATE ON ingredients BEGIN\n"
+   "  INSERT INTO ingredienttext(ingredienttext, rowid, name) VALUES('delete', old.id, old.name);\n"
+   "  INSERT INTO ingredienttext(rowid, name) VALUES(new.id, new.name);\n"
+   "END;\n"
+   "CREATE INDEX ingredient_ingredientid ON ingredient(ingredientid);\n",
+   NULL},
+  // Cache of encoded recipes filled with the existing recipes. Changing the categories of a recipe discards the encoded recipe.
+  {4,
+   "CREATE TABLE recipecache(recipeid INTEGER PRIMARY KEY, data BLOB NOT NULL, "
+   "FOREIGN KEY(recipeid) REFERENCES recipes(id));\n"
+   "CREATE TRIGGER category_insert AFTER INSERT ON category BEGIN\n"
+   "  DELETE FROM recipecache WHERE recipeid = new.recipeid;\n"
+   "END;\n"
+   "CREATE TRIGGER category_delete AFTER DELETE ON category BEGIN\n"
+   "  DELETE FROM recipecache WHERE recipeid = old.recipeid;\n"
+   "END;\n"
+   "CREATE TRIGGER category_update AFTER UPDATE ON category BEGIN\n"
+   "  DELETE FROM recipecache WHERE recipeid = old.recipeid OR recipeid = new.recipeid;\n"
+   "END;\n"
+   "CREATE TRIGGER categories_update AFTER UPDATE ON categories BEGIN\n"
+   "  DELETE FROM recipecache WHERE recipeid IN (SELECT recipeid FROM category WHERE categoryid = new.id);\n"
+   "END;\n",
+   &Database::fill_cache},
+  // Covering indexes for looking up recipes by category or ingredient and for sorting by title.
+  {5,
+   "CREATE INDEX category_categoryid ON category(categoryid, recipeid);\n"
+   "DROP INDEX ingredient_ingredientid;\n"
+   "CREATE INDEX ingredient_ingredientid ON ingredient(ingredientid, recipeid);\n"
+   "CREATE INDEX recipes_title ON recipes(title COLLATE NOCASE);\n",
+   NULL},
+  // Number of recipes per category maintained by triggers. Changing the counts must not discard cached recipes.
+  {6,
+   "ALTER TABLE categories ADD COLUMN recipecount INTEGER NOT NULL DEFAULT 0;\n"
+   "DROP TRIGGER categories_update;\n"
+   "CREATE TRIGGER categories_update AFTER UPDATE OF name ON categories BEGIN\n"
+   "  DELETE FROM recipecache WHERE recipeid IN (SELECT recipeid FROM category WHERE categoryid = new.id);\n"
+   "END;\n"
+   "UPDATE categories SET recipecount = (SELECT COUNT(*) FROM category WHERE categoryid = categories.id);\n"
+   "CREATE TRIGGER category_count_insert AFTER INSERT ON category BEGIN\n"
+   "  UPDATE categories SET recipecount = recipecount + 1 WHERE id = new.categoryid;\n"
+   "END;\n"
+   "CREATE TRIGGER category_count_delete AFTER DELETE ON category BEGIN\n"
+   "  UPDATE categories SET recipecount = recipecount - 1 WHERE id = old.categoryid;\n"
+   "END;\n"
+   "CREATE TRIGGER category_count_update AFTER UPDATE OF categoryid ON category BEGIN\n"
+   "  UPDATE categories SET recipecount = recipecount - 1 WHERE id = old.categoryid;\n"
+   "  UPDATE categories SET recipecount = recipecount + 1 WHERE id = new.categoryid;\n"
+   "END;\n",
+   NULL},
+  // Hash of the recipe content for detecting duplicates computed for the existing recipes.
+  {7,
+   "ALTER TABLE recipes ADD COLUMN contenthash INTEGER;\n"
+   "CREATE INDEX recipes_contenthash ON recipes(contenthash);\n",
+   &Database::hash_recipes},
+  // Trigram index for finding substrings of recipe titles.
+  {8,
+   "CREATE VIRTUAL TABLE titletext USING fts5(title, content='recipes', content_rowid='id', tokenize='trigram');\n"
+   "INSERT INTO titletext(titletext) VALUES('rebuild');\n"
+   "CREATE TRIGGER recipes_insert AFTER INSERT ON recipes BEGIN\n"
+   "  INSERT INTO titletext(rowid, title) VALUES(new.id, new.title);\n"
+   "END;\n"
+   "CREATE TRIGGER recipes_delete AFTER DELETE ON recipes BEGIN\n"
+   "  INSERT INTO titletext(titletext, rowid, title) VALUES('delete', old.id, old.title);\n"
+   "END;\n"
+   "CREATE TRIGGER recipes_update AFTER UPDATE OF title ON recipes BEGIN\n"
+   "  INSERT INTO titletext(titletext, rowid, title) VALUES('delete', old.id, old.title);\n"
+   "  INSERT INTO titletext(rowid, title) VALUES(new.id, new.title);\n"
+   "END;\n",
+   NULL}
+};
+
 Database::Database(void):
   m_db(NULL), m_begin(NULL), m_commit(NULL), m_rollback(NULL), m_insert_recipe(NULL),
-  m_add_category(NULL), m_recipe_category(NULL), m_add_ingredient(NULL), m_recipe_ingredient(NULL),
+  m_add_category(NULL), m_insert_category(NULL), m_recipe_category(NULL), m_get_ingredient_id(NULL),
+  m_insert_ingredient(NULL), m_recipe_ingredient(NULL),
   m_get_header(NULL), m_get_categories(NULL), m_category_and_count_list(NULL), m_get_ingredients(NULL),
   m_add_instruction(NULL), m_get_instructions(NULL), m_add_ingredient_section(NULL), m_get_ingredient_section(NULL),
-  m_add_instruction_section(NULL), m_get_instruction_section(NULL), m_count_selected(NULL), m_get_info(NULL),
-  m_select_title(NULL), m_category_list(NULL), m_select_category(NULL), m_select_no_category(NULL),
-  m_select_ingredient(NULL), m_select_no_ingredient(NULL), m_delete_recipe(NULL), m_delete_categories(NULL),
+  m_add_instruction_section(NULL), m_get_instruction_section(NULL), m_get_cached(NULL),
+  m_add_cached(NULL), m_delete_cached(NULL), m_fetch_cached(NULL), m_clear_ids(NULL),
+  m_add_id(NULL), m_fetch_headers(NULL), m_fetch_categories(NULL), m_fetch_ingredients(NULL), m_fetch_ingredient_sections(NULL),
+  m_fetch_instructions(NULL), m_fetch_instruction_sections(NULL), m_all_recipes(NULL), m_get_info(NULL),
+  m_get_info_page(NULL),
+  m_select_title(NULL), m_select_text(NULL), m_search_text(NULL), m_add_text(NULL), m_delete_text(NULL),
+  m_category_list(NULL), m_select_category(NULL), m_match_ingredients(NULL), m_ingredient_postings(NULL),
+  m_recipe_ingredient_ids(NULL), m_delete_postings(NULL), m_delete_recipe(NULL), m_delete_categories(NULL),
   m_delete_ingredients(NULL), m_delete_instructions(NULL), m_delete_ingredient_sections(NULL),
-  m_delete_instruction_sections(NULL), m_delete_selection(NULL), m_clean_categories(NULL), m_clean_ingredients(NULL),
-  m_select_recipe(NULL), m_remove_recipe_category(NULL), m_rename_category(NULL), m_get_category_id(NULL),
-  m_merge_category(NULL), m_delete_category(NULL), m_delete_recipe_category(NULL), m_count_recipes_in_category(NULL)
+  m_delete_instruction_sections(NULL), m_clean_categories(NULL), m_clean_ingredients(NULL),
+  m_remove_recipe_category(NULL), m_rename_category(NULL), m_get_category_id(NULL),
+  m_merge_category(NULL), m_delete_category(NULL), m_delete_recipe_category(NULL), m_category_recipes(NULL),
+  m_count_recipes_in_category(NULL),
+  m_check_category_counts(NULL), m_rebuild_category_counts(NULL), m_data_version(NULL),
+  m_count_facets(NULL), m_category_name(NULL), m_ingredient_name(NULL), m_duplicates(NULL), m_feature_ingredients(NULL),
+  m_generation(0), m_last_data_version(0), m_filter_cache(FILTER_CACHE_SIZE)
 {
 }
 
@@ -41,8 +172,10 @@ Database::~Database(void) {
   sqlite3_finalize(m_rollback);
   sqlite3_finalize(m_insert_recipe);
   sqlite3_finalize(m_add_category);
+  sqlite3_finalize(m_insert_category);
   sqlite3_finalize(m_recipe_category);
-  sqlite3_finalize(m_add_ingredient);
+  sqlite3_finalize(m_get_ingredient_id);
+  sqlite3_finalize(m_insert_ingredient);
   sqlite3_finalize(m_recipe_ingredient);
   sqlite3_finalize(m_get_header);
   sqlite3_finalize(m_get_categories);
@@ -54,33 +187,193 @@ Database::~Database(void) {
   sqlite3_finalize(m_get_ingredient_section);
   sqlite3_finalize(m_add_instruction_section);
   sqlite3_finalize(m_get_instruction_section);
-  sqlite3_finalize(m_count_selected);
+  sqlite3_finalize(m_get_cached);
+  sqlite3_finalize(m_add_cached);
+  sqlite3_finalize(m_delete_cached);
+  sqlite3_finalize(m_fetch_cached);
+  sqlite3_finalize(m_clear_ids);
+  sqlite3_finalize(m_add_id);
+  sqlite3_finalize(m_fetch_headers);
+  sqlite3_finalize(m_fetch_categories);
+  sqlite3_finalize(m_fetch_ingredients);
+  sqlite3_finalize(m_fetch_ingredient_sections);
+  sqlite3_finalize(m_fetch_instructions);
+  sqlite3_finalize(m_fetch_instruction_sections);
+  sqlite3_finalize(m_all_recipes);
+  sqlite3_finalize(m_get_info);
+  sqlite3_finalize(m_get_info_page);
   sqlite3_finalize(m_select_title);
+  sqlite3_finalize(m_select_text);
+  sqlite3_finalize(m_search_text);
+  sqlite3_finalize(m_add_text);
+  sqlite3_finalize(m_delete_text);
   sqlite3_finalize(m_category_list);
   sqlite3_finalize(m_select_category);
-  sqlite3_finalize(m_select_no_category);
-  sqlite3_finalize(m_select_ingredient);
-  sqlite3_finalize(m_select_no_ingredient);
+  sqlite3_finalize(m_match_ingredients);
+  sqlite3_finalize(m_ingredient_postings);
+  sqlite3_finalize(m_recipe_ingredient_ids);
+  sqlite3_finalize(m_delete_postings);
   sqlite3_finalize(m_delete_recipe);
   sqlite3_finalize(m_delete_categories);
   sqlite3_finalize(m_delete_ingredients);
   sqlite3_finalize(m_delete_instructions);
   sqlite3_finalize(m_delete_ingredient_sections);
   sqlite3_finalize(m_delete_instruction_sections);
-  sqlite3_finalize(m_delete_selection);
   sqlite3_finalize(m_rename_category);
   sqlite3_finalize(m_clean_categories);
   sqlite3_finalize(m_clean_ingredients);
-  sqlite3_finalize(m_select_recipe);
   sqlite3_finalize(m_remove_recipe_category);
   sqlite3_finalize(m_get_category_id);
   sqlite3_finalize(m_merge_category);
   sqlite3_finalize(m_delete_category);
   sqlite3_finalize(m_delete_recipe_category);
+  sqlite3_finalize(m_category_recipes);
   sqlite3_finalize(m_count_recipes_in_category);
+  sqlite3_finalize(m_check_category_counts);
+  sqlite3_finalize(m_rebuild_category_counts);
+  sqlite3_finalize(m_data_version);
+  sqlite3_finalize(m_count_facets);
+  sqlite3_finalize(m_category_name);
+  sqlite3_finalize(m_ingredient_name);
+  sqlite3_finalize(m_duplicates);
+  sqlite3_finalize(m_feature_ingredients);
   sqlite3_close(m_db);
 }
 
+struct SelectionTable {
+  sqlite3_vtab base;
+  Bitmap *bitmap;
+};
+
+struct SelectionCursor {
+  sqlite3_vtab_cursor base;
+  Bitmap::const_iterator current;
+  Bitmap::const_iterator end;
+  sqlite3_int64 id;
+  bool lookup;
+  bool eof;
+};
+
+static int selection_connect(sqlite3 *db, void *aux, int, const char *const *, sqlite3_vtab **vtab, char **) {
+  int result = sqlite3_declare_vtab(db, "CREATE TABLE x(id INTEGER)");
+  if (result == SQLITE_OK) {
+    SelectionTable *table = new SelectionTable;
+    memset(&table->base, 0, sizeof(sqlite3_vtab));
+    table->bitmap = (Bitmap *)aux;
+    *vtab = &table->base;
+  };
+  return result;
+}
+
+static int selection_disconnect(sqlite3_vtab *vtab) {
+  delete (SelectionTable *)vtab;
+  return SQLITE_OK;
+}
+
+static int selection_best_index(sqlite3_vtab *vtab, sqlite3_index_info *info) {
+  // Either look up a single id or iterate over all selected ids in ascending order.
+  for (int i=0; i<info->nConstraint; i++) {
+    const sqlite3_index_info::sqlite3_index_constraint &constraint = info->aConstraint[i];
+    if (constraint.usable && constraint.iColumn <= 0 && constraint.op == SQLITE_INDEX_CONSTRAINT_EQ) {
+      info->aConstraintUsage[i].argvIndex = 1;
+      info->aConstraintUsage[i].omit = 1;
+      info->idxNum = 1;
+      info->estimatedCost = 1.0;
+      info->estimatedRows = 1;
+      info->idxFlags = SQLITE_INDEX_SCAN_UNIQUE;
+      return SQLITE_OK;
+    };
+  };
+  sqlite3_int64 size = ((SelectionTable *)vtab)->bitmap->size();
+  info->idxNum = 0;
+  info->estimatedCost = size + 1;
+  info->estimatedRows = size;
+  if (info->nOrderBy == 1 && info->aOrderBy[0].iColumn <= 0 && !info->aOrderBy[0].desc)
+    info->orderByConsumed = 1;
+  return SQLITE_OK;
+}
+
+static int selection_open(sqlite3_vtab *, sqlite3_vtab_cursor **cursor) {
+  SelectionCursor *result = new SelectionCursor;
+  memset(&result->base, 0, sizeof(sqlite3_vtab_cursor));
+  result->id = 0;
+  result->lookup = false;
+  result->eof = true;
+  *cursor = &result->base;
+  return SQLITE_OK;
+}
+
+static int selection_close(sqlite3_vtab_cursor *cursor) {
+  delete (SelectionCursor *)cursor;
+  return SQLITE_OK;
+}
+
+static int selection_filter(sqlite3_vtab_cursor *cursor, int idx_num, const char *, int argc, sqlite3_value **argv) {
+  SelectionCursor *c = (SelectionCursor *)cursor;
+  Bitmap *bitmap = ((SelectionTable *)cursor->pVtab)->bitmap;
+  if (idx_num == 1) {
+    assert(argc == 1);
+    c->lookup = true;
+    c->id = sqlite3_value_int64(argv[0]);
+    c->eof = sqlite3_value_type(argv[0]) != SQLITE_INTEGER || !bitmap->contains(c->id);
+  } else {
+    c->lookup = false;
+    c->current = bitmap->begin();
+    c->end = bitmap->end();
+    c->eof = c->current == c->end;
+    if (!c->eof)
+      c->id = *c->current;
+  };
+  return SQLITE_OK;
+}
+
+static int selection_next(sqlite3_vtab_cursor *cursor) {
+  SelectionCursor *c = (SelectionCursor *)cursor;
+  if (c->lookup)
+    c->eof = true;
+  else {
+    ++c->current;
+    c->eof = c->current == c->end;
+    if (!c->eof)
+      c->id = *c->current;
+  };
+  return SQLITE_OK;
+}
+
+static int selection_eof(sqlite3_vtab_cursor *cursor) {
+  return ((SelectionCursor *)cursor)->eof;
+}
+
+static int selection_column(sqlite3_vtab_cursor *cursor, sqlite3_context *context, int) {
+  sqlite3_result_int64(context, ((SelectionCursor *)cursor)->id);
+  return SQLITE_OK;
+}
+
+static int selection_rowid(sqlite3_vtab_cursor *cursor, sqlite3_int64 *rowid) {
+  *rowid = ((SelectionCursor *)cursor)->id;
+  return SQLITE_OK;
+}
+
+// Read-only table exposing the selected recipe ids to SQL queries.
+static sqlite3_module make_selection_module(void) {
+  // Value-initialise the module because the number of fields depends on the version of SQLite.
+  sqlite3_module module = sqlite3_module();
+  module.xConnect = selection_connect;
+  module.xBestIndex = selection_best_index;
+  module.xDisconnect = selection_disconnect;
+  module.xDestroy = selection_disconnect;
+  module.xOpen = selection_open;
+  module.xClose = selection_close;
+  module.xFilter = selection_filter;
+  module.xNext = selection_next;
+  module.xEof = selection_eof;
+  module.xColumn = selection_column;
+  module.xRowid = selection_rowid;
+  return module;
+}
+
+static sqlite3_module selection_module = make_selection_module();
+
 void Database::check(int result, const char *prefix) {
   if (result != SQLITE_OK && result != SQLITE_DONE && result != SQLITE_ROW) {
     ostringstream s;
@@ -89,106 +382,163 @@ void Database::check(int result, const char *prefix) {
   };
 }
 
-void Database::open(const char *filename) {
+sqlite3_int64 Database::generation(void) {
+  // Commits of other connections change the data version.
+  int result = sqlite3_step(m_data_version);
+  check(result, "Error getting data version: ");
+  sqlite3_int64 data_version = sqlite3_column_int64(m_data_version, 0);
+  result = sqlite3_reset(m_data_version);
+  check(result, "Error resetting statement for getting data version: ");
+  if (data_version != m_last_data_version) {
+    m_last_data_version = data_version;
+    m_generation++;
+    // Reload the ingredient index when it is used next.
+    m_ingredient_index.clear();
+  };
+  return m_generation;
+}
+
+void Database::modified(void) {
+  m_generation++;
+}
+
+void Database::open(const char *filename, void (*progress)(int, int, void *), void *data) {
   int result;
   result = sqlite3_open(filename, &m_db);
   check(result, "Error opening database: ");
   pragmas();
-  migrate();
-  select_all();
+  migrate(progress, data);
+  result = sqlite3_create_module(m_db, "selection", &selection_module, &m_selection);
+  check(result, "Error registering selection table: ");
+  result = sqlite3_create_module(m_db, "facetids", &selection_module, &m_facet_ids);
+  check(result, "Error registering table for counting facets: ");
+  result = sqlite3_exec(m_db, "CREATE TEMP TABLE idlist(id INTEGER PRIMARY KEY);", NULL, NULL, NULL);
+  check(result, "Error creating temporary table for recipe ids: ");
   result = sqlite3_prepare_v2(m_db, "BEGIN;", -1, &m_begin, NULL);
   check(result, "Error preparing begin transaction statement: ");
   result = sqlite3_prepare_v2(m_db, "COMMIT;", -1, &m_commit, NULL);
   check(result, "Error preparing commit transaction statement: ");
   result = sqlite3_prepare_v2(m_db, "ROLLBACK;", -1, &m_rollback, NULL);
   check(result, "Error preparing rollback transaction statement: ");
-  result = sqlite3_prepare_v2(m_db, "INSERT INTO recipes VALUES(NULL, ?001, ?002, ?003);", -1, &m_insert_recipe, NULL);
+  result = sqlite3_prepare_v2(m_db, "INSERT INTO recipes(title, servings, servingsunit, contenthash) VALUES(?001, ?002, ?003, ?004);", -1, &m_insert_recipe, NULL);
   check(result, "Error preparing insert statement for recipes: ");
-  result = sqlite3_prepare_v2(m_db, "INSERT OR IGNORE INTO categories VALUES(NULL, ?001);", -1, &m_add_category, NULL);
+  result = sqlite3_prepare_v2(m_db, "INSERT OR IGNORE INTO categories(name) VALUES(?001);", -1, &m_add_category, NULL);
   check(result, "Error preparing statement for adding category: ");
-  result = sqlite3_prepare_v2(m_db, "INSERT OR IGNORE INTO category SELECT ?001, id FROM categories WHERE categories.name = ?002;",
-                              -1, &m_recipe_category, NULL);
+  result = sqlite3_prepare_v2(m_db, "INSERT INTO categories(name) VALUES(?001);", -1, &m_insert_category, NULL);
+  check(result, "Error preparing statement for inserting category: ");
+  result = sqlite3_prepare_v2(m_db, "INSERT OR IGNORE INTO category VALUES(?001, ?002);", -1, &m_recipe_category, NULL);
   check(result, "Error preparing statement for assigning recipe category: ");
-  result = sqlite3_prepare_v2(m_db, "INSERT OR IGNORE into ingredients VALUES(NULL, ?001);", -1, &m_add_ingredient, NULL);
+  result = sqlite3_prepare_v2(m_db, "SELECT id FROM ingredients WHERE name = ?001;", -1, &m_get_ingredient_id, NULL);
+  check(result, "Error preparing statement for getting ingredient id: ");
+  result = sqlite3_prepare_v2(m_db, "INSERT INTO ingredients VALUES(NULL, ?001);", -1, &m_insert_ingredient, NULL);
   check(result, "Error preparing statement for adding ingredient: ");
-  result = sqlite3_prepare_v2(m_db, "INSERT INTO ingredient SELECT ?001, ?002, ?003, ?004, ?005, ?006, ?007, ingredients.id "
-                                    "FROM ingredients WHERE ingredients.name = ?008;", -1, &m_recipe_ingredient, NULL);
+  result = sqlite3_prepare_v2(m_db, "INSERT INTO ingredient VALUES(?001, ?002, ?003, ?004, ?005, ?006, ?007, ?008);", -1,
+                              &m_recipe_ingredient, NULL);
   check(result, "Error preparing statement for adding ingredient to recipe: ");
-  result = sqlite3_prepare_v2(m_db, "SELECT title, servings, servingsunit FROM recipes WHERE id = ?001;", -1, &m_get_header,
-                              NULL);
-  check(result, "Error preparing statement for fetching recipe header: ");
-  result = sqlite3_prepare_v2(m_db, "SELECT name FROM categories, category WHERE recipeid = ?001 AND id = categoryid ORDER BY name;",
-                              -1, &m_get_categories, NULL);
-  check(result, "Error preparing statement for fetching recipe categories: ");
-  result = sqlite3_prepare_v2(m_db, "SELECT name, COUNT(recipeid) FROM categories LEFT JOIN category ON id = categoryid "
-                              "GROUP BY name ORDER BY name;",
+  result = sqlite3_prepare_v2(m_db, "SELECT name, recipecount FROM categories ORDER BY name;",
                               -1, &m_category_and_count_list, NULL);
   check(result, "Error preparing statement for fetching recipe categories and recipe counts: ");
-  result = sqlite3_prepare_v2(m_db, "SELECT amountint, amountnum, amountdenom, amountfloat, unit, name "
-                              "FROM ingredient, ingredients WHERE recipeid = ?001 AND ingredientid = ingredients.id ORDER BY line;",
-                              -1, &m_get_ingredients, NULL);
-  check(result, "Error preparing statement for fetching recipe ingredients: ");
   result = sqlite3_prepare_v2(m_db, "INSERT INTO instruction VALUES(?001, ?002, ?003);", -1, &m_add_instruction, NULL);
   check(result, "Error preparing statement for adding instruction to recipe: ");
-  result = sqlite3_prepare_v2(m_db, "SELECT txt FROM instruction WHERE recipeid = ?001 ORDER BY line;", -1, &m_get_instructions,
-                              NULL);
-  check(result, "Error preparing statement for fetching recipe instructions: ");
   result = sqlite3_prepare_v2(m_db, "INSERT INTO ingredientsection VALUES(?001, ?002, ?003);", -1, &m_add_ingredient_section,
                               NULL);
   check(result, "Error preparing statement for storing ingredient section: ");
-  result = sqlite3_prepare_v2(m_db, "SELECT line, title FROM ingredientsection WHERE recipeid = ?001 ORDER BY line;", -1,
-                              &m_get_ingredient_section, NULL);
-  check(result, "Error preparing statement for retrieving ingredient section: ");
   result = sqlite3_prepare_v2(m_db, "INSERT INTO instructionsection VALUES(?001, ?002, ?003);", -1, &m_add_instruction_section,
                               NULL);
   check(result, "Error preparing statement for storing instruction section: ");
-  result = sqlite3_prepare_v2(m_db, "SELECT line, title FROM instructionsection WHERE recipeid = ?001 ORDER BY line;", -1,
-                              &m_get_instruction_section, NULL);
-  check(result, "Error preparing statement for retrieving instruction section: ");
-  result = sqlite3_prepare_v2(m_db, "SELECT COUNT(id) FROM selection;", -1, &m_count_selected, NULL);
-  check(result, "Error preparing statement for counting recipes: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT data FROM recipecache WHERE recipeid = ?001;", -1, &m_get_cached, NULL);
+  check(result, "Error preparing statement for fetching cached recipe: ");
+  result = sqlite3_prepare_v2(m_db, "INSERT OR REPLACE INTO recipecache VALUES(?001, ?002);", -1, &m_add_cached, NULL);
+  check(result, "Error preparing statement for caching recipe: ");
+  result = sqlite3_prepare_v2(m_db, "DELETE FROM recipecache WHERE recipeid IN (SELECT id FROM idlist);", -1,
+                              &m_delete_cached, NULL);
+  check(result, "Error preparing statement for deleting cached recipes: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipes.id, data FROM idlist JOIN recipes ON recipes.id = idlist.id "
+                              "LEFT JOIN recipecache ON recipecache.recipeid = recipes.id ORDER BY recipes.id;", -1,
+                              &m_fetch_cached, NULL);
+  check(result, "Error preparing statement for fetching cached recipes: ");
+  result = sqlite3_prepare_v2(m_db, "DELETE FROM idlist;", -1, &m_clear_ids, NULL);
+  check(result, "Error preparing statement for clearing recipe ids: ");
+  result = sqlite3_prepare_v2(m_db, "INSERT OR IGNORE INTO idlist VALUES(?001);", -1, &m_add_id, NULL);
+  check(result, "Error preparing statement for adding recipe id: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipes.id, title, servings, servingsunit FROM idlist, recipes "
+                              "WHERE recipes.id = idlist.id ORDER BY idlist.id;", -1, &m_fetch_headers, NULL);
+  check(result, "Error preparing statement for fetching recipe headers: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipeid, name FROM idlist, category, categories WHERE recipeid = idlist.id "
+                              "AND categories.id = categoryid ORDER BY recipeid;", -1, &m_fetch_categories, NULL);
+  check(result, "Error preparing statement for fetching categories of recipes: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipeid, amountint, amountnum, amountdenom, amountfloat, unit, name "
+                              "FROM idlist, ingredient, ingredients WHERE recipeid = idlist.id AND ingredientid = ingredients.id "
+                              "ORDER BY recipeid, line;", -1, &m_fetch_ingredients, NULL);
+  check(result, "Error preparing statement for fetching ingredients of recipes: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipeid, line, title FROM idlist, ingredientsection WHERE recipeid = idlist.id "
+                              "ORDER BY recipeid, line;", -1, &m_fetch_ingredient_sections, NULL);
+  check(result, "Error preparing statement for fetching ingredient sections of recipes: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipeid, txt FROM idlist, instruction WHERE recipeid = idlist.id "
+                              "ORDER BY recipeid, line;", -1, &m_fetch_instructions, NULL);
+  check(result, "Error preparing statement for fetching instructions of recipes: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipeid, line, title FROM idlist, instructionsection WHERE recipeid = idlist.id "
+                              "ORDER BY recipeid, line;", -1, &m_fetch_instruction_sections, NULL);
+  check(result, "Error preparing statement for fetching instruction sections of recipes: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT id FROM recipes;", -1, &m_all_recipes, NULL);
+  check(result, "Error preparing statement for selecting all recipes: ");
   result = sqlite3_prepare_v2(m_db, "SELECT selection.id, title from selection, recipes WHERE recipes.id = selection.id "
                               "ORDER BY title COLLATE NOCASE;", -1, &m_get_info, NULL);
   check(result, "Error preparing statement for retrieving recipe info: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM selection WHERE id NOT IN (SELECT selection.id FROM selection, recipes WHERE "
-                              "selection.id = recipes.id AND title LIKE '%' || ?001 || '%');", -1, &m_select_title, NULL);
+  result = sqlite3_prepare_v2(m_db, "SELECT recipes.id, title FROM recipes CROSS JOIN selection ON selection.id = recipes.id "
+                              "WHERE title COLLATE NOCASE >= ?001 AND (title COLLATE NOCASE > ?001 OR recipes.id > ?002) "
+                              "ORDER BY title COLLATE NOCASE, recipes.id LIMIT ?003;", -1, &m_get_info_page, NULL);
+  check(result, "Error preparing statement for retrieving page of recipe info: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT rowid FROM titletext WHERE " TITLE_MATCH("?001") ";", -1, &m_select_title, NULL);
   check(result, "Error preparing statement for selecting by title: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT rowid FROM recipetext WHERE recipetext MATCH ?001;", -1, &m_select_text, NULL);
+  check(result, "Error preparing statement for selecting by text: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipes.id, recipes.title FROM recipetext, selection, recipes WHERE recipetext MATCH ?001 "
+                              "AND selection.id = recipetext.rowid AND recipes.id = recipetext.rowid "
+                              "ORDER BY bm25(recipetext, 10.0, 1.0) LIMIT ?002;", -1, &m_search_text, NULL);
+  check(result, "Error preparing statement for searching recipes: ");
+  result = sqlite3_prepare_v2(m_db, "INSERT INTO recipetext(rowid, title, instructions) " RECIPE_TEXT " WHERE id = ?001;", -1,
+                              &m_add_text, NULL);
+  check(result, "Error preparing statement for indexing recipe text: ");
+  result = sqlite3_prepare_v2(m_db, "INSERT INTO recipetext(recipetext, rowid, title, instructions) SELECT 'delete', * FROM ("
+                              RECIPE_TEXT " WHERE id IN (SELECT id FROM idlist));", -1, &m_delete_text, NULL);
+  check(result, "Error preparing statement for removing recipe text from index: ");
   result = sqlite3_prepare_v2(m_db, "SELECT name FROM categories, category, selection WHERE categories.id = categoryid AND "
                               "selection.id = recipeid GROUP BY categories.id ORDER BY COUNT(recipeid) DESC, name ASC;", -1,
                               &m_category_list, NULL);
   check(result, "Error preparing statement for listing categories: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM selection WHERE id NOT IN (SELECT selection.id FROM selection, category, categories "
-                              "WHERE selection.id = recipeid AND categoryid = categories.id AND name LIKE ?001 || '%');", -1,
-                              &m_select_category, NULL);
+  result = sqlite3_prepare_v2(m_db, "SELECT recipeid FROM category, categories WHERE categoryid = categories.id AND "
+                              "name LIKE ?001 || '%';", -1, &m_select_category, NULL);
   check(result, "Error preparing statement for selecting by category: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM selection WHERE id IN (SELECT selection.id FROM selection, category, categories "
-                              "WHERE selection.id = recipeid AND categoryid = categories.id AND name LIKE ?001 || '%');", -1,
-                              &m_select_no_category, NULL);
-  check(result, "Error preparing statement for excluding category: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM selection WHERE id NOT IN (SELECT selection.id FROM selection, ingredient, "
-                              "ingredients WHERE selection.id = recipeid AND ingredientid = ingredients.id AND "
-                              "name LIKE '%' || ?001 || '%');", -1, &m_select_ingredient, NULL);
-  check(result, "Error preparing statement for selecting by ingredient: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM selection WHERE id IN (SELECT selection.id FROM selection, ingredient, "
-                              "ingredients WHERE selection.id = recipeid AND ingredientid = ingredients.id AND "
-                              "name LIKE '%' || ?001 || '%');", -1, &m_select_no_ingredient, NULL);
-  check(result, "Error preparing statement for selecting by not having ingredient: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM recipes WHERE id = ?001;", -1, &m_delete_recipe, NULL);
-  check(result, "Error preparing statement for deleting recipe: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM category WHERE recipeid = ?001;", -1, &m_delete_categories, NULL);
-  check(result, "Error preparing statement for deleting category: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM ingredient WHERE recipeid = ?001;", -1, &m_delete_ingredients, NULL);
+  result = sqlite3_prepare_v2(m_db, "SELECT rowid FROM ingredienttext WHERE name LIKE '%' || ?001 || '%';", -1,
+                              &m_match_ingredients, NULL);
+  check(result, "Error preparing statement for matching ingredients: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT ingredientid, recipeid FROM ingredient ORDER BY recipeid;", -1,
+                              &m_ingredient_postings, NULL);
+  check(result, "Error preparing statement for loading ingredient index: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT ingredientid FROM ingredient WHERE recipeid = ?001;", -1,
+                              &m_recipe_ingredient_ids, NULL);
+  check(result, "Error preparing statement for getting ingredients of recipe: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT ingredientid, recipeid FROM idlist, ingredient WHERE recipeid = idlist.id;", -1,
+                              &m_delete_postings, NULL);
+  check(result, "Error preparing statement for getting ingredients of recipes: ");
+  result = sqlite3_prepare_v2(m_db, "DELETE FROM recipes WHERE id IN (SELECT id FROM idlist);", -1, &m_delete_recipe, NULL);
+  check(result, "Error preparing statement for deleting recipes: ");
+  result = sqlite3_prepare_v2(m_db, "DELETE FROM category WHERE recipeid IN (SELECT id FROM idlist);", -1,
+                              &m_delete_categories, NULL);
+  check(result, "Error preparing statement for deleting categories: ");
+  result = sqlite3_prepare_v2(m_db, "DELETE FROM ingredient WHERE recipeid IN (SELECT id FROM idlist);", -1,
+                              &m_delete_ingredients, NULL);
   check(result, "Error preparing statement for deleting ingredients: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM instruction WHERE recipeid = ?001;", -1, &m_delete_instructions, NULL);
+  result = sqlite3_prepare_v2(m_db, "DELETE FROM instruction WHERE recipeid IN (SELECT id FROM idlist);", -1,
+                              &m_delete_instructions, NULL);
   check(result, "Error preparing statement for deleting instructions: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM ingredientsection WHERE recipeid = ?001;", -1, &m_delete_ingredient_sections,
-                              NULL);
+  result = sqlite3_prepare_v2(m_db, "DELETE FROM ingredientsection WHERE recipeid IN (SELECT id FROM idlist);", -1,
+                              &m_delete_ingredient_sections, NULL);
   check(result, "Error preparing statement for deleting ingredient sections: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM instructionsection WHERE recipeid = ?001;", -1, &m_delete_instruction_sections,
-                              NULL);
+  result = sqlite3_prepare_v2(m_db, "DELETE FROM instructionsection WHERE recipeid IN (SELECT id FROM idlist);", -1,
+                              &m_delete_instruction_sections, NULL);
   check(result, "Error preparing statement for deleting instruction sections: ");
-  result = sqlite3_prepare_v2(m_db, "DELETE FROM selection WHERE id = ?001;", -1, &m_delete_selection, NULL);
-  check(result, "Error preparing statement for deleting recipe from selection: ");
   result = sqlite3_prepare_v2(m_db, "UPDATE categories SET name = ?002 WHERE name = ?001;", -1, &m_rename_category, NULL);
   check(result, "Error preparing statement for renaming category: ");
   result = sqlite3_prepare_v2(m_db, "SELECT id FROM categories WHERE name = ?001;", -1, &m_get_category_id, NULL);
@@ -199,20 +549,51 @@ void Database::open(const char *filename) {
   check(result, "Error preparing statement for deleting category: ");
   result = sqlite3_prepare_v2(m_db, "DELETE FROM category WHERE categoryid = ?001;", -1, &m_delete_recipe_category, NULL);
   check(result, "Error preparing statement for deleting recipe category: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipeid FROM category WHERE categoryid = ?001 ORDER BY recipeid;", -1,
+                              &m_category_recipes, NULL);
+  check(result, "Error preparing statement for listing recipes of category: ");
   result = sqlite3_prepare_v2(m_db, "DELETE FROM categories WHERE id NOT IN (SELECT categoryid FROM category);", -1,
                               &m_clean_categories, NULL);
   check(result, "Error preparing statement for cleaning categories: ");
   result = sqlite3_prepare_v2(m_db, "DELETE FROM ingredients WHERE id NOT IN (SELECT ingredientid FROM ingredient);", -1,
                               &m_clean_ingredients, NULL);
   check(result, "Error preparing statement for cleaning ingredients: ");
-  result = sqlite3_prepare_v2(m_db, "INSERT INTO selection VALUES(?001);", -1, &m_select_recipe, NULL);
-  check(result, "Error preparing statement for selecting recipe: ");
   result = sqlite3_prepare_v2(m_db, "DELETE FROM category WHERE recipeid = ?001 AND categoryid IN (SELECT id FROM categories "
                               "WHERE name = ?002);", -1, &m_remove_recipe_category, NULL);
   check(result, "Error preparing statement for removing category from recipe: ");
-  result = sqlite3_prepare_v2(m_db, "SELECT COUNT(recipeid) FROM category, categories WHERE categoryid = id AND name = ?001",
-                              -1, &m_count_recipes_in_category, NULL);
-  check(result, "Error preparing statement for removing category from recipe: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipecount FROM categories WHERE name = ?001;", -1,
+                              &m_count_recipes_in_category, NULL);
+  check(result, "Error preparing statement for counting recipes in category: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT COUNT(*) FROM categories WHERE recipecount != "
+                              "(SELECT COUNT(*) FROM category WHERE categoryid = categories.id);", -1,
+                              &m_check_category_counts, NULL);
+  check(result, "Error preparing statement for checking recipe counts of categories: ");
+  result = sqlite3_prepare_v2(m_db, "UPDATE categories SET recipecount = "
+                              "(SELECT COUNT(*) FROM category WHERE categoryid = categories.id);", -1,
+                              &m_rebuild_category_counts, NULL);
+  check(result, "Error preparing statement for rebuilding recipe counts of categories: ");
+  result = sqlite3_prepare_v2(m_db, "PRAGMA data_version;", -1, &m_data_version, NULL);
+  check(result, "Error preparing statement for getting data version: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT 0, recipeid, categoryid FROM facetids CROSS JOIN category "
+                              "ON category.recipeid = facetids.id UNION ALL "
+                              "SELECT 1, recipeid, ingredientid FROM facetids CROSS JOIN ingredient "
+                              "ON ingredient.recipeid = facetids.id;", -1, &m_count_facets, NULL);
+  check(result, "Error preparing statement for counting facets: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT name FROM categories WHERE id = ?001;", -1, &m_category_name, NULL);
+  check(result, "Error preparing statement for getting category name: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT name FROM ingredients WHERE id = ?001;", -1, &m_ingredient_name, NULL);
+  check(result, "Error preparing statement for getting ingredient name: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT id FROM (SELECT recipes.id AS id, ROW_NUMBER() OVER (PARTITION BY contenthash, "
+                              "(SELECT group_concat(categoryid) FROM (SELECT categoryid FROM category WHERE recipeid = recipes.id "
+                              "ORDER BY categoryid)) ORDER BY recipes.id) AS n "
+                              "FROM idlist CROSS JOIN recipes ON recipes.id = idlist.id WHERE contenthash IN "
+                              "(SELECT contenthash FROM idlist CROSS JOIN recipes ON recipes.id = idlist.id "
+                              "GROUP BY contenthash HAVING COUNT(*) > 1)) WHERE n > 1 ORDER BY id;", -1, &m_duplicates, NULL);
+  check(result, "Error preparing statement for finding duplicate recipes: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT recipeid, ingredientid FROM idlist CROSS JOIN ingredient "
+                              "ON ingredient.recipeid = idlist.id;", -1, &m_feature_ingredients, NULL);
+  check(result, "Error preparing statement for getting ingredients of recipes: ");
+  select_all();
 }
 
 int Database::user_version(void) {
@@ -230,8 +611,14 @@ int Database::user_version(void) {
 void Database::pragmas(void) {
   int result = sqlite3_exec(m_db, "PRAGMA foreign_keys = ON;", NULL, NULL, NULL);
   check(result, "Error enabling checks for foreign keys: ");
+  // Replacing rows when merging categories has to update the recipe counts.
+  result = sqlite3_exec(m_db, "PRAGMA recursive_triggers = ON;", NULL, NULL, NULL);
+  check(result, "Error enabling recursive triggers: ");
   result = sqlite3_exec(m_db, "PRAGMA cache_size = -256000;", NULL, NULL, NULL);
   check(result, "Error setting cache size: ");
+  // Wait for other connections instead of failing immediately.
+  result = sqlite3_busy_timeout(m_db, BUSY_TIMEOUT);
+  check(result, "Error setting busy timeout: ");
 }
 
 void Database::create(void) {
@@ -259,18 +646,138 @@ void Database::create(void) {
   check(result, "Error creating database tables: ");
 }
 
-void Database::migrate(void) {
+void Database::upgrade(const Migration &migration) {
+  ostringstream prefix;
+  prefix << "Error upgrading database to version " << migration.version << ": ";
+  int result = sqlite3_exec(m_db, "BEGIN;", NULL, NULL, NULL);
+  check(result, prefix.str().c_str());
+  try {
+    result = sqlite3_exec(m_db, migration.sql, NULL, NULL, NULL);
+    check(result, prefix.str().c_str());
+    // Fill in data which cannot be computed in SQL.
+    if (migration.fill)
+      (this->*migration.fill)();
+    ostringstream sql;
+    sql << "PRAGMA user_version = " << migration.version << ";\nCOMMIT;\n";
+    result = sqlite3_exec(m_db, sql.str().c_str(), NULL, NULL, NULL);
+    check(result, prefix.str().c_str());
+  } catch (database_exception &e) {
+    sqlite3_exec(m_db, "ROLLBACK;", NULL, NULL, NULL);
+    throw;
+  };
+}
+
+void Database::fill_cache(void) {
+  sqlite3_stmt *recipes;
+  sqlite3_stmt *cache;
+  int result = sqlite3_prepare_v2(m_db, "SELECT id FROM recipes ORDER BY id;", -1, &recipes, NULL);
+  check(result, "Error preparing statement for listing recipes: ");
+  vector<sqlite3_int64> ids = query_list(recipes, 0, NULL);
+  sqlite3_finalize(recipes);
+  result = sqlite3_prepare_v2(m_db, "INSERT INTO recipecache VALUES(?001, ?002);", -1, &cache, NULL);
+  check(result, "Error preparing statement for caching recipe: ");
+  for (vector<sqlite3_int64>::iterator id=ids.begin(); id!=ids.end(); id++) {
+    Recipe recipe = assemble_recipe(*id);
+    string data = encode_recipe(recipe);
+    result = sqlite3_bind_int64(cache, 1, *id);
+    check(result, "Error binding recipe id for cache: ");
+    result = sqlite3_bind_blob(cache, 2, data.data(), data.size(), SQLITE_STATIC);
+    check(result, "Error binding encoded recipe: ");
+    result = sqlite3_step(cache);
+    check(result, "Error caching recipe: ");
+    result = sqlite3_reset(cache);
+    check(result, "Error resetting statement for caching recipe: ");
+  };
+  sqlite3_finalize(cache);
+}
+
+void Database::prepare_recipe_queries(void) {
+  // Only uses tables of the initial schema so that migrations can assemble recipes.
+  int result;
+  result = sqlite3_prepare_v2(m_db, "SELECT title, servings, servingsunit FROM recipes WHERE id = ?001;", -1, &m_get_header,
+                              NULL);
+  check(result, "Error preparing statement for fetching recipe header: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT name FROM categories, category WHERE recipeid = ?001 AND id = categoryid ORDER BY name;",
+                              -1, &m_get_categories, NULL);
+  check(result, "Error preparing statement for fetching recipe categories: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT amountint, amountnum, amountdenom, amountfloat, unit, name "
+                              "FROM ingredient, ingredients WHERE recipeid = ?001 AND ingredientid = ingredients.id ORDER BY line;",
+                              -1, &m_get_ingredients, NULL);
+  check(result, "Error preparing statement for fetching recipe ingredients: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT txt FROM instruction WHERE recipeid = ?001 ORDER BY line;", -1, &m_get_instructions,
+                              NULL);
+  check(result, "Error preparing statement for fetching recipe instructions: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT line, title FROM ingredientsection WHERE recipeid = ?001 ORDER BY line;", -1,
+                              &m_get_ingredient_section, NULL);
+  check(result, "Error preparing statement for retrieving ingredient section: ");
+  result = sqlite3_prepare_v2(m_db, "SELECT line, title FROM instructionsection WHERE recipeid = ?001 ORDER BY line;", -1,
+                              &m_get_instruction_section, NULL);
+  check(result, "Error preparing statement for retrieving instruction section: ");
+}
+
+void Database::hash_recipes(void) {
+  sqlite3_stmt *recipes;
+  sqlite3_stmt *hash;
+  int result = sqlite3_prepare_v2(m_db, "SELECT id FROM recipes ORDER BY id;", -1, &recipes, NULL);
+  check(result, "Error preparing statement for listing recipes: ");
+  vector<sqlite3_int64> ids = query_list(recipes, 0, NULL);
+  sqlite3_finalize(recipes);
+  result = sqlite3_prepare_v2(m_db, "UPDATE recipes SET contenthash = ?002 WHERE id = ?001;", -1, &hash, NULL);
+  check(result, "Error preparing statement for setting content hash: ");
+  for (vector<sqlite3_int64>::iterator id=ids.begin(); id!=ids.end(); id++) {
+    result = sqlite3_bind_int64(hash, 1, *id);
+    check(result, "Error binding recipe id: ");
+    Recipe recipe = assemble_recipe(*id);
+    result = sqlite3_bind_int64(hash, 2, (sqlite3_int64)hash_recipe(recipe));
+    check(result, "Error binding content hash: ");
+    result = sqlite3_step(hash);
+    check(result, "Error setting content hash: ");
+    result = sqlite3_reset(hash);
+    check(result, "Error resetting statement for setting content hash: ");
+  };
+  sqlite3_finalize(hash);
+}
+
+void Database::migrate(void (*progress)(int, int, void *), void *data) {
   int version = user_version();
-  if (version <= 0)
+  if (version <= 0) {
     create();
-  if (version > 1) {
+    version = 1;
+  };
+  if (version > SCHEMA_VERSION) {
     ostringstream s;
     s << "Database version " << version << " was created by more recent release of software.";
     throw database_exception(s.str());
   };
+  prepare_recipe_queries();
+  // Apply each migration in its own transaction.
+  int steps = SCHEMA_VERSION - version;
+  int step = 0;
+  for (unsigned int i=0; i<sizeof(migrations) / sizeof(Migration); i++) {
+    if (migrations[i].version <= version)
+      continue;
+    if (progress)
+      progress(step, steps, data);
+    upgrade(migrations[i]);
+    step++;
+  };
+  if (progress && steps > 0)
+    progress(steps, steps, data);
+}
+
+void Database::interrupt(void) {
+  // This is the only method which may be called from another thread.
+  if (m_db)
+    sqlite3_interrupt(m_db);
+}
+
+void Database::set_progress_handler(int (*handler)(void *), void *data) {
+  sqlite3_progress_handler(m_db, PROGRESS_INSTRUCTIONS, handler, data);
 }
 
 void Database::begin(void) {
+  m_inserted.clear();
+  m_removed.clear();
   int result = sqlite3_step(m_begin);
   check(result, "Error beginning transaction: ");
   result = sqlite3_reset(m_begin);
@@ -282,6 +789,8 @@ void Database::commit(void) {
   check(result, "Error committing transaction: ");
   result = sqlite3_reset(m_commit);
   check(result, "Error resetting commit transaction statement: ");
+  m_inserted.clear();
+  m_removed.clear();
 }
 
 void Database::rollback(void) {
@@ -289,6 +798,15 @@ void Database::rollback(void) {
   check(result, "Error rolling back transaction: ");
   result = sqlite3_reset(m_rollback);
   check(result, "Error resetting rollback transaction statement: ");
+  m_selection |= m_removed;
+  m_selection -= m_inserted;
+  m_chain.clear();
+  modified();
+  m_inserted.clear();
+  m_removed.clear();
+  m_ingredient_index.clear();
+  m_category_ids.clear();
+  m_ingredient_ids.clear();
 }
 
 void Database::add_category(const char *name) {
@@ -315,6 +833,8 @@ sqlite3_int64 Database::insert_recipe(Recipe &recipe) {
   string servings_unit = recipe.servings_unit();
   result = sqlite3_bind_text(m_insert_recipe, 3, recipe.servings_unit_c_str(), -1, SQLITE_STATIC);
   check(result, "Error binding recipe servings unit: ");
+  result = sqlite3_bind_int64(m_insert_recipe, 4, (sqlite3_int64)hash_recipe(recipe));
+  check(result, "Error binding content hash: ");
   result = sqlite3_step(m_insert_recipe);
   check(result, "Error executing insert statement: ");
   result = sqlite3_reset(m_insert_recipe);
@@ -323,13 +843,10 @@ sqlite3_int64 Database::insert_recipe(Recipe &recipe) {
   sqlite3_int64 recipe_id = sqlite3_last_insert_rowid(m_db);
   // Add categories.
   for (set<string>::iterator category=recipe.categories().begin(); category!=recipe.categories().end(); category++) {
-    // Create category.
-    add_category(category->c_str());
-    // Add recipe to category.
     result = sqlite3_bind_int64(m_recipe_category, 1, recipe_id);
     check(result, "Error binding recipe id: ");
-    result = sqlite3_bind_text(m_recipe_category, 2, category->c_str(), -1, SQLITE_STATIC);
-    check(result, "Error binding category name: ");
+    result = sqlite3_bind_int64(m_recipe_category, 2, category_id(*category));
+    check(result, "Error binding category id: ");
     result = sqlite3_step(m_recipe_category);
     check(result, "Error adding recipe category: ");
     result = sqlite3_reset(m_recipe_category);
@@ -338,13 +855,6 @@ sqlite3_int64 Database::insert_recipe(Recipe &recipe) {
   // Add ingredients.
   c = 1;
   for (vector<Ingredient>::iterator ingredient=recipe.ingredients().begin(); ingredient!=recipe.ingredients().end(); ingredient++) {
-    // Create ingredient.
-    result = sqlite3_bind_text(m_add_ingredient, 1, ingredient->text_c_str(), -1, SQLITE_STATIC);
-    check(result, "Error binding ingredient: ");
-    result = sqlite3_step(m_add_ingredient);
-    check(result, "Error adding ingredient: ");
-    result = sqlite3_reset(m_add_ingredient);
-    check(result, "Error resetting ingredient adding statement: ");
     // Add ingredient to recipe.
     result = sqlite3_bind_int64(m_recipe_ingredient, 1, recipe_id);
     check(result, "Error binding recipe id: ");
@@ -361,14 +871,19 @@ sqlite3_int64 Database::insert_recipe(Recipe &recipe) {
     string unit = ingredient->unit();
     result = sqlite3_bind_text(m_recipe_ingredient, 7, ingredient->unit_c_str(), -1, SQLITE_STATIC);
     check(result, "Error binding ingredient unit: ");
-    string text = ingredient->text();
-    result = sqlite3_bind_text(m_recipe_ingredient, 8, ingredient->text_c_str(), -1, SQLITE_STATIC);
-    check(result, "Error binding ingredient search text: ");
+    result = sqlite3_bind_int64(m_recipe_ingredient, 8, ingredient_id(ingredient->text()));
+    check(result, "Error binding ingredient id: ");
     result = sqlite3_step(m_recipe_ingredient);
     check(result, "Error adding ingredient to recipe: ");
     result = sqlite3_reset(m_recipe_ingredient);
     check(result, "Error resetting statement adding ingredient to recipe: ");
   };
+  // Update ingredient index.
+  if (m_ingredient_index.loaded()) {
+    vector<sqlite3_int64> ingredient_ids = query_list(m_recipe_ingredient_ids, recipe_id, NULL);
+    for (vector<sqlite3_int64>::iterator ingredient_id=ingredient_ids.begin(); ingredient_id!=ingredient_ids.end(); ingredient_id++)
+      m_ingredient_index.add(*ingredient_id, recipe_id);
+  };
   // Add ingredient sections.
   for (vector<pair<int, string> >::iterator section=recipe.ingredient_sections().begin(); section!=recipe.ingredient_sections().end(); section++) {
     result = sqlite3_bind_int64(m_add_ingredient_section, 1, recipe_id);
@@ -409,23 +924,25 @@ sqlite3_int64 Database::insert_recipe(Recipe &recipe) {
     result = sqlite3_reset(m_add_instruction_section);
     check(result, "Error resetting instruction section statement: ");
   };
+  // Add title and instructions to full-text index.
+  result = sqlite3_bind_int64(m_add_text, 1, recipe_id);
+  check(result, "Error binding recipe id for full-text index: ");
+  result = sqlite3_step(m_add_text);
+  check(result, "Error adding recipe to full-text index: ");
+  result = sqlite3_reset(m_add_text);
+  check(result, "Error resetting statement for adding recipe to full-text index: ");
+  // Add encoded recipe to cache.
+  cache_recipe(recipe_id, recipe);
   // Add to selection.
-  result = sqlite3_bind_int64(m_select_recipe, 1, recipe_id);
-  check(result, "Error binding id for selecting recipe: ");
-  result = sqlite3_step(m_select_recipe);
-  check(result, "Error selecting recipe: ");
-  result = sqlite3_reset(m_select_recipe);
-  check(result, "Error resetting statement for selecting recipe: ");
+  m_selection.add(recipe_id);
+  m_chain.clear();
+  modified();
+  m_inserted.add(recipe_id);
   return recipe_id;
 }
 
 int Database::num_recipes(void) {
-  int result = sqlite3_step(m_count_selected);
-  check(result, "Error counting recipes: ");
-  int count = sqlite3_column_int(m_count_selected, 0);
-  result = sqlite3_reset(m_count_selected);
-  check(result, "Error resetting statement for counting recipes: ");
-  return count;
+  return m_selection.size();
 }
 
 int Database::count_recipes(const char *category) {
@@ -433,7 +950,7 @@ int Database::count_recipes(const char *category) {
   check(result, "Error binding category string: ");
   result = sqlite3_step(m_count_recipes_in_category);
   check(result, "Error counting recipes in category: ");
-  int count = sqlite3_column_int(m_count_recipes_in_category, 0);
+  int count = result == SQLITE_ROW ? sqlite3_column_int(m_count_recipes_in_category, 0) : 0;
   result = sqlite3_reset(m_count_recipes_in_category);
   check(result, "Error resetting statement for counting recipes in category: ");
   return count;
@@ -455,6 +972,26 @@ vector<pair<sqlite3_int64, string> > Database::recipe_info(void) {
   return infos;
 }
 
+void Database::recipe_info_page(const char *title, sqlite3_int64 id, int limit, TitleArena &page) {
+  // Continue after the given title and id using the title index.
+  int result = sqlite3_bind_text(m_get_info_page, 1, title, -1, SQLITE_STATIC);
+  check(result, "Error binding title of previous page: ");
+  result = sqlite3_bind_int64(m_get_info_page, 2, id);
+  check(result, "Error binding recipe id of previous page: ");
+  result = sqlite3_bind_int(m_get_info_page, 3, limit);
+  check(result, "Error binding page size: ");
+  while (true) {
+    result = sqlite3_step(m_get_info_page);
+    check(result, "Error getting page of recipe information: ");
+    if (result != SQLITE_ROW)
+      break;
+    const char *text = (const char *)sqlite3_column_text(m_get_info_page, 1);
+    page.push_back(sqlite3_column_int64(m_get_info_page, 0), text, sqlite3_column_bytes(m_get_info_page, 1));
+  };
+  result = sqlite3_reset(m_get_info_page);
+  check(result, "Error resetting statement for getting page of recipe info: ");
+}
+
 vector<string> Database::categories(void) {
   int result;
   vector<string> categories;
@@ -486,67 +1023,355 @@ vector<pair<string, int> > Database::categories_and_counts(void) {
   return categories_and_counts;
 }
 
+void Database::count_facets(const Bitmap &ids, int delta, Facets &facets) {
+  int result;
+  m_facet_ids = ids;
+  // Recipes can list an ingredient more than once. The rows of each recipe are consecutive.
+  sqlite3_int64 recipe = 0;
+  vector<sqlite3_int64> seen;
+  while (true) {
+    result = sqlite3_step(m_count_facets);
+    if (result != SQLITE_ROW)
+      break;
+    sqlite3_int64 recipe_id = sqlite3_column_int64(m_count_facets, 1);
+    sqlite3_int64 id = sqlite3_column_int64(m_count_facets, 2);
+    if (sqlite3_column_int(m_count_facets, 0) == 0)
+      facets.count_category(id, delta);
+    else {
+      if (recipe_id != recipe) {
+        recipe = recipe_id;
+        seen.clear();
+      };
+      if (find(seen.begin(), seen.end(), id) == seen.end()) {
+        seen.push_back(id);
+        facets.count_ingredient(id, delta);
+      };
+    };
+  };
+  m_facet_ids.clear();
+  if (result != SQLITE_DONE) {
+    // Discard the partial counts.
+    facets.clear();
+    sqlite3_reset(m_count_facets);
+    check(result, "Error counting facets: ");
+  };
+  result = sqlite3_reset(m_count_facets);
+  check(result, "Error resetting statement for counting facets: ");
+}
+
+void Database::count_facets(Facets &facets) {
+  // Only count the dropped recipes if the selection was narrowed down and the database did not change.
+  sqlite3_int64 current = generation();
+  Bitmap dropped = facets.ids() - m_selection;
+  if (facets.generation() == current && (m_selection - facets.ids()).empty() && dropped.size() < m_selection.size())
+    count_facets(dropped, -1, facets);
+  else {
+    facets.clear();
+    count_facets(m_selection, 1, facets);
+  };
+  facets.update(m_selection, current);
+}
+
+string Database::facet_name(sqlite3_stmt *statement, sqlite3_int64 id) {
+  int result;
+  string name;
+  result = sqlite3_bind_int64(statement, 1, id);
+  check(result, "Error binding facet id: ");
+  result = sqlite3_step(statement);
+  check(result, "Error getting facet name: ");
+  if (result == SQLITE_ROW)
+    name = (const char *)sqlite3_column_text(statement, 0);
+  result = sqlite3_reset(statement);
+  check(result, "Error resetting statement for getting facet name: ");
+  return name;
+}
+
+static bool more_recipes(const pair<string, int> &a, const pair<string, int> &b) {
+  if (a.second != b.second)
+    return a.second > b.second;
+  return a.first < b.first;
+}
+
+vector<pair<string, int> > Database::category_facets(const Facets &facets) {
+  vector<pair<sqlite3_int64, int> > counts = facets.categories();
+  vector<pair<string, int> > result;
+  for (vector<pair<sqlite3_int64, int> >::iterator count=counts.begin(); count!=counts.end(); count++)
+    result.push_back(make_pair(facet_name(m_category_name, count->first), count->second));
+  // Sort categories with the same number of recipes by name.
+  sort(result.begin(), result.end(), more_recipes);
+  return result;
+}
+
+vector<pair<string, int> > Database::ingredient_facets(const Facets &facets, size_t limit) {
+  vector<pair<sqlite3_int64, int> > counts = facets.ingredients(limit);
+  vector<pair<string, int> > result;
+  for (vector<pair<sqlite3_int64, int> >::iterator count=counts.begin(); count!=counts.end(); count++)
+    result.push_back(make_pair(facet_name(m_ingredient_name, count->first), count->second));
+  return result;
+}
+
 void Database::select_all(void) {
+  m_chain = "*";
+  sqlite3_int64 current = generation();
+  if (!m_filter_cache.find(m_chain, current, m_selection)) {
+    m_selection = query_ids(m_all_recipes, NULL);
+    m_filter_cache.insert(m_chain, current, m_selection);
+  };
+}
+
+Bitmap Database::query_ids(sqlite3_stmt *statement, const char *text) {
   int result;
-  result = sqlite3_exec(m_db, "DROP TABLE IF EXISTS selection;", NULL, NULL, NULL);
-  check(result, "Error dropping selection table: ");
-  result = sqlite3_exec(m_db, "CREATE TEMPORARY TABLE selection(id INTEGER PRIMARY KEY);", NULL, NULL, NULL);
-  check(result, "Error creating selection table: ");
-  result = sqlite3_exec(m_db, "INSERT INTO selection SELECT id FROM recipes;", NULL, NULL, NULL);
-  check(result, "Error selecting recipes: ");
+  Bitmap ids;
+  if (text) {
+    result = sqlite3_bind_text(statement, 1, text, -1, SQLITE_STATIC);
+    check(result, "Error binding search string: ");
+  };
+  while (true) {
+    result = sqlite3_step(statement);
+    check(result, "Error filtering recipes: ");
+    if (result != SQLITE_ROW)
+      break;
+    ids.add(sqlite3_column_int64(statement, 0));
+  };
+  result = sqlite3_reset(statement);
+  check(result, "Error resetting statement for filtering recipes: ");
+  return ids;
+}
+
+vector<sqlite3_int64> Database::query_list(sqlite3_stmt *statement, sqlite3_int64 id, const char *text) {
+  int result;
+  vector<sqlite3_int64> ids;
+  // The parameters are numbered from ?001 in the order id and text.
+  if (id) {
+    result = sqlite3_bind_int64(statement, 1, id);
+    check(result, "Error binding id: ");
+  };
+  if (text) {
+    result = sqlite3_bind_text(statement, id ? 2 : 1, text, -1, SQLITE_STATIC);
+    check(result, "Error binding search string: ");
+  };
+  while (true) {
+    result = sqlite3_step(statement);
+    check(result, "Error querying ids: ");
+    if (result != SQLITE_ROW)
+      break;
+    ids.push_back(sqlite3_column_int64(statement, 0));
+  };
+  result = sqlite3_reset(statement);
+  check(result, "Error resetting statement for querying ids: ");
+  return ids;
+}
+
+void Database::load_ingredient_index(void) {
+  int result;
+  m_ingredient_index.clear();
+  while (true) {
+    result = sqlite3_step(m_ingredient_postings);
+    check(result, "Error loading ingredient index: ");
+    if (result != SQLITE_ROW)
+      break;
+    m_ingredient_index.add(sqlite3_column_int64(m_ingredient_postings, 0), sqlite3_column_int64(m_ingredient_postings, 1));
+  };
+  result = sqlite3_reset(m_ingredient_postings);
+  check(result, "Error resetting statement for loading ingredient index: ");
+  m_ingredient_index.set_loaded();
+}
+
+void Database::set_selection(const Bitmap &selection) {
+  m_selection = selection;
+  m_chain.clear();
+}
+
+void Database::set_selection(const Bitmap &selection, const string &chain) {
+  m_selection = selection;
+  m_chain = chain;
 }
 
 void Database::select_by_title(const char *title) {
+  if (*title) {
+    m_selection &= query_ids(m_select_title, title);
+    m_chain.clear();
+  };
+}
+
+void Database::select_by_text(const char *text) {
+  string query = text_query(text);
+  if (!query.empty()) {
+    m_selection &= query_ids(m_select_text, query.c_str());
+    m_chain.clear();
+  };
+}
+
+vector<pair<sqlite3_int64, string> > Database::search_recipes(const char *text, int limit) {
   int result;
-  result = sqlite3_bind_text(m_select_title, 1, title, -1, SQLITE_STATIC);
-  check(result, "Error binding title string: ");
-  result = sqlite3_step(m_select_title);
-  check(result, "Error filtering recipes by title: ");
-  result = sqlite3_reset(m_select_title);
-  check(result, "Error resetting statement for filtering recipes by title: ");
+  vector<pair<sqlite3_int64, string> > infos;
+  string query = text_query(text);
+  if (query.empty())
+    return infos;
+  result = sqlite3_bind_text(m_search_text, 1, query.c_str(), -1, SQLITE_STATIC);
+  check(result, "Error binding search text: ");
+  result = sqlite3_bind_int(m_search_text, 2, limit);
+  check(result, "Error binding search limit: ");
+  while (true) {
+    result = sqlite3_step(m_search_text);
+    check(result, "Error searching recipes: ");
+    if (result != SQLITE_ROW)
+      break;
+    pair<sqlite3_int64, string> info(sqlite3_column_int64(m_search_text, 0), (const char *)sqlite3_column_text(m_search_text, 1));
+    infos.push_back(info);
+  };
+  result = sqlite3_reset(m_search_text);
+  check(result, "Error resetting statement for searching recipes: ");
+  return infos;
 }
 
 void Database::select_by_category(const char *category) {
-  int result;
-  result = sqlite3_bind_text(m_select_category, 1, category, -1, SQLITE_STATIC);
-  check(result, "Error binding category string: ");
-  result = sqlite3_step(m_select_category);
-  check(result, "Error filtering recipes by category: ");
-  result = sqlite3_reset(m_select_category);
-  check(result, "Error resetting statement for filtering recipes by category: ");
+  m_selection &= query_ids(m_select_category, category);
+  m_chain.clear();
 }
 
 void Database::select_by_no_category(const char *category) {
-  int result;
-  result = sqlite3_bind_text(m_select_no_category, 1, category, -1, SQLITE_STATIC);
-  check(result, "Error binding category string: ");
-  result = sqlite3_step(m_select_no_category);
-  check(result, "Error filtering recipes by not in category: ");
-  result = sqlite3_reset(m_select_no_category);
-  check(result, "Error resetting statement for filtering recipes by not in category: ");
+  m_selection -= query_ids(m_select_category, category);
+  m_chain.clear();
 }
 
 void Database::select_by_ingredient(const char *ingredient) {
-  int result;
-  result = sqlite3_bind_text(m_select_ingredient, 1, ingredient, -1, SQLITE_STATIC);
-  check(result, "Error binding ingredient string: ");
-  result = sqlite3_step(m_select_ingredient);
-  check(result, "Error filtering recipes by ingredient: ");
-  result = sqlite3_reset(m_select_ingredient);
-  check(result, "Error resetting statement for filtering recipes by ingredient: ");
+  select_by_ingredients(vector<string>(1, ingredient), vector<string>(), vector<string>());
 }
 
 void Database::select_by_no_ingredient(const char *ingredient) {
-  int result;
-  result = sqlite3_bind_text(m_select_no_ingredient, 1, ingredient, -1, SQLITE_STATIC);
-  check(result, "Error binding ingredient string: ");
-  result = sqlite3_step(m_select_no_ingredient);
-  check(result, "Error filtering recipes by not having ingredient: ");
-  result = sqlite3_reset(m_select_no_ingredient);
-  check(result, "Error resetting statement for filtering recipes by not having ingredient: ");
+  select_by_ingredients(vector<string>(), vector<string>(), vector<string>(1, ingredient));
+}
+
+void Database::select_by_filter(const Filter &filter) {
+  // Convert text terms to full-text queries and drop the ones without words. Empty titles match every recipe.
+  Filter compiled;
+  for (vector<Filter::Term>::const_iterator term=filter.terms().begin(); term!=filter.terms().end(); term++) {
+    if (term->field == Filter::TEXT) {
+      string query = text_query(term->text.c_str());
+      if (!query.empty())
+        compiled.add(term->field, query, term->negated);
+    } else if (term->field != Filter::TITLE || !term->text.empty())
+      compiled.add(term->field, term->text, term->negated);
+  };
+  if (compiled.empty())
+    return;
+  // Replay the result of the same chain of filters if the database was not modified in the meantime.
+  string chain = m_chain.empty() ? m_chain : m_chain + compiled.key();
+  sqlite3_int64 current = generation();
+  if (!chain.empty()) {
+    Bitmap cached;
+    if (m_filter_cache.find(chain, current, cached)) {
+      m_selection = cached;
+      m_chain = chain;
+      return;
+    };
+  };
+  // Ingredient terms are looked up in the ingredient index and the other terms are combined into one query.
+  Filter query;
+  vector<string> all;
+  vector<string> none;
+  for (vector<Filter::Term>::const_iterator term=compiled.terms().begin(); term!=compiled.terms().end(); term++) {
+    if (term->field != Filter::INGREDIENT)
+      query.add(term->field, term->text, term->negated);
+    else if (term->negated)
+      none.push_back(term->text);
+    else
+      all.push_back(term->text);
+  };
+  Bitmap selection = m_selection;
+  if (!query.empty()) {
+    sqlite3_stmt *statement;
+    int result = sqlite3_prepare_v2(m_db, query.sql().c_str(), -1, &statement, NULL);
+    check(result, "Error preparing filter statement: ");
+    selection = Bitmap();
+    int c = 1;
+    for (vector<Filter::Term>::const_iterator term=query.terms().begin(); term!=query.terms().end(); term++) {
+      result = sqlite3_bind_text(statement, c++, term->text.c_str(), -1, SQLITE_STATIC);
+      if (result != SQLITE_OK)
+        break;
+    };
+    while (result == SQLITE_OK || result == SQLITE_ROW) {
+      result = sqlite3_step(statement);
+      if (result == SQLITE_ROW)
+        selection.add(sqlite3_column_int64(statement, 0));
+    };
+    sqlite3_finalize(statement);
+    check(result, "Error filtering recipes: ");
+  };
+  if (!all.empty() || !none.empty())
+    selection = match_ingredients(selection, all, vector<string>(), none);
+  m_selection = selection;
+  m_chain = chain;
+  if (!chain.empty())
+    m_filter_cache.insert(chain, current, m_selection);
+}
+
+Bitmap Database::match_ingredients(const Bitmap &selection, const vector<string> &all, const vector<string> &any,
+                                   const vector<string> &none) {
+  // Discard an index which is out of date because another connection modified the database.
+  generation();
+  if (!m_ingredient_index.loaded())
+    load_ingredient_index();
+  // Resolve each search term to the ids of the matching ingredients.
+  vector<vector<sqlite3_int64> > all_ids;
+  for (vector<string>::const_iterator term=all.begin(); term!=all.end(); term++)
+    all_ids.push_back(query_list(m_match_ingredients, 0, term->c_str()));
+  vector<vector<sqlite3_int64> > any_ids;
+  for (vector<string>::const_iterator term=any.begin(); term!=any.end(); term++)
+    any_ids.push_back(query_list(m_match_ingredients, 0, term->c_str()));
+  vector<vector<sqlite3_int64> > none_ids;
+  for (vector<string>::const_iterator term=none.begin(); term!=none.end(); term++)
+    none_ids.push_back(query_list(m_match_ingredients, 0, term->c_str()));
+  return m_ingredient_index.query(selection, all_ids, any_ids, none_ids);
+}
+
+void Database::select_by_ingredients(const vector<string> &all, const vector<string> &any, const vector<string> &none) {
+  m_selection = match_ingredients(m_selection, all, any, none);
+  m_chain.clear();
+}
+
+bool Database::fetch_cached(sqlite3_int64 id, Recipe &recipe) {
+  int result = sqlite3_bind_int64(m_get_cached, 1, id);
+  check(result, "Error binding recipe id for cache: ");
+  result = sqlite3_step(m_get_cached);
+  check(result, "Error retrieving cached recipe: ");
+  bool found = result == SQLITE_ROW &&
+    decode_recipe((const char *)sqlite3_column_blob(m_get_cached, 0), sqlite3_column_bytes(m_get_cached, 0), recipe);
+  result = sqlite3_reset(m_get_cached);
+  check(result, "Error resetting statement for retrieving cached recipe: ");
+  return found;
 }
 
 Recipe Database::fetch_recipe(sqlite3_int64 id) {
+  Recipe recipe;
+  // Use cached recipe if available.
+  if (fetch_cached(id, recipe))
+    return recipe;
+  return assemble_recipe(id);
+}
+
+void Database::cache_recipe(sqlite3_int64 id, Recipe &recipe) {
+  int result = sqlite3_bind_int64(m_add_cached, 1, id);
+  check(result, "Error binding recipe id for cache: ");
+  string data = encode_recipe(recipe);
+  result = sqlite3_bind_blob(m_add_cached, 2, data.data(), data.size(), SQLITE_STATIC);
+  check(result, "Error binding encoded recipe: ");
+  result = sqlite3_step(m_add_cached);
+  check(result, "Error caching recipe: ");
+  result = sqlite3_reset(m_add_cached);
+  check(result, "Error resetting statement for caching recipe: ");
+}
+
+void Database::recache_recipes(const vector<sqlite3_int64> &ids) {
+  // The triggers on the category tables discard the encoded recipes. Encode them again in the same transaction.
+  for (vector<sqlite3_int64>::const_iterator id=ids.begin(); id!=ids.end(); id++) {
+    Recipe recipe = assemble_recipe(*id);
+    cache_recipe(*id, recipe);
+  };
+}
+
+Recipe Database::assemble_recipe(sqlite3_int64 id) {
   int result;
   Recipe recipe;
   // Retrieve recipe header.
@@ -635,86 +1460,238 @@ Recipe Database::fetch_recipe(sqlite3_int64 id) {
   return recipe;
 }
 
+void Database::load_ids(const vector<sqlite3_int64> &ids) {
+  int result = sqlite3_step(m_clear_ids);
+  check(result, "Error clearing recipe ids: ");
+  result = sqlite3_reset(m_clear_ids);
+  check(result, "Error resetting statement for clearing recipe ids: ");
+  for (vector<sqlite3_int64>::const_iterator id=ids.begin(); id!=ids.end(); id++) {
+    result = sqlite3_bind_int64(m_add_id, 1, *id);
+    check(result, "Error binding recipe id: ");
+    result = sqlite3_step(m_add_id);
+    check(result, "Error adding recipe id: ");
+    result = sqlite3_reset(m_add_id);
+    check(result, "Error resetting statement for adding recipe id: ");
+  };
+}
+
+static size_t advance(const vector<sqlite3_int64> &sorted, size_t index, sqlite3_int64 id) {
+  while (index + 1 < sorted.size() && sorted[index] < id)
+    index++;
+  return index;
+}
+
 vector<Recipe> Database::fetch_recipes(const vector<sqlite3_int64> &ids) {
-  vector<Recipe> result;
+  int result;
+  size_t i;
+  load_ids(ids);
+  // Decode cached recipes sorted by id and collect the recipes without cache entry.
+  vector<sqlite3_int64> sorted;
+  vector<Recipe> recipes;
+  vector<sqlite3_int64> missing;
+  vector<size_t> slots;
+  while (true) {
+    result = sqlite3_step(m_fetch_cached);
+    check(result, "Error retrieving cached recipes: ");
+    if (result != SQLITE_ROW)
+      break;
+    sorted.push_back(sqlite3_column_int64(m_fetch_cached, 0));
+    recipes.push_back(Recipe());
+    if (sqlite3_column_type(m_fetch_cached, 1) == SQLITE_NULL ||
+        !decode_recipe((const char *)sqlite3_column_blob(m_fetch_cached, 1), sqlite3_column_bytes(m_fetch_cached, 1),
+                       recipes.back())) {
+      missing.push_back(sorted.back());
+      slots.push_back(recipes.size() - 1);
+    };
+  };
+  result = sqlite3_reset(m_fetch_cached);
+  check(result, "Error resetting cached recipes query: ");
+  if (!missing.empty()) {
+    load_ids(missing);
+    // Retrieve recipe headers sorted by id.
+    i = 0;
+    while (true) {
+      result = sqlite3_step(m_fetch_headers);
+      check(result, "Error retrieving recipe headers: ");
+      if (result != SQLITE_ROW)
+        break;
+      Recipe &recipe = recipes[slots[i++]];
+      recipe.set_title((const char *)sqlite3_column_text(m_fetch_headers, 1));
+      recipe.set_servings(sqlite3_column_int(m_fetch_headers, 2));
+      recipe.set_servings_unit((const char *)sqlite3_column_text(m_fetch_headers, 3));
+    };
+    result = sqlite3_reset(m_fetch_headers);
+    check(result, "Error resetting recipe headers query: ");
+    // Merge recipe categories.
+    i = 0;
+    while (true) {
+      result = sqlite3_step(m_fetch_categories);
+      check(result, "Error retrieving recipe categories: ");
+      if (result != SQLITE_ROW)
+        break;
+      i = advance(missing, i, sqlite3_column_int64(m_fetch_categories, 0));
+      recipes[slots[i]].add_category((const char *)sqlite3_column_text(m_fetch_categories, 1));
+    };
+    result = sqlite3_reset(m_fetch_categories);
+    check(result, "Error resetting recipe categories query: ");
+    // Merge recipe ingredients.
+    i = 0;
+    while (true) {
+      result = sqlite3_step(m_fetch_ingredients);
+      check(result, "Error retrieving recipe ingredients: ");
+      if (result != SQLITE_ROW)
+        break;
+      i = advance(missing, i, sqlite3_column_int64(m_fetch_ingredients, 0));
+      Ingredient ingredient;
+      ingredient.set_amount_integer(sqlite3_column_int(m_fetch_ingredients, 1));
+      ingredient.set_amount_numerator(sqlite3_column_int(m_fetch_ingredients, 2));
+      ingredient.set_amount_denominator(sqlite3_column_int(m_fetch_ingredients, 3));
+      ingredient.set_amount_float(sqlite3_column_double(m_fetch_ingredients, 4));
+      ingredient.set_unit((const char *)sqlite3_column_text(m_fetch_ingredients, 5));
+      ingredient.add_text((const char *)sqlite3_column_text(m_fetch_ingredients, 6));
+      recipes[slots[i]].add_ingredient(ingredient);
+    };
+    result = sqlite3_reset(m_fetch_ingredients);
+    check(result, "Error resetting recipe ingredients query: ");
+    // Merge ingredient sections.
+    i = 0;
+    while (true) {
+      result = sqlite3_step(m_fetch_ingredient_sections);
+      check(result, "Error retrieving ingredient sections: ");
+      if (result != SQLITE_ROW)
+        break;
+      i = advance(missing, i, sqlite3_column_int64(m_fetch_ingredient_sections, 0));
+      recipes[slots[i]].add_ingredient_section(sqlite3_column_int(m_fetch_ingredient_sections, 1) - 1,
+                                               (const char *)sqlite3_column_text(m_fetch_ingredient_sections, 2));
+    };
+    result = sqlite3_reset(m_fetch_ingredient_sections);
+    check(result, "Error resetting ingredient sections query: ");
+    // Merge recipe instructions.
+    i = 0;
+    while (true) {
+      result = sqlite3_step(m_fetch_instructions);
+      check(result, "Error retrieving recipe instructions: ");
+      if (result != SQLITE_ROW)
+        break;
+      i = advance(missing, i, sqlite3_column_int64(m_fetch_instructions, 0));
+      recipes[slots[i]].add_instruction((const char *)sqlite3_column_text(m_fetch_instructions, 1));
+    };
+    result = sqlite3_reset(m_fetch_instructions);
+    check(result, "Error resetting recipe instructions query: ");
+    // Merge instruction sections.
+    i = 0;
+    while (true) {
+      result = sqlite3_step(m_fetch_instruction_sections);
+      check(result, "Error retrieving instruction sections: ");
+      if (result != SQLITE_ROW)
+        break;
+      i = advance(missing, i, sqlite3_column_int64(m_fetch_instruction_sections, 0));
+      recipes[slots[i]].add_instruction_section(sqlite3_column_int(m_fetch_instruction_sections, 1) - 1,
+                                                (const char *)sqlite3_column_text(m_fetch_instruction_sections, 2));
+    };
+    result = sqlite3_reset(m_fetch_instruction_sections);
+    check(result, "Error resetting instruction sections query: ");
+  };
+  // Return recipes in requested order.
+  vector<Recipe> ordered;
+  ordered.reserve(ids.size());
   for (vector<sqlite3_int64>::const_iterator id=ids.begin(); id!=ids.end(); id++) {
-    result.push_back(fetch_recipe(*id));
+    vector<sqlite3_int64>::iterator position = lower_bound(sorted.begin(), sorted.end(), *id);
+    if (position == sorted.end() || *position != *id) {
+      ostringstream s;
+      s << "Could not find recipe with id " << *id << ".";
+      throw database_exception(s.str());
+    };
+    ordered.push_back(recipes[position - sorted.begin()]);
   };
-  return result;
+  return ordered;
 }
 
 void Database::delete_recipes(const vector<sqlite3_int64> &ids) {
+  modified();
   int result;
+  load_ids(ids);
+  // Remove from ingredient index.
+  if (m_ingredient_index.loaded()) {
+    while (true) {
+      result = sqlite3_step(m_delete_postings);
+      check(result, "Error getting ingredients of recipes: ");
+      if (result != SQLITE_ROW)
+        break;
+      m_ingredient_index.remove(sqlite3_column_int64(m_delete_postings, 0), sqlite3_column_int64(m_delete_postings, 1));
+    };
+    result = sqlite3_reset(m_delete_postings);
+    check(result, "Error resetting statement for getting ingredients of recipes: ");
+  };
+  // Remove from full-text index.
+  result = sqlite3_step(m_delete_text);
+  check(result, "Error removing recipes from full-text index: ");
+  result = sqlite3_reset(m_delete_text);
+  check(result, "Error resetting statement for removing recipes from full-text index: ");
+  // Delete cached recipes.
+  result = sqlite3_step(m_delete_cached);
+  check(result, "Error deleting cached recipes: ");
+  result = sqlite3_reset(m_delete_cached);
+  check(result, "Error resetting statement for deleting cached recipes: ");
+  // Delete categories.
+  result = sqlite3_step(m_delete_categories);
+  check(result, "Error deleting categories: ");
+  result = sqlite3_reset(m_delete_categories);
+  check(result, "Error resetting statement for deleting categories: ");
+  // Delete ingredients.
+  result = sqlite3_step(m_delete_ingredients);
+  check(result, "Error deleting ingredients: ");
+  result = sqlite3_reset(m_delete_ingredients);
+  check(result, "Error resetting statement for deleting ingredients: ");
+  // Delete instructions.
+  result = sqlite3_step(m_delete_instructions);
+  check(result, "Error deleting instructions: ");
+  result = sqlite3_reset(m_delete_instructions);
+  check(result, "Error resetting statement for deleting instructions: ");
+  // Delete ingredient sections.
+  result = sqlite3_step(m_delete_ingredient_sections);
+  check(result, "Error deleting ingredient sections: ");
+  result = sqlite3_reset(m_delete_ingredient_sections);
+  check(result, "Error resetting statement for deleting ingredient sections: ");
+  // Delete instruction sections.
+  result = sqlite3_step(m_delete_instruction_sections);
+  check(result, "Error deleting instruction sections: ");
+  result = sqlite3_reset(m_delete_instruction_sections);
+  check(result, "Error resetting statement for deleting instruction sections: ");
+  // Remove from selection.
   for (vector<sqlite3_int64>::const_iterator id=ids.begin(); id!=ids.end(); id++) {
-    // Delete categories.
-    result = sqlite3_bind_int64(m_delete_categories, 1, *id);
-    check(result, "Error binding id for deleting categories: ");
-    result = sqlite3_step(m_delete_categories);
-    check(result, "Error deleting categories: ");
-    result = sqlite3_reset(m_delete_categories);
-    check(result, "Error resetting statement for deleting categories: ");
-    // Delete ingredients.
-    result = sqlite3_bind_int64(m_delete_ingredients, 1, *id);
-    check(result, "Error binding id for deleting ingredients: ");
-    result = sqlite3_step(m_delete_ingredients);
-    check(result, "Error deleting ingredients: ");
-    result = sqlite3_reset(m_delete_ingredients);
-    check(result, "Error resetting statement for deleting ingredients: ");
-    // Delete instructions.
-    result = sqlite3_bind_int64(m_delete_instructions, 1, *id);
-    check(result, "Error binding id for deleting instructions: ");
-    result = sqlite3_step(m_delete_instructions);
-    check(result, "Error deleting instructions: ");
-    result = sqlite3_reset(m_delete_instructions);
-    check(result, "Error resetting statement for deleting instructions: ");
-    // Delete ingredient sections.
-    result = sqlite3_bind_int64(m_delete_ingredient_sections, 1, *id);
-    check(result, "Error binding id for deleting ingredient sections: ");
-    result = sqlite3_step(m_delete_ingredient_sections);
-    check(result, "Error deleting ingredient sections: ");
-    result = sqlite3_reset(m_delete_ingredient_sections);
-    check(result, "Error resetting statement for deleting ingredient sections: ");
-    // Delete instruction sections.
-    result = sqlite3_bind_int64(m_delete_instruction_sections, 1, *id);
-    check(result, "Error binding id for deleting instruction sections: ");
-    result = sqlite3_step(m_delete_instruction_sections);
-    check(result, "Error deleting instruction sections: ");
-    result = sqlite3_reset(m_delete_instruction_sections);
-    check(result, "Error resetting statement for deleting instruction sections: ");
-    // Delete selections.
-    result = sqlite3_bind_int64(m_delete_selection, 1, *id);
-    check(result, "Error binding id for deleting selection: ");
-    result = sqlite3_step(m_delete_selection);
-    check(result, "Error deleting selection: ");
-    result = sqlite3_reset(m_delete_selection);
-    check(result, "Error resetting statement for deleting selection: ");
-    // Delete recipe.
-    result = sqlite3_bind_int64(m_delete_recipe, 1, *id);
-    check(result, "Error binding id for deleting recipe: ");
-    result = sqlite3_step(m_delete_recipe);
-    check(result, "Error deleting recipe: ");
-    result = sqlite3_reset(m_delete_recipe);
-    check(result, "Error resetting statement for deleting recipe: ");
+    if (m_selection.contains(*id)) {
+      m_selection.remove(*id);
+      m_removed.add(*id);
+    };
   };
+  // Delete recipes.
+  result = sqlite3_step(m_delete_recipe);
+  check(result, "Error deleting recipes: ");
+  result = sqlite3_reset(m_delete_recipe);
+  check(result, "Error resetting statement for deleting recipes: ");
 }
 
 void Database::add_recipes_to_category(const vector<sqlite3_int64> &ids, const char *category) {
+  modified();
   // Create category.
-  add_category(category);
+  sqlite3_int64 id_of_category = category_id(category);
   // Add recipes to category.
   for (vector<sqlite3_int64>::const_iterator id=ids.begin(); id!=ids.end(); id++) {
     int result = sqlite3_bind_int64(m_recipe_category, 1, *id);
     check(result, "Error binding recipe id: ");
-    result = sqlite3_bind_text(m_recipe_category, 2, category, -1, SQLITE_STATIC);
-    check(result, "Error binding category name: ");
+    result = sqlite3_bind_int64(m_recipe_category, 2, id_of_category);
+    check(result, "Error binding category id: ");
     result = sqlite3_step(m_recipe_category);
     check(result, "Error adding recipe category: ");
     result = sqlite3_reset(m_recipe_category);
     check(result, "Error resetting recipe category statement: ");
   };
+  recache_recipes(ids);
 }
 
 void Database::remove_recipes_from_category(const vector<sqlite3_int64> &ids, const char *category) {
+  modified();
   for (vector<sqlite3_int64>::const_iterator id=ids.begin(); id!=ids.end(); id++) {
     int result = sqlite3_bind_int64(m_remove_recipe_category, 1, *id);
     check(result, "Error binding recipe id: ");
@@ -725,17 +1702,25 @@ void Database::remove_recipes_from_category(const vector<sqlite3_int64> &ids, co
     result = sqlite3_reset(m_remove_recipe_category);
     check(result, "Error resetting recipe category statement: ");
   };
+  recache_recipes(ids);
 }
 
 void Database::rename_category(const char *current_name, const char *new_name) {
+  modified();
+  sqlite3_int64 category_id = get_category_id(current_name);
+  vector<sqlite3_int64> ids;
+  if (category_id)
+    ids = query_list(m_category_recipes, category_id, NULL);
   int result = sqlite3_bind_text(m_rename_category, 1, current_name, -1, SQLITE_STATIC);
   check(result, "Error binding old category name: ");
   result = sqlite3_bind_text(m_rename_category, 2, new_name, -1, SQLITE_STATIC);
   check(result, "Error binding new category name: ");
   result = sqlite3_step(m_rename_category);
   check(result, "Error renaming recipe category: ");
+  m_category_ids.clear();
   result = sqlite3_reset(m_rename_category);
   check(result, "Error resetting rename category statement: ");
+  recache_recipes(ids);
 }
 
 sqlite3_int64 Database::get_category_id(const char *name)
@@ -752,9 +1737,57 @@ sqlite3_int64 Database::get_category_id(const char *name)
   return category_id;
 }
 
+sqlite3_int64 Database::category_id(const string &name) {
+  unordered_map<string, sqlite3_int64>::iterator cached = m_category_ids.find(name);
+  if (cached != m_category_ids.end())
+    return cached->second;
+  sqlite3_int64 id = get_category_id(name.c_str());
+  if (!id) {
+    int result = sqlite3_bind_text(m_insert_category, 1, name.c_str(), -1, SQLITE_STATIC);
+    check(result, "Error binding category name: ");
+    result = sqlite3_step(m_insert_category);
+    check(result, "Error adding category: ");
+    result = sqlite3_reset(m_insert_category);
+    check(result, "Error resetting category adding statement: ");
+    id = sqlite3_last_insert_rowid(m_db);
+  };
+  m_category_ids[name] = id;
+  return id;
+}
+
+sqlite3_int64 Database::ingredient_id(const string &name) {
+  unordered_map<string, sqlite3_int64>::iterator cached = m_ingredient_ids.find(name);
+  if (cached != m_ingredient_ids.end())
+    return cached->second;
+  sqlite3_int64 id = 0;
+  int result = sqlite3_bind_text(m_get_ingredient_id, 1, name.c_str(), -1, SQLITE_STATIC);
+  check(result, "Error binding ingredient: ");
+  result = sqlite3_step(m_get_ingredient_id);
+  check(result, "Error getting ingredient id: ");
+  if (result == SQLITE_ROW)
+    id = sqlite3_column_int64(m_get_ingredient_id, 0);
+  result = sqlite3_reset(m_get_ingredient_id);
+  check(result, "Error resetting statement for getting ingredient id: ");
+  if (!id) {
+    result = sqlite3_bind_text(m_insert_ingredient, 1, name.c_str(), -1, SQLITE_STATIC);
+    check(result, "Error binding ingredient: ");
+    result = sqlite3_step(m_insert_ingredient);
+    check(result, "Error adding ingredient: ");
+    result = sqlite3_reset(m_insert_ingredient);
+    check(result, "Error resetting ingredient adding statement: ");
+    id = sqlite3_last_insert_rowid(m_db);
+  };
+  m_ingredient_ids[name] = id;
+  return id;
+}
+
 void Database::merge_category(const char *category, const char *target) {
+  modified();
   sqlite3_int64 category_id = get_category_id(category);
   sqlite3_int64 target_id = get_category_id(target);
+  vector<sqlite3_int64> ids;
+  if (category_id)
+    ids = query_list(m_category_recipes, category_id, NULL);
   int result = sqlite3_bind_int64(m_merge_category, 1, category_id);
   check(result, "Error binding category id for merging: ");
   result = sqlite3_bind_int64(m_merge_category, 2, target_id);
@@ -764,10 +1797,15 @@ void Database::merge_category(const char *category, const char *target) {
   result = sqlite3_reset(m_merge_category);
   check(result, "Error resetting statement for merging category: ");
   delete_category(category);
+  recache_recipes(ids);
 }
 
 void Database::delete_category(const char *category) {
+  modified();
   sqlite3_int64 category_id = get_category_id(category);
+  vector<sqlite3_int64> ids;
+  if (category_id)
+    ids = query_list(m_category_recipes, category_id, NULL);
   int result = sqlite3_bind_int64(m_delete_recipe_category, 1, category_id);
   check(result, "Error binding category id for deleting from recipe: ");
   result = sqlite3_step(m_delete_recipe_category);
@@ -778,20 +1816,87 @@ void Database::delete_category(const char *category) {
   check(result, "Error binding category id for deleting: ");
   result = sqlite3_step(m_delete_category);
   check(result, "Error deleting category: ");
+  m_category_ids.clear();
   result = sqlite3_reset(m_delete_category);
   check(result, "Error resetting statement for deleting category: ");
+  recache_recipes(ids);
+}
+
+vector<sqlite3_int64> Database::duplicates(const vector<sqlite3_int64> &ids) {
+  // Recipes with the same content and the same categories as a recipe with a lower id are duplicates.
+  load_ids(ids);
+  return query_list(m_duplicates, 0, NULL);
+}
+
+vector<RecipeFeatures> Database::recipe_features(const vector<sqlite3_int64> &ids) {
+  int result;
+  load_ids(ids);
+  // Words of the titles sorted by recipe id.
+  vector<RecipeFeatures> features;
+  while (true) {
+    result = sqlite3_step(m_fetch_headers);
+    check(result, "Error retrieving recipe titles: ");
+    if (result != SQLITE_ROW)
+      break;
+    features.push_back(RecipeFeatures());
+    features.back().id = sqlite3_column_int64(m_fetch_headers, 0);
+    features.back().features = title_features((const char *)sqlite3_column_text(m_fetch_headers, 1));
+  };
+  result = sqlite3_reset(m_fetch_headers);
+  check(result, "Error resetting recipe titles query: ");
+  // Merge ingredient ids.
+  size_t i = 0;
+  while (true) {
+    result = sqlite3_step(m_feature_ingredients);
+    check(result, "Error retrieving ingredients of recipes: ");
+    if (result != SQLITE_ROW)
+      break;
+    sqlite3_int64 id = sqlite3_column_int64(m_feature_ingredients, 0);
+    while (i + 1 < features.size() && features[i].id < id)
+      i++;
+    features[i].features.push_back(ingredient_feature(sqlite3_column_int64(m_feature_ingredients, 1)));
+  };
+  result = sqlite3_reset(m_feature_ingredients);
+  check(result, "Error resetting statement for getting ingredients of recipes: ");
+  for (vector<RecipeFeatures>::iterator recipe=features.begin(); recipe!=features.end(); recipe++) {
+    sort(recipe->features.begin(), recipe->features.end());
+    recipe->features.erase(unique(recipe->features.begin(), recipe->features.end()), recipe->features.end());
+  };
+  return features;
 }
 
 void Database::garbage_collect(void) {
+  modified();
   int result;
   // Clean up categories.
   result = sqlite3_step(m_clean_categories);
   check(result, "Error cleaning categories: ");
+  m_category_ids.clear();
   result = sqlite3_reset(m_clean_categories);
   check(result, "Error resetting statement for cleaning categories: ");
   // Clean up ingredients.
   result = sqlite3_step(m_clean_ingredients);
   check(result, "Error cleaning ingredients: ");
+  m_ingredient_ids.clear();
   result = sqlite3_reset(m_clean_ingredients);
   check(result, "Error resetting statement for cleaning ingredients: ");
+  // Repair the recipe counts of categories.
+  if (!check_category_counts())
+    rebuild_category_counts();
+}
+
+bool Database::check_category_counts(void) {
+  int result = sqlite3_step(m_check_category_counts);
+  check(result, "Error checking recipe counts of categories: ");
+  int wrong = sqlite3_column_int(m_check_category_counts, 0);
+  result = sqlite3_reset(m_check_category_counts);
+  check(result, "Error resetting statement for checking recipe counts of categories: ");
+  return wrong == 0;
+}
+
+void Database::rebuild_category_counts(void) {
+  int result = sqlite3_step(m_rebuild_category_counts);
+  check(result, "Error rebuilding recipe counts of categories: ");
+  result = sqlite3_reset(m_rebuild_category_counts);
+  check(result, "Error resetting statement for rebuilding recipe counts of categories: ");
 }
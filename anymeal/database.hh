@@ -16,8 +16,17 @@
 #pragma once
 #include <string>
 #include <vector>
+#include <unordered_map>
 #include <sqlite3.h>
 #include "recipe.hh"
+#include "bitmap.hh"
+#include "ingredient_index.hh"
+#include "filter.hh"
+#include "filter_cache.hh"
+#include "recipe_codec.hh"
+#include "title_arena.hh"
+#include "facets.hh"
+#include "near_duplicates.hh"
 
 
 class database_exception: public std::exception
@@ -30,13 +39,25 @@ protected:
   std::string m_error;
 };
 
+#define SCHEMA_VERSION 8
+
+class Database;
+
+struct Migration {
+  int version;
+  const char *sql;
+  void (Database::*fill)(void);
+};
+
 class Database
 {
 public:
   Database(void);
   virtual ~Database(void);
-  void open(const char *filename);
+  void open(const char *filename, void (*progress)(int, int, void *) = NULL, void *data = NULL);
   sqlite3 *db(void) { return m_db; }
+  void interrupt(void);
+  void set_progress_handler(int (*handler)(void *), void *data);
   void begin(void);
   void commit(void);
   void rollback(void);
@@ -44,14 +65,27 @@ public:
   int num_recipes(void);
   int count_recipes(const char *category);
   std::vector<std::pair<sqlite3_int64, std::string> > recipe_info(void);
+  void recipe_info_page(const char *title, sqlite3_int64 id, int limit, TitleArena &page);
   std::vector<std::string> categories(void);
   std::vector<std::pair<std::string, int> > categories_and_counts(void);
+  void count_facets(Facets &facets);
+  std::vector<std::pair<std::string, int> > category_facets(const Facets &facets);
+  std::vector<std::pair<std::string, int> > ingredient_facets(const Facets &facets, size_t limit);
+  const Bitmap &selection(void) { return m_selection; }
+  void set_selection(const Bitmap &selection);
+  void set_selection(const Bitmap &selection, const std::string &chain);
+  const std::string &chain(void) { return m_chain; }
   void select_all(void);
   void select_by_title(const char *title);
+  void select_by_text(const char *text);
+  std::vector<std::pair<sqlite3_int64, std::string> > search_recipes(const char *text, int limit);
   void select_by_category(const char *category);
   void select_by_no_category(const char *category);
   void select_by_ingredient(const char *ingredient);
   void select_by_no_ingredient(const char *ingredient);
+  void select_by_filter(const Filter &filter);
+  void select_by_ingredients(const std::vector<std::string> &all, const std::vector<std::string> &any,
+                             const std::vector<std::string> &none);
   Recipe fetch_recipe(sqlite3_int64 id);
   std::vector<Recipe> fetch_recipes(const std::vector<sqlite3_int64> &ids);
   void delete_recipes(const std::vector<sqlite3_int64> &ids);
@@ -62,21 +96,48 @@ public:
   void add_category(const char *name);
   void merge_category(const char *category, const char *target);
   void delete_category(const char *category);
+  std::vector<sqlite3_int64> duplicates(const std::vector<sqlite3_int64> &ids);
+  std::vector<RecipeFeatures> recipe_features(const std::vector<sqlite3_int64> &ids);
   void garbage_collect(void);
+  bool check_category_counts(void);
+  void rebuild_category_counts(void);
 protected:
   void create(void);
-  void migrate(void);
+  void migrate(void (*progress)(int, int, void *), void *data);
+  void upgrade(const Migration &migration);
+  void prepare_recipe_queries(void);
+  void fill_cache(void);
+  void hash_recipes(void);
+  bool fetch_cached(sqlite3_int64 id, Recipe &recipe);
+  Recipe assemble_recipe(sqlite3_int64 id);
+  void cache_recipe(sqlite3_int64 id, Recipe &recipe);
+  void recache_recipes(const std::vector<sqlite3_int64> &ids);
+  sqlite3_int64 category_id(const std::string &name);
+  sqlite3_int64 ingredient_id(const std::string &name);
   void check(int result, const char *prefix);
+  sqlite3_int64 generation(void);
+  void modified(void);
   int user_version(void);
+  Bitmap query_ids(sqlite3_stmt *statement, const char *text);
+  std::vector<sqlite3_int64> query_list(sqlite3_stmt *statement, sqlite3_int64 id, const char *text);
+  void load_ingredient_index(void);
+  Bitmap match_ingredients(const Bitmap &selection, const std::vector<std::string> &all,
+                           const std::vector<std::string> &any, const std::vector<std::string> &none);
+  void load_ids(const std::vector<sqlite3_int64> &ids);
+  void count_facets(const Bitmap &ids, int delta, Facets &facets);
+  std::string facet_name(sqlite3_stmt *statement, sqlite3_int64 id);
   void pragmas(void);
+  static const Migration migrations[];
   sqlite3 *m_db;
   sqlite3_stmt *m_begin;
   sqlite3_stmt *m_commit;
   sqlite3_stmt *m_rollback;
   sqlite3_stmt *m_insert_recipe;
   sqlite3_stmt *m_add_category;
+  sqlite3_stmt *m_insert_category;
   sqlite3_stmt *m_recipe_category;
-  sqlite3_stmt *m_add_ingredient;
+  sqlite3_stmt *m_get_ingredient_id;
+  sqlite3_stmt *m_insert_ingredient;
   sqlite3_stmt *m_recipe_ingredient;
   sqlite3_stmt *m_get_header;
   sqlite3_stmt *m_get_categories;
@@ -88,29 +149,65 @@ protected:
   sqlite3_stmt *m_get_ingredient_section;
   sqlite3_stmt *m_add_instruction_section;
   sqlite3_stmt *m_get_instruction_section;
-  sqlite3_stmt *m_count_selected;
+  sqlite3_stmt *m_get_cached;
+  sqlite3_stmt *m_add_cached;
+  sqlite3_stmt *m_delete_cached;
+  sqlite3_stmt *m_fetch_cached;
+  sqlite3_stmt *m_clear_ids;
+  sqlite3_stmt *m_add_id;
+  sqlite3_stmt *m_fetch_headers;
+  sqlite3_stmt *m_fetch_categories;
+  sqlite3_stmt *m_fetch_ingredients;
+  sqlite3_stmt *m_fetch_ingredient_sections;
+  sqlite3_stmt *m_fetch_instructions;
+  sqlite3_stmt *m_fetch_instruction_sections;
+  sqlite3_stmt *m_all_recipes;
   sqlite3_stmt *m_get_info;
+  sqlite3_stmt *m_get_info_page;
   sqlite3_stmt *m_select_title;
+  sqlite3_stmt *m_select_text;
+  sqlite3_stmt *m_search_text;
+  sqlite3_stmt *m_add_text;
+  sqlite3_stmt *m_delete_text;
   sqlite3_stmt *m_category_list;
   sqlite3_stmt *m_select_category;
-  sqlite3_stmt *m_select_no_category;
-  sqlite3_stmt *m_select_ingredient;
-  sqlite3_stmt *m_select_no_ingredient;
+  sqlite3_stmt *m_match_ingredients;
+  sqlite3_stmt *m_ingredient_postings;
+  sqlite3_stmt *m_recipe_ingredient_ids;
+  sqlite3_stmt *m_delete_postings;
   sqlite3_stmt *m_delete_recipe;
   sqlite3_stmt *m_delete_categories;
   sqlite3_stmt *m_delete_ingredients;
   sqlite3_stmt *m_delete_instructions;
   sqlite3_stmt *m_delete_ingredient_sections;
   sqlite3_stmt *m_delete_instruction_sections;
-  sqlite3_stmt *m_delete_selection;
   sqlite3_stmt *m_clean_categories;
   sqlite3_stmt *m_clean_ingredients;
-  sqlite3_stmt *m_select_recipe;
   sqlite3_stmt *m_remove_recipe_category;
   sqlite3_stmt *m_rename_category;
   sqlite3_stmt *m_get_category_id;
   sqlite3_stmt *m_merge_category;
   sqlite3_stmt *m_delete_category;
   sqlite3_stmt *m_delete_recipe_category;
+  sqlite3_stmt *m_category_recipes;
   sqlite3_stmt *m_count_recipes_in_category;
+  sqlite3_stmt *m_check_category_counts;
+  sqlite3_stmt *m_rebuild_category_counts;
+  sqlite3_stmt *m_data_version;
+  sqlite3_stmt *m_count_facets;
+  sqlite3_stmt *m_category_name;
+  sqlite3_stmt *m_ingredient_name;
+  sqlite3_stmt *m_duplicates;
+  sqlite3_stmt *m_feature_ingredients;
+  Bitmap m_selection;
+  Bitmap m_inserted;
+  Bitmap m_removed;
+  Bitmap m_facet_ids;
+  std::string m_chain;
+  sqlite3_int64 m_generation;
+  sqlite3_int64 m_last_data_version;
+  FilterCache m_filter_cache;
+  IngredientIndex m_ingredient_index;
+  std::unordered_map<std::string, sqlite3_int64> m_category_ids;
+  std::unordered_map<std::string, sqlite3_int64> m_ingredient_ids;
 };
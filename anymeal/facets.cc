@@ -0,0 +1,78 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <algorithm>
+#include "facets.hh"
+
+
+using namespace std;
+
+static bool more_frequent(const pair<sqlite3_int64, int> &a, const pair<sqlite3_int64, int> &b) {
+  if (a.second != b.second)
+    return a.second > b.second;
+  return a.first < b.first;
+}
+
+void Facets::clear(void) {
+  m_ids.clear();
+  m_generation = -1;
+  m_categories.clear();
+  m_ingredients.clear();
+}
+
+void Facets::update(const Bitmap &ids, sqlite3_int64 generation) {
+  m_ids = ids;
+  m_generation = generation;
+}
+
+void Facets::count(unordered_map<sqlite3_int64, int> &counts, sqlite3_int64 id, int delta) {
+  int &value = counts[id];
+  value += delta;
+  if (value == 0)
+    counts.erase(id);
+}
+
+void Facets::count_category(sqlite3_int64 id, int delta) {
+  count(m_categories, id, delta);
+}
+
+void Facets::count_ingredient(sqlite3_int64 id, int delta) {
+  count(m_ingredients, id, delta);
+}
+
+int Facets::category_count(sqlite3_int64 id) const {
+  unordered_map<sqlite3_int64, int>::const_iterator entry = m_categories.find(id);
+  return entry == m_categories.end() ? 0 : entry->second;
+}
+
+int Facets::ingredient_count(sqlite3_int64 id) const {
+  unordered_map<sqlite3_int64, int>::const_iterator entry = m_ingredients.find(id);
+  return entry == m_ingredients.end() ? 0 : entry->second;
+}
+
+vector<pair<sqlite3_int64, int> > Facets::categories(void) const {
+  vector<pair<sqlite3_int64, int> > result(m_categories.begin(), m_categories.end());
+  sort(result.begin(), result.end(), more_frequent);
+  return result;
+}
+
+vector<pair<sqlite3_int64, int> > Facets::ingredients(size_t limit) const {
+  // Only sort the most frequent ingredients.
+  vector<pair<sqlite3_int64, int> > result(m_ingredients.begin(), m_ingredients.end());
+  size_t size = min(limit, result.size());
+  partial_sort(result.begin(), result.begin() + size, result.end(), more_frequent);
+  result.resize(size);
+  return result;
+}
@@ -0,0 +1,45 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <vector>
+#include <unordered_map>
+#include <sqlite3.h>
+#include "bitmap.hh"
+
+
+// Number of recipes per category and per ingredient for a set of recipe ids. The counts are updated by adding or
+// removing recipes so that narrowing down a selection only needs to look at the recipes which were dropped.
+class Facets
+{
+public:
+  Facets(void): m_generation(-1) {}
+  const Bitmap &ids(void) const { return m_ids; }
+  sqlite3_int64 generation(void) const { return m_generation; }
+  void clear(void);
+  void update(const Bitmap &ids, sqlite3_int64 generation);
+  void count_category(sqlite3_int64 id, int delta);
+  void count_ingredient(sqlite3_int64 id, int delta);
+  int category_count(sqlite3_int64 id) const;
+  int ingredient_count(sqlite3_int64 id) const;
+  std::vector<std::pair<sqlite3_int64, int> > categories(void) const;
+  std::vector<std::pair<sqlite3_int64, int> > ingredients(size_t limit) const;
+protected:
+  static void count(std::unordered_map<sqlite3_int64, int> &counts, sqlite3_int64 id, int delta);
+  Bitmap m_ids;
+  sqlite3_int64 m_generation;
+  std::unordered_map<sqlite3_int64, int> m_categories;
+  std::unordered_map<sqlite3_int64, int> m_ingredients;
+};
@@ -0,0 +1,41 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <QtCore/QLocale>
+#include "facets_model.hh"
+
+
+FacetsModel::FacetsModel(QObject *parent): QAbstractListModel(parent) {
+}
+
+void FacetsModel::reset(const std::vector<std::pair<std::string, int> > &facets) {
+  beginResetModel();
+  m_facets = facets;
+  endResetModel();
+}
+
+int FacetsModel::rowCount(const QModelIndex &) const {
+  return m_facets.size();
+}
+
+QVariant FacetsModel::data(const QModelIndex &index, int role) const {
+  QVariant result;
+  int row = index.row();
+  if (role == Qt::DisplayRole)
+    result = QString("%1 (%2)").arg(QString::fromUtf8(m_facets[row].first.c_str())).arg(QLocale().toString(m_facets[row].second));
+  else if (role == Qt::EditRole)
+    result = QString::fromUtf8(m_facets[row].first.c_str());
+  return result;
+}
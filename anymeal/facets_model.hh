@@ -0,0 +1,33 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <vector>
+#include <string>
+#include <QtCore/QAbstractListModel>
+
+
+// List of names with recipe counts. The counts are displayed next to the names but completion only uses the names.
+class FacetsModel: public QAbstractListModel
+{
+  Q_OBJECT
+public:
+  FacetsModel(QObject *parent);
+  void reset(const std::vector<std::pair<std::string, int> > &facets);
+  virtual int rowCount(const QModelIndex &parent=QModelIndex()) const;
+  virtual QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const;
+protected:
+  std::vector<std::pair<std::string, int> > m_facets;
+};
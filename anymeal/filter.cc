@@ -0,0 +1,82 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <algorithm>
+#include <sstream>
+#include "filter.hh"
+
+
+using namespace std;
+
+Filter &Filter::add(Field field, const string &text, bool negated) {
+  m_terms.push_back(Term(field, text, negated));
+  return *this;
+}
+
+static const char *term_sql(Filter::Field field) {
+  switch (field) {
+  case Filter::TITLE:
+    return "SELECT rowid FROM titletext WHERE " TITLE_MATCH("?");
+  case Filter::TEXT:
+    return "SELECT rowid FROM recipetext WHERE recipetext MATCH ?";
+  case Filter::CATEGORY:
+    return "SELECT recipeid FROM category, categories WHERE categoryid = categories.id AND name LIKE ? || '%'";
+  default:
+    return "SELECT recipeid FROM ingredient WHERE ingredientid IN "
+           "(SELECT rowid FROM ingredienttext WHERE name LIKE '%' || ? || '%')";
+  };
+}
+
+string Filter::sql(void) const {
+  // Each term becomes a common table expression so that the query planner can choose the evaluation order.
+  ostringstream with;
+  ostringstream where;
+  int c = 1;
+  for (vector<Term>::const_iterator term=m_terms.begin(); term!=m_terms.end(); term++, c++) {
+    // Number the parameters so that a term can use its text more than once.
+    with << (c == 1 ? "WITH " : ", ") << "term" << c << "(id) AS (";
+    for (const char *p=term_sql(term->field); *p; p++) {
+      if (*p == '?')
+        with << "?" << c;
+      else
+        with << *p;
+    };
+    with << ")";
+    where << (c == 1 ? " WHERE " : " AND ") << "id " << (term->negated ? "NOT IN" : "IN") << " term" << c;
+  };
+  if (c > 1)
+    with << " ";
+  return with.str() + "SELECT id FROM selection" + where.str() + ";";
+}
+
+string Filter::key(void) const {
+  // The terms are independent of each other and all of them are matched ignoring case of ASCII letters. Each term is
+  // length-prefixed and the step is terminated so that keys of consecutive steps can be concatenated.
+  vector<string> keys;
+  for (vector<Term>::const_iterator term=m_terms.begin(); term!=m_terms.end(); term++) {
+    ostringstream key;
+    key << "TXCI"[term->field] << (term->negated ? '-' : '+') << term->text.size() << ':';
+    for (string::const_iterator c=term->text.begin(); c!=term->text.end(); c++)
+      key << (char)(*c >= 'A' && *c <= 'Z' ? *c + ('a' - 'A') : *c);
+    keys.push_back(key.str());
+  };
+  sort(keys.begin(), keys.end());
+  keys.erase(unique(keys.begin(), keys.end()), keys.end());
+  ostringstream result;
+  for (vector<string>::const_iterator key=keys.begin(); key!=keys.end(); key++)
+    result << *key;
+  result << ';';
+  return result.str();
+}
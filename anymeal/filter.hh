@@ -0,0 +1,43 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <string>
+#include <vector>
+
+
+// Condition for titles containing the search text ignoring case of ASCII letters. The trigram index of the titles
+// finds the candidates for the LIKE operator and instr discards matches caused by '%' or '_' in the search text.
+#define TITLE_MATCH(parameter) "title LIKE '%' || " parameter " || '%' AND instr(lower(title), lower(" parameter ")) > 0"
+
+// Conjunction of title, text, category, and ingredient conditions which can be compiled into a single SQL query.
+class Filter
+{
+public:
+  enum Field { TITLE, TEXT, CATEGORY, INGREDIENT };
+  struct Term {
+    Term(Field field_, const std::string &text_, bool negated_): field(field_), text(text_), negated(negated_) {}
+    Field field;
+    std::string text;
+    bool negated;
+  };
+  Filter &add(Field field, const std::string &text, bool negated = false);
+  const std::vector<Term> &terms(void) const { return m_terms; }
+  bool empty(void) const { return m_terms.empty(); }
+  std::string sql(void) const;
+  std::string key(void) const;
+protected:
+  std::vector<Term> m_terms;
+};
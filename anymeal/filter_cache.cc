@@ -0,0 +1,61 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include "filter_cache.hh"
+
+
+using namespace std;
+
+void FilterCache::clear(void) {
+  m_entries.clear();
+  m_index.clear();
+}
+
+void FilterCache::update(sqlite3_int64 generation) {
+  if (generation != m_generation) {
+    clear();
+    m_generation = generation;
+  };
+}
+
+bool FilterCache::find(const string &key, sqlite3_int64 generation, Bitmap &selection) {
+  update(generation);
+  unordered_map<string, list<Entry>::iterator>::iterator entry = m_index.find(key);
+  if (entry == m_index.end())
+    return false;
+  // Move the entry to the front of the list.
+  m_entries.splice(m_entries.begin(), m_entries, entry->second);
+  selection = entry->second->selection;
+  return true;
+}
+
+void FilterCache::insert(const string &key, sqlite3_int64 generation, const Bitmap &selection) {
+  update(generation);
+  if (m_capacity == 0)
+    return;
+  unordered_map<string, list<Entry>::iterator>::iterator entry = m_index.find(key);
+  if (entry != m_index.end()) {
+    entry->second->selection = selection;
+    m_entries.splice(m_entries.begin(), m_entries, entry->second);
+    return;
+  };
+  // Evict the least recently used entry.
+  if (m_entries.size() >= m_capacity) {
+    m_index.erase(m_entries.back().key);
+    m_entries.pop_back();
+  };
+  m_entries.push_front(Entry(key, selection));
+  m_index[key] = m_entries.begin();
+}
@@ -0,0 +1,46 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <sqlite3.h>
+#include "bitmap.hh"
+
+
+// Least recently used cache of selections. The keys describe the chain of filters leading to a selection. All entries
+// are dropped when the generation of the database content changes.
+class FilterCache
+{
+public:
+  FilterCache(size_t capacity): m_capacity(capacity), m_generation(0) {}
+  size_t size(void) const { return m_entries.size(); }
+  size_t capacity(void) const { return m_capacity; }
+  void clear(void);
+  bool find(const std::string &key, sqlite3_int64 generation, Bitmap &selection);
+  void insert(const std::string &key, sqlite3_int64 generation, const Bitmap &selection);
+protected:
+  struct Entry {
+    Entry(const std::string &key_, const Bitmap &selection_): key(key_), selection(selection_) {}
+    std::string key;
+    Bitmap selection;
+  };
+  void update(sqlite3_int64 generation);
+  size_t m_capacity;
+  sqlite3_int64 m_generation;
+  std::list<Entry> m_entries;
+  std::unordered_map<std::string, std::list<Entry>::iterator> m_index;
+};
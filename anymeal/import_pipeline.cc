@@ -0,0 +1,233 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <chrono>
+#include "import_pipeline.hh"
+#include "mealmaster.hh"
+#include "partition.hh"
+
+
+using namespace std;
+
+ImportPipeline::ImportPipeline(Database &database, const string &encoding, int workers):
+  m_database(database), m_workers(workers), m_imported(0), m_failed(0), m_position(0), m_progress(NULL),
+  m_progress_data(NULL), m_cancel(NULL), m_cancel_data(NULL), m_rejected(NULL), m_rejected_data(NULL), m_stopped(false)
+{
+  if (m_workers <= 0)
+    m_workers = max(1, (int)thread::hardware_concurrency() - 1);
+  // Each worker needs its own conversion descriptor.
+  for (int i=0; i<m_workers; i++) {
+    m_recoders.push_back(encoding == "UTF-8" ? NULL : new Recoder(encoding.c_str(), "UTF-8"));
+    m_input.push_back(new SpscRing<ImportItem>(IMPORT_QUEUE_SIZE));
+    m_output.push_back(new SpscRing<ImportItem>(IMPORT_QUEUE_SIZE));
+  };
+}
+
+ImportPipeline::~ImportPipeline(void) {
+  for (int i=0; i<m_workers; i++) {
+    delete m_recoders[i];
+    delete m_input[i];
+    delete m_output[i];
+  };
+}
+
+void ImportPipeline::set_progress(void (*progress)(int, int, void *), void *data) {
+  m_progress = progress;
+  m_progress_data = data;
+}
+
+void ImportPipeline::set_cancel(bool (*cancel)(void *), void *data) {
+  m_cancel = cancel;
+  m_cancel_data = data;
+}
+
+void ImportPipeline::set_rejected(void (*rejected)(const string &, const string &, void *), void *data) {
+  m_rejected = rejected;
+  m_rejected_data = data;
+}
+
+static void backoff(int &spins) {
+  // Yield at first and sleep if the other thread is still busy.
+  if (spins < 64) {
+    spins++;
+    this_thread::yield();
+  } else
+    this_thread::sleep_for(chrono::microseconds(100));
+}
+
+bool ImportPipeline::send(SpscRing<ImportItem> &ring, ImportItem &item) {
+  int spins = 0;
+  while (!ring.push(item)) {
+    if (m_stopped.load(memory_order_relaxed))
+      return false;
+    backoff(spins);
+  };
+  return true;
+}
+
+bool ImportPipeline::receive(SpscRing<ImportItem> &ring, ImportItem &item) {
+  int spins = 0;
+  while (!ring.pop(item)) {
+    if (m_stopped.load(memory_order_relaxed))
+      return false;
+    backoff(spins);
+  };
+  return true;
+}
+
+void ImportPipeline::partition(istream *stream) {
+  // Only read as far ahead as the queues allow.
+  Partitioner partitioner(*stream);
+  int worker = 0;
+  ImportItem item;
+  while (partitioner.next(item.text)) {
+    item.position += item.text.size();
+    if (!send(*m_input[worker], item))
+      return;
+    worker = (worker + 1) % m_workers;
+  };
+  finish();
+}
+
+void ImportPipeline::partition_text(string_view text) {
+  // Hand out ranges of the text without copying it.
+  MemoryPartitioner partitioner(text);
+  int worker = 0;
+  ImportItem item;
+  while (partitioner.next(item.range)) {
+    item.position = partitioner.position();
+    if (!send(*m_input[worker], item))
+      return;
+    worker = (worker + 1) % m_workers;
+  };
+  finish();
+}
+
+void ImportPipeline::finish(void) {
+  // Every worker gets an end marker after its last recipe.
+  for (int i=0; i<m_workers; i++) {
+    ImportItem item;
+    item.end = true;
+    if (!send(*m_input[i], item))
+      return;
+  };
+}
+
+void ImportPipeline::work(int worker) {
+  MealMasterParser parser;
+  while (true) {
+    ImportItem item;
+    if (!receive(*m_input[worker], item))
+      break;
+    bool end = item.end;
+    if (!end) {
+      try {
+        Recipe recipe = parser.parse(item.text.empty() ? item.range : string_view(item.text));
+        if (m_recoders[worker])
+          item.recipe = m_recoders[worker]->process_recipe(recipe);
+        else
+          item.recipe = recipe;
+        item.text.clear();
+      } catch (exception &e) {
+        item.error = e.what();
+      };
+    };
+    if (!send(*m_output[worker], item) || end)
+      break;
+  };
+}
+
+void ImportPipeline::write(void) {
+  // Collect the results in the order the recipes were handed out.
+  int worker = 0;
+  while (true) {
+    ImportItem item;
+    if (!receive(*m_output[worker], item) || item.end)
+      break;
+    if (item.error.empty()) {
+      m_database.insert_recipe(item.recipe);
+      m_imported++;
+    } else {
+      m_failed++;
+      if (m_rejected)
+        m_rejected(item.text.empty() ? string(item.range) : item.text, item.error, m_rejected_data);
+    };
+    m_position = item.position;
+    if (m_progress)
+      m_progress(m_imported, m_failed, m_progress_data);
+    if (m_cancel && m_cancel(m_cancel_data)) {
+      m_stopped = true;
+      break;
+    };
+    worker = (worker + 1) % m_workers;
+  };
+}
+
+void ImportPipeline::stop(vector<thread> &threads) {
+  // Wait for the threads and discard the remaining items.
+  for (vector<thread>::iterator t=threads.begin(); t!=threads.end(); t++)
+    t->join();
+  threads.clear();
+  ImportItem item;
+  for (int i=0; i<m_workers; i++) {
+    while (m_input[i]->pop(item));
+    while (m_output[i]->pop(item));
+  };
+}
+
+bool ImportPipeline::import(istream &stream) {
+  m_stopped = false;
+  m_position = 0;
+  return run(thread(&ImportPipeline::partition, this, &stream));
+}
+
+bool ImportPipeline::import(string_view text) {
+  m_stopped = false;
+  m_position = 0;
+  return run(thread(&ImportPipeline::partition_text, this, text));
+}
+
+bool ImportPipeline::run(thread partitioner) {
+  vector<thread> threads;
+  threads.push_back(move(partitioner));
+  for (int i=0; i<m_workers; i++)
+    threads.push_back(thread(&ImportPipeline::work, this, i));
+  bool transaction = false;
+  int imported = m_imported;
+  try {
+    m_database.begin();
+    transaction = true;
+    write();
+    if (m_stopped) {
+      m_database.rollback();
+      m_imported = imported;
+    } else
+      m_database.commit();
+    transaction = false;
+  } catch (exception &) {
+    m_stopped = true;
+    stop(threads);
+    try {
+      if (transaction)
+        m_database.rollback();
+    } catch (exception &) {
+    };
+    throw;
+  };
+  bool cancelled = m_stopped;
+  m_stopped = true;
+  stop(threads);
+  return !cancelled;
+}
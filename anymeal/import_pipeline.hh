@@ -0,0 +1,85 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <atomic>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "database.hh"
+#include "recode.hh"
+#include "recipe.hh"
+#include "spsc_ring.hh"
+
+
+#define IMPORT_QUEUE_SIZE 256
+
+struct ImportItem {
+  ImportItem(void): position(0), end(false) {}
+  std::string text;
+  std::string_view range;
+  size_t position;
+  Recipe recipe;
+  std::string error;
+  bool end;
+};
+
+// Imports MealMaster files using several threads. A partitioner thread splits the input into recipes and hands them
+// out round-robin to the workers, which parse and recode them. The calling thread collects the results in the same
+// round-robin order, so the recipes are inserted in input order. Each import runs in a single transaction which is rolled
+// back when cancelling. Text in memory such as a mapped file is split into ranges without copying and has to stay valid
+// while importing. The position is the number of bytes of the current input up to the end of the last inserted recipe.
+class ImportPipeline
+{
+public:
+  ImportPipeline(Database &database, const std::string &encoding, int workers=0);
+  virtual ~ImportPipeline(void);
+  int workers(void) const { return m_workers; }
+  int imported(void) const { return m_imported; }
+  int failed(void) const { return m_failed; }
+  size_t position(void) const { return m_position; }
+  void set_progress(void (*progress)(int imported, int failed, void *data), void *data);
+  void set_cancel(bool (*cancel)(void *data), void *data);
+  void set_rejected(void (*rejected)(const std::string &text, const std::string &error, void *data), void *data);
+  bool import(std::istream &stream);
+  bool import(std::string_view text);
+protected:
+  bool run(std::thread partitioner);
+  void partition(std::istream *stream);
+  void partition_text(std::string_view text);
+  void finish(void);
+  void work(int worker);
+  void write(void);
+  void stop(std::vector<std::thread> &threads);
+  bool send(SpscRing<ImportItem> &ring, ImportItem &item);
+  bool receive(SpscRing<ImportItem> &ring, ImportItem &item);
+  Database &m_database;
+  int m_workers;
+  int m_imported;
+  int m_failed;
+  size_t m_position;
+  void (*m_progress)(int, int, void *);
+  void *m_progress_data;
+  bool (*m_cancel)(void *);
+  void *m_cancel_data;
+  void (*m_rejected)(const std::string &, const std::string &, void *);
+  void *m_rejected_data;
+  std::atomic<bool> m_stopped;
+  std::vector<Recoder *> m_recoders;
+  std::vector<SpscRing<ImportItem> *> m_input;
+  std::vector<SpscRing<ImportItem> *> m_output;
+};
@@ -0,0 +1,141 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <algorithm>
+#include <iterator>
+#include "ingredient_index.hh"
+
+
+using namespace std;
+
+void IngredientIndex::clear(void) {
+  m_postings.clear();
+  m_loaded = false;
+}
+
+void IngredientIndex::add(sqlite3_int64 ingredient_id, sqlite3_int64 recipe_id) {
+  Postings &postings = m_postings[ingredient_id];
+  // Recipe ids mostly arrive in ascending order.
+  if (postings.empty() || postings.back() < recipe_id)
+    postings.push_back(recipe_id);
+  else {
+    Postings::iterator position = lower_bound(postings.begin(), postings.end(), recipe_id);
+    if (*position != recipe_id)
+      postings.insert(position, recipe_id);
+  };
+}
+
+void IngredientIndex::remove(sqlite3_int64 ingredient_id, sqlite3_int64 recipe_id) {
+  map<sqlite3_int64, Postings>::iterator entry = m_postings.find(ingredient_id);
+  if (entry == m_postings.end())
+    return;
+  Postings &postings = entry->second;
+  Postings::iterator position = lower_bound(postings.begin(), postings.end(), recipe_id);
+  if (position != postings.end() && *position == recipe_id)
+    postings.erase(position);
+  if (postings.empty())
+    m_postings.erase(entry);
+}
+
+IngredientIndex::Postings IngredientIndex::recipes(const vector<sqlite3_int64> &ingredient_ids) const {
+  Postings result;
+  for (vector<sqlite3_int64>::const_iterator id=ingredient_ids.begin(); id!=ingredient_ids.end(); id++) {
+    map<sqlite3_int64, Postings>::const_iterator entry = m_postings.find(*id);
+    if (entry != m_postings.end())
+      result.insert(result.end(), entry->second.begin(), entry->second.end());
+  };
+  // A recipe can contain several ingredients matching the same term.
+  if (ingredient_ids.size() > 1) {
+    sort(result.begin(), result.end());
+    result.erase(unique(result.begin(), result.end()), result.end());
+  };
+  return result;
+}
+
+static bool shorter(const IngredientIndex::Postings &a, const IngredientIndex::Postings &b) {
+  return a.size() < b.size();
+}
+
+Bitmap IngredientIndex::query(const Bitmap &selection, const vector<vector<sqlite3_int64> > &all, const vector<vector<sqlite3_int64> > &any,
+                              const vector<vector<sqlite3_int64> > &none) const {
+  Bitmap result;
+  bool restricted = false;
+  Postings candidates;
+  // Intersect required terms starting with the shortest posting list.
+  vector<Postings> required;
+  for (vector<vector<sqlite3_int64> >::const_iterator term=all.begin(); term!=all.end(); term++)
+    required.push_back(recipes(*term));
+  sort(required.begin(), required.end(), shorter);
+  for (vector<Postings>::iterator postings=required.begin(); postings!=required.end(); postings++) {
+    candidates = restricted ? intersect_postings(candidates, *postings) : *postings;
+    restricted = true;
+    if (candidates.empty())
+      return result;
+  };
+  // Intersect with union of alternative terms.
+  if (!any.empty()) {
+    Postings alternatives;
+    for (vector<vector<sqlite3_int64> >::const_iterator term=any.begin(); term!=any.end(); term++)
+      alternatives = unite_postings(alternatives, recipes(*term));
+    candidates = restricted ? intersect_postings(candidates, alternatives) : alternatives;
+    restricted = true;
+  };
+  // Collect excluded recipes.
+  Bitmap excluded;
+  for (vector<vector<sqlite3_int64> >::const_iterator term=none.begin(); term!=none.end(); term++) {
+    Postings postings = recipes(*term);
+    for (Postings::iterator id=postings.begin(); id!=postings.end(); id++)
+      excluded.add(*id);
+  };
+  if (restricted) {
+    for (Postings::iterator id=candidates.begin(); id!=candidates.end(); id++)
+      if (selection.contains(*id) && !excluded.contains(*id))
+        result.add(*id);
+  } else
+    result = selection - excluded;
+  return result;
+}
+
+static IngredientIndex::Postings::const_iterator gallop(IngredientIndex::Postings::const_iterator begin,
+                                                        IngredientIndex::Postings::const_iterator end, sqlite3_int64 value) {
+  // Double the step size until the value is overtaken and then use binary search.
+  size_t step = 1;
+  while (step < (size_t)(end - begin) && begin[step] < value)
+    step *= 2;
+  IngredientIndex::Postings::const_iterator stop = step < (size_t)(end - begin) ? begin + step + 1 : end;
+  return lower_bound(begin + step / 2, stop, value);
+}
+
+IngredientIndex::Postings intersect_postings(const IngredientIndex::Postings &a, const IngredientIndex::Postings &b) {
+  IngredientIndex::Postings result;
+  const IngredientIndex::Postings &small = a.size() <= b.size() ? a : b;
+  const IngredientIndex::Postings &large = a.size() <= b.size() ? b : a;
+  IngredientIndex::Postings::const_iterator position = large.begin();
+  for (IngredientIndex::Postings::const_iterator id=small.begin(); id!=small.end(); id++) {
+    position = gallop(position, large.end(), *id);
+    if (position == large.end())
+      break;
+    if (*position == *id)
+      result.push_back(*id);
+  };
+  return result;
+}
+
+IngredientIndex::Postings unite_postings(const IngredientIndex::Postings &a, const IngredientIndex::Postings &b) {
+  IngredientIndex::Postings result;
+  result.reserve(a.size() + b.size());
+  set_union(a.begin(), a.end(), b.begin(), b.end(), back_inserter(result));
+  return result;
+}
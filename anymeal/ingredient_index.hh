@@ -0,0 +1,44 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <map>
+#include <vector>
+#include <sqlite3.h>
+#include "bitmap.hh"
+
+
+// Inverted index mapping ingredient ids to sorted lists of recipe ids.
+class IngredientIndex
+{
+public:
+  typedef std::vector<sqlite3_int64> Postings;
+  IngredientIndex(void): m_loaded(false) {}
+  bool loaded(void) const { return m_loaded; }
+  void set_loaded(void) { m_loaded = true; }
+  void clear(void);
+  void add(sqlite3_int64 ingredient_id, sqlite3_int64 recipe_id);
+  void remove(sqlite3_int64 ingredient_id, sqlite3_int64 recipe_id);
+  Postings recipes(const std::vector<sqlite3_int64> &ingredient_ids) const;
+  Bitmap query(const Bitmap &selection, const std::vector<std::vector<sqlite3_int64> > &all,
+               const std::vector<std::vector<sqlite3_int64> > &any, const std::vector<std::vector<sqlite3_int64> > &none) const;
+protected:
+  bool m_loaded;
+  std::map<sqlite3_int64, Postings> m_postings;
+};
+
+IngredientIndex::Postings intersect_postings(const IngredientIndex::Postings &a, const IngredientIndex::Postings &b);
+
+IngredientIndex::Postings unite_postings(const IngredientIndex::Postings &a, const IngredientIndex::Postings &b);
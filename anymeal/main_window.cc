@@ -16,7 +16,6 @@
 #include <cassert>
 #include <fstream>
 #include <sstream>
-#include <set>
 #include <unistd.h>
 #include <QtCore/QCoreApplication>
 #include <QtCore/QStandardPaths>
@@ -24,6 +23,7 @@
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMessageBox>
 #include <QtWidgets/QProgressDialog>
+#include <QtWidgets/QShortcut>
 #include <QtPrintSupport/QPrintPreviewDialog>
 #include <QtPrintSupport/QPrintDialog>
 #include "main_window.hh"
@@ -32,17 +32,65 @@
 #include "partition.hh"
 #include "recode.hh"
 #include "mealmaster.hh"
+#include "import_pipeline.hh"
+#include "mapped_file.hh"
 #include "html.hh"
 #include "export.hh"
 #include "config.h"
 
 
+#define FETCH_BATCH_SIZE 1000
+#define MINHASH_BANDS 16
+#define MINHASH_ROWS 4
+#define SIMILARITY_THRESHOLD 0.7
+#define SEARCH_HISTORY_SIZE 32
+#define IMPORT_PROGRESS_STEPS 1000
+
 using namespace std;
 
+static void migration_progress(int step, int steps, void *data) {
+  QProgressDialog *progress = (QProgressDialog *)data;
+  progress->setMaximum(steps);
+  progress->setValue(step);
+}
+
+struct ImportProgress {
+  QProgressDialog *dialog;
+  ImportPipeline *pipeline;
+  int file;
+  size_t size;
+};
+
+static void import_progress(int imported, int failed, void *data) {
+  // Advance within the current file by the position of the last recipe.
+  ImportProgress *progress = (ImportProgress *)data;
+  int step = progress->size ? (int)(progress->pipeline->position() * IMPORT_PROGRESS_STEPS / progress->size) : 0;
+  progress->dialog->setValue(progress->file * IMPORT_PROGRESS_STEPS + step);
+  progress->dialog->setLabelText(MainWindow::tr("%1 imported and %2 failed ...").arg(imported).arg(failed));
+  QCoreApplication::processEvents();
+}
+
+static bool import_cancelled(void *data) {
+  return ((QProgressDialog *)data)->wasCanceled();
+}
+
+static void import_rejected(const string &text, const string &error, void *data) {
+  pair<ofstream *, string> *error_file = (pair<ofstream *, string> *)data;
+  *error_file->first << MainWindow::tr("Rejected recipe: ").toUtf8().constData() << error << "\r\n";
+  *error_file->first << text;
+  error_file->first->flush();
+  if (!*error_file->first) {
+    ostringstream s;
+    s << MainWindow::tr("Error writing to file ").toUtf8().constData() << error_file->second;
+    throw gui_exception(s.str());
+  };
+}
+
 MainWindow::MainWindow(QWidget *parent):
   QMainWindow(parent), m_translator(NULL), m_converter_window(this), m_import_dialog(this), m_export_dialog(this),
   m_category_picker(this), m_titles_model(NULL), m_categories_model(NULL), m_category_table_model(NULL),
-  m_categories_completer(NULL)
+  m_categories_completer(NULL), m_ingredients_model(NULL), m_ingredients_completer(NULL), m_search_worker(NULL), m_search_serial(0), m_fetch_serial(0), m_count_serial(0), m_searching(false),
+  m_pending_all(false), m_all_selected(false), m_search_history(SEARCH_HISTORY_SIZE)
 {
   m_ui.setupUi(this);
   switch_language(QLocale::system().name().mid(0, 2));
@@ -53,10 +101,12 @@ MainWindow::MainWindow(QWidget *parent):
   connect(m_ui.action_export, &QAction::triggered, this, &MainWindow::export_recipes);
   connect(m_ui.action_preview, &QAction::triggered, this, &MainWindow::preview);
   connect(m_ui.action_print, &QAction::triggered, this, &MainWindow::print);
+  connect(m_ui.action_select_all, &QAction::triggered, this, &MainWindow::select_all);
   connect(m_ui.action_edit, &QAction::triggered, this, &MainWindow::edit);
   connect(m_ui.action_add_to_category, &QAction::triggered, this, &MainWindow::add_to_category);
   connect(m_ui.action_remove_from_category, &QAction::triggered, this, &MainWindow::remove_from_category);
   connect(m_ui.action_deduplicate, &QAction::triggered, this, &MainWindow::remove_duplicates);
+  connect(m_ui.action_near_duplicates, &QAction::triggered, this, &MainWindow::show_near_duplicates);
   connect(m_ui.action_collect_garbage, &QAction::triggered, this, &MainWindow::collect_garbage);
   connect(m_ui.action_lang_en, &QAction::triggered, this, &MainWindow::language_en);
   connect(m_ui.action_lang_de, &QAction::triggered, this, &MainWindow::language_de);
@@ -67,16 +117,20 @@ MainWindow::MainWindow(QWidget *parent):
   connect(m_ui.action_open_converter, &QAction::triggered, this, &MainWindow::open_converter);
   connect(m_ui.action_about, &QAction::triggered, this, &MainWindow::about);
   connect(m_ui.title_edit, &QLineEdit::returnPressed, this, &MainWindow::filter);
+  connect(m_ui.title_edit, &QLineEdit::textEdited, this, &MainWindow::search_titles);
   connect(m_ui.category_edit, &QLineEdit::returnPressed, this, &MainWindow::filter);
   connect(m_ui.ingredient_edit, &QLineEdit::returnPressed, this, &MainWindow::filter);
   connect(m_ui.filter_button, &QPushButton::clicked, this, &MainWindow::filter);
   connect(m_ui.reset_button, &QPushButton::clicked, this, &MainWindow::reset);
+  connect(m_ui.search_label, &QLabel::linkActivated, this, &MainWindow::jump_to_step);
+  connect(new QShortcut(QKeySequence::Back, this), &QShortcut::activated, this, &MainWindow::undo_filter);
   connect(m_ui.titles_view, &QListView::customContextMenuRequested, this, &MainWindow::titles_context_menu);
   connect(m_ui.recipe_browser, &QTextBrowser::customContextMenuRequested, this, &MainWindow::recipe_context_menu);
   m_ui.category_edit->installEventFilter(this);
   m_titles_context_menu = new QMenu(this);
   m_titles_context_menu->addAction(m_ui.action_export);
   m_titles_context_menu->addAction(m_ui.action_edit);
+  m_titles_context_menu->addAction(m_ui.action_select_all);
   m_titles_context_menu->addAction(m_ui.action_add_to_category);
   m_titles_context_menu->addAction(m_ui.action_remove_from_category);
   m_titles_context_menu->addAction(m_ui.action_preview);
@@ -90,15 +144,40 @@ MainWindow::MainWindow(QWidget *parent):
     QString path = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
     QDir dir(path);
     dir.mkpath(dir.absolutePath());
-    m_database.open(dir.filePath("anymeal.sqlite").toUtf8().constData());
+    QProgressDialog progress(tr("Upgrading database ..."), QString(), 0, 1, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setCancelButton(NULL);
+    m_database.open(dir.filePath("anymeal.sqlite").toUtf8().constData(), &migration_progress, &progress);
+    // Run searches on a second connection in a worker thread.
+    m_search_worker = new SearchWorker;
+    m_search_worker->open(dir.filePath("anymeal.sqlite").toUtf8().constData());
+    m_search_worker->moveToThread(&m_search_thread);
+    connect(&m_search_thread, &QThread::finished, m_search_worker, &QObject::deleteLater);
+    connect(this, &MainWindow::search, m_search_worker, &SearchWorker::search);
+    connect(this, &MainWindow::fetch, m_search_worker, &SearchWorker::fetch);
+    connect(m_search_worker, &SearchWorker::finished, this, &MainWindow::search_finished);
+    connect(m_search_worker, &SearchWorker::failed, this, &MainWindow::search_failed);
+    connect(m_search_worker, &SearchWorker::fetched, this, &MainWindow::recipe_fetched);
+    connect(m_search_worker, &SearchWorker::fetch_failed, this, &MainWindow::fetch_failed);
+    connect(this, &MainWindow::count, m_search_worker, &SearchWorker::count);
+    connect(m_search_worker, &SearchWorker::counted, this, &MainWindow::facets_counted);
+    connect(m_search_worker, &SearchWorker::count_failed, this, &MainWindow::count_failed);
+    m_search_thread.start();
     m_titles_model = new TitlesModel(this, &m_database);
     m_ui.titles_view->setModel(m_titles_model);
     connect(m_ui.titles_view->selectionModel(), &QItemSelectionModel::currentChanged, this, &MainWindow::selected);
-    m_categories_model = new CategoriesModel(this, &m_database);
+    connect(m_ui.titles_view->selectionModel(), &QItemSelectionModel::selectionChanged, this, &MainWindow::selection_changed);
+    connect(m_titles_model, &QAbstractItemModel::modelReset, this, &MainWindow::selection_changed);
+    m_categories_model = new CategoriesModel(this);
     m_category_table_model = new CategoryTableModel(this, &m_database);
     m_categories_completer = new QCompleter(m_categories_model, this);
     m_categories_completer->setCaseSensitivity(Qt::CaseInsensitive);
     m_ui.category_edit->setCompleter(m_categories_completer);
+    m_ingredients_model = new FacetsModel(this);
+    m_ingredients_completer = new QCompleter(m_ingredients_model, this);
+    m_ingredients_completer->setCaseSensitivity(Qt::CaseInsensitive);
+    m_ui.ingredient_edit->setCompleter(m_ingredients_completer);
+    refresh_facets();
     show_num_recipes();
   } catch (exception &e) {
     QMessageBox::critical(this, tr("Error Opening Database"), e.what());
@@ -106,6 +185,13 @@ MainWindow::MainWindow(QWidget *parent):
   };
 }
 
+MainWindow::~MainWindow(void) {
+  if (m_search_worker)
+    m_search_worker->next_search();
+  m_search_thread.quit();
+  m_search_thread.wait();
+}
+
 void MainWindow::switch_language(const QString &country) {
   if (m_translator) {
     qApp->removeTranslator(m_translator);
@@ -179,77 +265,44 @@ void MainWindow::show_num_recipes(void) {
 }
 
 void MainWindow::import(void) {
-  bool transaction = false;
   try {
     int result = m_import_dialog.exec();
     if (result == QDialog::Accepted) {
-      Recoder recoder(m_import_dialog.encoding().c_str(), "UTF-8");
       QStringList result =
         QFileDialog::getOpenFileNames(this, tr("Import MealMaster Files"), "", tr("MealMaster (*.mm *.MM *.mmf *.MMF);;"
                                       "Text (*.txt *.TXT);;All files (*)"));
       if (!result.isEmpty()) {
-        int success = 0;
-        int failed = 0;
         ofstream error_file(m_import_dialog.error_file().c_str(), ofstream::binary);
-        QProgressDialog progress(tr("Importing files ..."), tr("Cancel"), 0, result.size() * 100, this);
+        pair<ofstream *, string> rejected(&error_file, m_import_dialog.error_file());
+        QProgressDialog progress(tr("Importing files ..."), tr("Cancel"), 0, result.size() * IMPORT_PROGRESS_STEPS, this);
         progress.setWindowModality(Qt::WindowModal);
+        // Discard running searches before processing events during the import.
+        cancel_search();
+        // Parse and recode on worker threads while inserting the recipes on this thread.
+        ImportPipeline pipeline(m_database, m_import_dialog.encoding());
+        ImportProgress import_state = {&progress, &pipeline, 0, 0};
+        pipeline.set_progress(&import_progress, &import_state);
+        pipeline.set_cancel(&import_cancelled, &progress);
+        pipeline.set_rejected(&import_rejected, &rejected);
         for (int i=0; i<result.size(); i++) {
-          m_database.begin();
-          transaction = true;
-          ifstream f(result.at(i).toUtf8().constData(), ifstream::binary);
-          vector<string> lst = recipes(f);
-          int c = 0;
-          for (vector<string>::iterator recipe=lst.begin(); recipe!=lst.end(); recipe++) {
-            progress.setLabelText(tr("%1 imported and %2 failed ...").arg(success).arg(failed));
-            progress.setValue(i * 100 + c++ * 100 / lst.size());
-            istringstream s(*recipe);
-            try {
-              Recipe result = parse_mealmaster(s);
-              Recipe recoded;
-              if (m_import_dialog.encoding() == "UTF-8") {
-                recoded = result;
-              } else
-                recoded = recoder.process_recipe(result);
-              m_database.insert_recipe(recoded);
-              success++;
-            } catch (parse_exception &e) {
-              failed++;
-              error_file << tr("Rejected recipe: ").toUtf8().constData() << e.what() << "\r\n";
-              error_file << *recipe;
-              error_file.flush();
-              if (!error_file) {
-                ostringstream s;
-                s << tr("Error writing to file ").toUtf8().constData() << m_import_dialog.error_file();
-                throw gui_exception(s.str());
-              };
-            };
-            if (progress.wasCanceled())
-              break;
-          };
-          if (progress.wasCanceled()) {
-            if (transaction) {
-              m_database.rollback();
-              transaction = false;
-            };
+          progress.setValue(i * IMPORT_PROGRESS_STEPS);
+          MappedFile file(result.at(i).toUtf8().constData());
+          import_state.file = i;
+          import_state.size = file.size();
+          if (!pipeline.import(file.text()))
             break;
-          };
-          m_database.commit();
-          transaction = false;
         };
-        progress.setValue(result.size() * 100);
+        progress.setValue(result.size() * IMPORT_PROGRESS_STEPS);
         m_database.select_all();
+        reset_search_history();
         m_titles_model->reset();
-        m_categories_model->reset();
-        QMessageBox::information(this, tr("Recipes Imported"), tr("%1 imported and %2 failed.").arg(success).arg(failed));
+        refresh_facets();
+        QMessageBox::information(this, tr("Recipes Imported"),
+                                 tr("%1 imported and %2 failed.").arg(pipeline.imported()).arg(pipeline.failed()));
       };
     };
   } catch (exception &e) {
     QMessageBox::critical(this, tr("Error While Importing"), e.what());
-    try {
-      if (transaction)
-        m_database.rollback();
-    } catch (exception &e) {
-    };
   };
 }
 
@@ -329,7 +382,7 @@ void MainWindow::edit_recipe(EditMode mode)
         idx = m_titles_model->add_entry(recipe_new_id, result.title_c_str());
       };
       m_ui.titles_view->setCurrentIndex(idx);
-      m_categories_model->reset();
+      refresh_facets();
       QGuiApplication::restoreOverrideCursor();
     } catch (exception &e) {
       try {
@@ -354,7 +407,7 @@ void MainWindow::add_to_category(void) {
         m_database.begin();
         m_database.add_recipes_to_category(ids, category_dialog.category().c_str());
         m_database.commit();
-        m_categories_model->reset();
+        refresh_facets();
         m_ui.titles_view->setCurrentIndex(QModelIndex());
         QGuiApplication::restoreOverrideCursor();
       } catch (exception &e) {
@@ -380,7 +433,7 @@ void MainWindow::remove_from_category(void) {
         m_database.begin();
         m_database.remove_recipes_from_category(ids, category_dialog.category().c_str());
         m_database.commit();
-        m_categories_model->reset();
+        refresh_facets();
         m_ui.titles_view->setCurrentIndex(QModelIndex());
         QGuiApplication::restoreOverrideCursor();
       } catch (exception &e) {
@@ -431,98 +484,215 @@ void MainWindow::about(void) {
       "along with this program.  If not, see <https://www.gnu.org/licenses/>.");
 }
 
-void MainWindow::show_search_history(const char *type, const char *text)
+void MainWindow::add_search_term(const QString &type, const QString &text)
+{
+  if (!m_pending_label.isEmpty())
+    m_pending_label += ", ";
+  m_pending_label += QString("<em>%1:</em>").arg(type) + text.toHtmlEscaped();
+}
+
+void MainWindow::show_search_history(void)
 {
-  if (!m_ui.search_label->text().isEmpty())
-    m_ui.search_label->setText(QString(", ") + m_ui.search_label->text());
-  m_ui.search_label->setText(QString("<em>%1:</em>").arg(type) + text + m_ui.search_label->text());
-  m_ui.search_label->show();
+  // Show the latest step first. The earlier steps are links for going back.
+  QString text;
+  for (int i=m_search_history.size() - 1; i>=0; i--) {
+    if (!text.isEmpty())
+      text += ", ";
+    QString label = QString::fromUtf8(m_search_history.label(i).c_str());
+    if (i == (int)m_search_history.size() - 1)
+      text += label;
+    else
+      text += QString("<a href=\"%1\">%2</a>").arg(i + 1).arg(label);
+  };
+  m_ui.search_label->setText(text);
+  m_ui.search_label->setVisible(!text.isEmpty());
 }
 
 void MainWindow::reset_search_history(void)
 {
-  m_ui.search_label->hide();
-  m_ui.search_label->setText("");
+  m_search_history.clear();
+  show_search_history();
+}
+
+void MainWindow::forget_recipes(const vector<sqlite3_int64> &ids) {
+  Bitmap deleted;
+  for (vector<sqlite3_int64>::const_iterator id=ids.begin(); id!=ids.end(); id++)
+    deleted.add(*id);
+  m_search_history.erase(deleted);
+}
+
+void MainWindow::jump_to_step(const QString &link) {
+  jump(link.toInt());
+}
+
+void MainWindow::undo_filter(void) {
+  if (!m_search_history.empty())
+    jump(m_search_history.size() - 1);
+}
+
+void MainWindow::jump(size_t step) {
+  try {
+    cancel_search();
+    Bitmap selection = m_database.selection();
+    string chain = m_database.chain();
+    bool known = !chain.empty();
+    m_search_history.jump(step, selection, chain);
+    m_database.set_selection(selection, known ? chain : string());
+    m_titles_model->reset();
+    refresh_facets();
+    show_search_history();
+    show_num_recipes();
+  } catch (exception &e) {
+    QMessageBox::critical(this, tr("Error Filtering Recipes"), e.what());
+  };
 }
 
 void MainWindow::filter(void) {
   try {
-    QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-    m_ui.search_label->show();
+    Filter filter;
+    if (!m_searching)
+      m_pending_label.clear();
     if (!m_ui.title_edit->text().isEmpty()) {
-      m_database.select_by_title(m_ui.title_edit->text().toUtf8().constData());
-      show_search_history(tr("title").toUtf8().constData(), m_ui.title_edit->text().toUtf8().constData());
-      m_titles_model->reset();
-      m_categories_model->reset();
+      filter.add(Filter::TITLE, m_ui.title_edit->text().toUtf8().constData());
+      add_search_term(tr("title"), m_ui.title_edit->text());
       m_ui.title_edit->setText("");
     };
     if (!m_ui.category_edit->text().isEmpty()) {
       if (m_ui.with_category_radio->isChecked()) {
-        m_database.select_by_category(m_ui.category_edit->text().toUtf8().constData());
-        show_search_history(tr("category").toUtf8().constData(), m_ui.category_edit->text().toUtf8().constData());
+        filter.add(Filter::CATEGORY, m_ui.category_edit->text().toUtf8().constData());
+        add_search_term(tr("category"), m_ui.category_edit->text());
       } else {
-        m_database.select_by_no_category(m_ui.category_edit->text().toUtf8().constData());
-        show_search_history(tr("not category").toUtf8().constData(), m_ui.category_edit->text().toUtf8().constData());
+        filter.add(Filter::CATEGORY, m_ui.category_edit->text().toUtf8().constData(), true);
+        add_search_term(tr("not category"), m_ui.category_edit->text());
       };
-      m_titles_model->reset();
-      m_categories_model->reset();
       m_ui.category_edit->setText("");
     };
     if (!m_ui.ingredient_edit->text().isEmpty()) {
       if (m_ui.with_ingredient_radio->isChecked()) {
-        m_database.select_by_ingredient(m_ui.ingredient_edit->text().toUtf8().constData());
-        show_search_history(tr("ingredient").toUtf8().constData(), m_ui.ingredient_edit->text().toUtf8().constData());
+        filter.add(Filter::INGREDIENT, m_ui.ingredient_edit->text().toUtf8().constData());
+        add_search_term(tr("ingredient"), m_ui.ingredient_edit->text());
       } else {
-        m_database.select_by_no_ingredient(m_ui.ingredient_edit->text().toUtf8().constData());
-        show_search_history(tr("not ingredient").toUtf8().constData(), m_ui.ingredient_edit->text().toUtf8().constData());
+        filter.add(Filter::INGREDIENT, m_ui.ingredient_edit->text().toUtf8().constData(), true);
+        add_search_term(tr("not ingredient"), m_ui.ingredient_edit->text());
       };
-      m_titles_model->reset();
-      m_categories_model->reset();
       m_ui.ingredient_edit->setText("");
     };
-    show_num_recipes();
-    QGuiApplication::restoreOverrideCursor();
+    if (!filter.empty()) {
+      // Replace a search which is still running with one including its terms.
+      Filter combined = m_searching ? m_pending_filter : Filter();
+      for (vector<Filter::Term>::const_iterator term=filter.terms().begin(); term!=filter.terms().end(); term++)
+        combined.add(term->field, term->text, term->negated);
+      start_search(m_searching && m_pending_all, combined);
+    };
   } catch (exception &e) {
-    QGuiApplication::restoreOverrideCursor();
     QMessageBox::critical(this, tr("Error Filtering Recipes"), e.what());
   };
 }
 
-void MainWindow::reset(void) {
+void MainWindow::search_titles(const QString &text) {
   try {
-    QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-    m_database.select_all();
-    reset_search_history();
-    m_titles_model->reset();
-    m_categories_model->reset();
-    show_num_recipes();
-    QGuiApplication::restoreOverrideCursor();
+    m_titles_model->set_pattern(text);
   } catch (exception &e) {
+    QMessageBox::critical(this, tr("Error Filtering Recipes"), e.what());
+  };
+}
+
+void MainWindow::reset(void) {
+  reset_search_history();
+  start_search(true, Filter());
+}
+
+void MainWindow::start_search(bool all, const Filter &filter) {
+  if (!m_searching) {
+    QGuiApplication::setOverrideCursor(QCursor(Qt::BusyCursor));
+    m_searching = true;
+  };
+  m_pending_all = all;
+  m_pending_filter = filter;
+  // The search result replaces the counts of the current selection.
+  m_count_serial = m_search_worker->next_count();
+  m_search_serial = m_search_worker->next_search();
+  emit search(m_search_serial, all, m_database.selection(), m_database.chain(), filter);
+}
+
+void MainWindow::refresh_facets(void) {
+  // Count the recipes per category and ingredient on the worker thread.
+  m_count_serial = m_search_worker->next_count();
+  emit count(m_count_serial, m_database.selection());
+}
+
+void MainWindow::cancel_search(void) {
+  if (m_searching) {
+    m_search_worker->next_search();
+    m_searching = false;
     QGuiApplication::restoreOverrideCursor();
-    QMessageBox::critical(this, tr("Error Resetting Selection"), e.what());
   };
 }
 
+void MainWindow::search_finished(int serial, SearchResult result) {
+  if (serial != m_search_serial || !m_searching)
+    return;
+  m_searching = false;
+  QGuiApplication::restoreOverrideCursor();
+  if (m_pending_all)
+    m_search_history.clear();
+  if (!m_pending_filter.empty())
+    m_search_history.push(m_pending_label.toUtf8().constData(), result.base, result.base_chain, result.selection);
+  m_database.set_selection(result.selection, result.chain);
+  m_titles_model->reset(result.titles);
+  m_categories_model->reset(result.categories);
+  m_ingredients_model->reset(result.ingredients);
+  show_search_history();
+  show_num_recipes();
+}
+
+void MainWindow::search_failed(int serial, QString message) {
+  if (serial != m_search_serial || !m_searching)
+    return;
+  m_searching = false;
+  QGuiApplication::restoreOverrideCursor();
+  if (m_pending_filter.empty())
+    QMessageBox::critical(this, tr("Error Resetting Selection"), message);
+  else
+    QMessageBox::critical(this, tr("Error Filtering Recipes"), message);
+}
+
 string MainWindow::translate(const char *context, const char *text) {
   return QCoreApplication::translate(context, text).toUtf8().constData();
 }
 
 void MainWindow::selected(const QModelIndex &current, const QModelIndex &) {
-  try {
-    QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-    if (current.isValid()) {
-      Recipe recipe = m_database.fetch_recipe(m_titles_model->recipeid(current));
-      set_recipe(recipe);
-    } else {
-      m_ui.recipe_browser->clear();
-    };
-    QGuiApplication::restoreOverrideCursor();
-  } catch (exception &e) {
-    QGuiApplication::restoreOverrideCursor();
-    QMessageBox::critical(this, tr("Error fetching recipe"), e.what());
+  if (current.isValid()) {
+    m_fetch_serial = m_search_worker->next_fetch();
+    emit fetch(m_fetch_serial, m_titles_model->recipeid(current));
+  } else {
+    m_search_worker->next_fetch();
+    m_ui.recipe_browser->clear();
   };
 }
 
+void MainWindow::recipe_fetched(int serial, Recipe recipe) {
+  if (serial == m_fetch_serial)
+    set_recipe(recipe);
+}
+
+void MainWindow::fetch_failed(int serial, QString message) {
+  if (serial == m_fetch_serial)
+    QMessageBox::critical(this, tr("Error fetching recipe"), message);
+}
+
+void MainWindow::facets_counted(int serial, SearchResult result) {
+  if (serial != m_count_serial)
+    return;
+  m_categories_model->reset(result.categories);
+  m_ingredients_model->reset(result.ingredients);
+}
+
+void MainWindow::count_failed(int serial, QString message) {
+  if (serial == m_count_serial)
+    QMessageBox::critical(this, tr("Error counting recipes"), message);
+}
+
 void MainWindow::titles_context_menu(const QPoint &pos) {
   m_titles_context_menu->popup(m_ui.titles_view->viewport()->mapToGlobal(pos));
 }
@@ -531,9 +701,23 @@ void MainWindow::recipe_context_menu(const QPoint &pos) {
   m_recipe_context_menu->popup(m_ui.recipe_browser->viewport()->mapToGlobal(pos));
 }
 
+void MainWindow::select_all(void) {
+  m_ui.titles_view->selectAll();
+  m_all_selected = true;
+}
+
+void MainWindow::selection_changed(void) {
+  m_all_selected = false;
+}
+
 vector<sqlite3_int64> MainWindow::recipe_ids(void) {
   vector<sqlite3_int64> result;
   QItemSelectionModel *model = m_ui.titles_view->selectionModel();
+  // Load the remaining pages if the user selected all recipes.
+  if (m_all_selected && m_titles_model->canFetchMore(QModelIndex())) {
+    m_titles_model->fetch_all();
+    select_all();
+  };
   QModelIndexList lst = model->selectedRows();
   for (QModelIndexList::iterator index=lst.begin(); index!=lst.end(); index++) {
     result.push_back(m_titles_model->recipeid(*index));
@@ -541,6 +725,12 @@ vector<sqlite3_int64> MainWindow::recipe_ids(void) {
   return result;
 }
 
+vector<Recipe> MainWindow::fetch_batch(const vector<sqlite3_int64> &ids, unsigned int offset) {
+  vector<sqlite3_int64>::const_iterator end =
+    ids.size() - offset > FETCH_BATCH_SIZE ? ids.begin() + offset + FETCH_BATCH_SIZE : ids.end();
+  return m_database.fetch_recipes(vector<sqlite3_int64>(ids.begin() + offset, end));
+}
+
 void MainWindow::export_recipes(void) {
   vector<sqlite3_int64> ids = recipe_ids();
   if (!ids.empty()) {
@@ -558,10 +748,12 @@ void MainWindow::export_recipes(void) {
           ofstream output_file(result.toUtf8().constData(), ofstream::binary);
           QProgressDialog progress(tr("Exporting recipes ..."), tr("Cancel"), 0, ids.size(), this);
           progress.setWindowModality(Qt::WindowModal);
+          vector<Recipe> batch;
           for (unsigned int i=0; i<ids.size(); i++) {
             progress.setValue(i);
-            sqlite3_int64 id = ids[i];
-            Recipe recipe = m_database.fetch_recipe(id);
+            if (i % FETCH_BATCH_SIZE == 0)
+              batch = fetch_batch(ids, i);
+            Recipe recipe = batch[i % FETCH_BATCH_SIZE];
             try {
               Recipe recoded;
               if (m_export_dialog.encoding() == "UTF-8") {
@@ -615,8 +807,10 @@ void MainWindow::delete_recipes(void) {
         m_database.delete_recipes(ids);
         m_database.commit();
         transaction = false;
+        cancel_search();
+        forget_recipes(ids);
         m_titles_model->reset();
-        m_categories_model->reset();
+        refresh_facets();
         QGuiApplication::restoreOverrideCursor();
       } catch (exception &e) {
         try {
@@ -655,30 +849,55 @@ void MainWindow::render(QPrinter *printer) {
 
 void MainWindow::remove_duplicates(void) {
   vector<sqlite3_int64> ids = recipe_ids();
-  set<string> recipes;
-  vector<sqlite3_int64> recipes_to_delete;
-  QProgressDialog progress(tr("Detecting duplicates ..."), tr("Cancel"), 0, ids.size(), this);
-  progress.setWindowModality(Qt::WindowModal);
-  for (unsigned int i=0; i<ids.size(); i++) {
-    progress.setLabelText(tr("Found %1 duplicates ...").arg(recipes_to_delete.size()));
-    progress.setValue(i);
-    sqlite3_int64 id = ids[i];
-    Recipe recipe = m_database.fetch_recipe(id);
-    string txt = recipe_to_mealmaster(recipe);
-    if (recipes.find(txt) != recipes.end())
-      recipes_to_delete.push_back(id);
-    else
-      recipes.insert(txt);
-    if (progress.wasCanceled())
-      break;
-  };
-  if (!progress.wasCanceled()) {
+  bool transaction = false;
+  try {
     QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    // Group the recipes by content hash in the database.
+    vector<sqlite3_int64> recipes_to_delete = m_database.duplicates(ids);
     m_database.begin();
+    transaction = true;
     m_database.delete_recipes(recipes_to_delete);
     m_database.commit();
+    transaction = false;
+    cancel_search();
+    forget_recipes(recipes_to_delete);
     m_titles_model->reset();
-    m_categories_model->reset();
+    refresh_facets();
+    QGuiApplication::restoreOverrideCursor();
+  } catch (exception &e) {
+    try {
+      if (transaction)
+        m_database.rollback();
+    } catch (exception &) {
+    };
+    QGuiApplication::restoreOverrideCursor();
+    QMessageBox::critical(this, tr("Error Removing Duplicates"), e.what());
+  };
+}
+
+void MainWindow::show_near_duplicates(void) {
+  vector<sqlite3_int64> ids = recipe_ids();
+  try {
+    QGuiApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+    // Select the recipes which are similar to at least one other recipe.
+    NearDuplicates near_duplicates(MINHASH_BANDS, MINHASH_ROWS);
+    vector<vector<sqlite3_int64> > clusters =
+      near_duplicates.clusters(m_database.recipe_features(ids), SIMILARITY_THRESHOLD);
+    Bitmap selection;
+    for (vector<vector<sqlite3_int64> >::iterator cluster=clusters.begin(); cluster!=clusters.end(); cluster++)
+      for (vector<sqlite3_int64>::iterator id=cluster->begin(); id!=cluster->end(); id++)
+        selection.add(*id);
+    cancel_search();
+    QString label = tr("similar recipes").toHtmlEscaped();
+    m_search_history.push(label.toUtf8().constData(), m_database.selection(), m_database.chain(), selection);
+    m_database.set_selection(selection);
+    m_titles_model->reset();
+    refresh_facets();
+    show_search_history();
+    show_num_recipes();
+    QGuiApplication::restoreOverrideCursor();
+  } catch (exception &e) {
     QGuiApplication::restoreOverrideCursor();
+    QMessageBox::critical(this, tr("Error Finding Similar Recipes"), e.what());
   };
 }
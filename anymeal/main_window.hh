@@ -15,6 +15,7 @@
    along with this program.  If not, see <https://www.gnu.org/licenses/>. */
 #pragma once
 #include <vector>
+#include <QtCore/QThread>
 #include <QtCore/QTranslator>
 #include <QtWidgets/QMainWindow>
 #include <QtWidgets/QCompleter>
@@ -24,6 +25,8 @@
 #include "category_picker.hh"
 #include "titles_model.hh"
 #include "categories_model.hh"
+#include "search_worker.hh"
+#include "search_history.hh"
 #include "category_table_model.hh"
 #include "converter_window.hh"
 #include "import_dialog.hh"
@@ -48,16 +51,28 @@ class MainWindow: public QMainWindow
   Q_OBJECT
 public:
   MainWindow(QWidget *parent=NULL);
+  virtual ~MainWindow(void);
   static std::string translate(const char *context, const char *text);
   std::vector<sqlite3_int64> recipe_ids(void);
+  std::vector<Recipe> fetch_batch(const std::vector<sqlite3_int64> &ids, unsigned int offset);
   void show_num_recipes(void);
   EditMode editing_mode(void);
   Recipe default_recipe(void);
   void edit_recipe(EditMode mode);
-  void show_search_history(const char *type, const char *text);
+  void add_search_term(const QString &type, const QString &text);
+  void show_search_history(void);
   void reset_search_history(void);
+  void forget_recipes(const std::vector<sqlite3_int64> &ids);
+  void jump(size_t step);
   void switch_language(const QString &country);
   void set_recipe(Recipe recipe);
+  void start_search(bool all, const Filter &filter);
+  void cancel_search(void);
+  void refresh_facets(void);
+signals:
+  void search(int serial, bool all, Bitmap selection, std::string chain, Filter filter);
+  void fetch(int serial, qlonglong id);
+  void count(int serial, Bitmap selection);
 public slots:
   void import(void);
   void new_recipe(void);
@@ -65,8 +80,19 @@ public slots:
   void collect_garbage(void);
   void about(void);
   void filter(void);
+  void search_titles(const QString &text);
   void reset(void);
+  void jump_to_step(const QString &link);
+  void undo_filter(void);
+  void search_finished(int serial, SearchResult result);
+  void search_failed(int serial, QString message);
   void selected(const QModelIndex &current, const QModelIndex &previous);
+  void select_all(void);
+  void selection_changed(void);
+  void recipe_fetched(int serial, Recipe recipe);
+  void fetch_failed(int serial, QString message);
+  void facets_counted(int serial, SearchResult result);
+  void count_failed(int serial, QString message);
   void titles_context_menu(const QPoint &pos);
   void recipe_context_menu(const QPoint &pos);
   void export_recipes(void);
@@ -84,6 +110,7 @@ public slots:
   void language_sl(void);
   void open_converter(void);
   void remove_duplicates(void);
+  void show_near_duplicates(void);
 protected:
   bool eventFilter(QObject *object, QEvent *event);
   Ui::MainWindow m_ui;
@@ -98,6 +125,19 @@ protected:
   CategoriesModel *m_categories_model;
   CategoryTableModel *m_category_table_model;
   QCompleter *m_categories_completer;
+  FacetsModel *m_ingredients_model;
+  QCompleter *m_ingredients_completer;
   QMenu *m_titles_context_menu;
   QMenu *m_recipe_context_menu;
+  QThread m_search_thread;
+  SearchWorker *m_search_worker;
+  int m_search_serial;
+  int m_fetch_serial;
+  int m_count_serial;
+  bool m_searching;
+  bool m_pending_all;
+  bool m_all_selected;
+  Filter m_pending_filter;
+  QString m_pending_label;
+  SearchHistory m_search_history;
 };
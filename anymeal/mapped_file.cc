@@ -0,0 +1,110 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <cstring>
+#include <sstream>
+#ifndef _WIN32
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "mapped_file.hh"
+
+
+using namespace std;
+
+#ifdef _WIN32
+MappedFile::MappedFile(const char *file_name):
+  m_file(INVALID_HANDLE_VALUE), m_mapping(NULL), m_data(NULL), m_size(0)
+{
+  m_file = CreateFileA(file_name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (m_file == INVALID_HANDLE_VALUE)
+    error("Error opening file ", file_name);
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(m_file, &size))
+    error("Error getting size of file ", file_name);
+  m_size = size.QuadPart;
+  // Empty files cannot be mapped.
+  if (m_size > 0) {
+    m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (m_mapping == NULL)
+      error("Error mapping file ", file_name);
+    m_data = (const char *)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+    if (m_data == NULL)
+      error("Error mapping file ", file_name);
+  };
+}
+
+MappedFile::~MappedFile(void) {
+  release();
+}
+
+void MappedFile::release(void) {
+  if (m_data != NULL)
+    UnmapViewOfFile(m_data);
+  if (m_mapping != NULL)
+    CloseHandle(m_mapping);
+  if (m_file != INVALID_HANDLE_VALUE)
+    CloseHandle(m_file);
+}
+
+void MappedFile::error(const char *message, const char *file_name) {
+  ostringstream s;
+  s << message << file_name << ": error " << GetLastError();
+  release();
+  throw mapped_file_exception(s.str());
+}
+#else
+MappedFile::MappedFile(const char *file_name):
+  m_file(-1), m_data(NULL), m_size(0)
+{
+  m_file = open(file_name, O_RDONLY);
+  if (m_file < 0)
+    error("Error opening file ", file_name);
+  struct stat status;
+  if (fstat(m_file, &status))
+    error("Error getting size of file ", file_name);
+  m_size = status.st_size;
+  // Empty files cannot be mapped.
+  if (m_size > 0) {
+    void *data = mmap(NULL, m_size, PROT_READ, MAP_PRIVATE, m_file, 0);
+    if (data == MAP_FAILED)
+      error("Error mapping file ", file_name);
+    m_data = (const char *)data;
+    madvise(data, m_size, MADV_SEQUENTIAL);
+  };
+}
+
+MappedFile::~MappedFile(void) {
+  release();
+}
+
+void MappedFile::release(void) {
+  if (m_data != NULL)
+    munmap((void *)m_data, m_size);
+  if (m_file >= 0)
+    close(m_file);
+}
+
+void MappedFile::error(const char *message, const char *file_name) {
+  ostringstream s;
+  s << message << file_name << ": " << strerror(errno);
+  release();
+  throw mapped_file_exception(s.str());
+}
+#endif
@@ -0,0 +1,55 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <exception>
+#include <string>
+#include <string_view>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+
+class mapped_file_exception: public std::exception
+{
+public:
+  mapped_file_exception(const std::string &error): m_error(error) {}
+  virtual ~mapped_file_exception(void) throw() {}
+  virtual const char *what(void) const throw() { return m_error.c_str(); }
+protected:
+  std::string m_error;
+};
+
+// Read-only memory mapping of a whole file. The data pointer is NULL for an empty file.
+class MappedFile
+{
+public:
+  MappedFile(const char *file_name);
+  virtual ~MappedFile(void);
+  const char *data(void) const { return m_data; }
+  size_t size(void) const { return m_size; }
+  std::string_view text(void) const { return std::string_view(m_data, m_size); }
+protected:
+  void release(void);
+  void error(const char *message, const char *file_name);
+#ifdef _WIN32
+  HANDLE m_file;
+  HANDLE m_mapping;
+#else
+  int m_file;
+#endif
+  const char *m_data;
+  size_t m_size;
+};
@@ -16,7 +16,10 @@
 #pragma once
 #include <istream>
 #include <exception>
+#include <sstream>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "recipe.hh"
 
 
@@ -30,4 +33,34 @@ protected:
   std::string m_error;
 };
 
+// Parser state of the reentrant MealMaster scanner. Each thread needs its own parser.
+class MealMasterParser
+{
+public:
+  MealMasterParser(void);
+  virtual ~MealMasterParser(void);
+  Recipe parse(std::istream &stream);
+  Recipe parse(std::string_view text);
+  int read(char *buffer, int max_size);
+protected:
+  friend int yylex(void *scanner);
+  void reset(void);
+  int scan(void);
+  void flush_right_column(void);
+  void add_text_to_ingredient(const char *text);
+  void *m_scanner;
+  std::istream *m_stream;
+  std::string m_input;
+  Ingredient m_ingredient;
+  std::string m_right_continuation;
+  std::vector<Ingredient> m_right_column;
+  Recipe m_recipe;
+  int m_newlines;
+  std::string m_buffer;
+  std::string m_section;
+  std::ostringstream m_error_message;
+  int m_ingredient_column;
+  int m_line_no;
+};
+
 Recipe parse_mealmaster(std::istream &stream);
@@ -20,69 +20,14 @@
 #include "mealmaster.hh"
 
 // ftp://ftp.gnu.org/old-gnu/Manuals/flex-2.5.4/html_mono/flex.html
-std::istream *yystream;
-Ingredient ingredient_;
-std::string right_continuation;
-std::vector<Ingredient> right_column;
-Recipe recipe;
-int newlines;
-std::string buffer;
-std::string section;
-std::ostringstream error_message;
-int ingredient_column;
-
-extern int yylex(void);
-
-int line_no;
-
 #define YY_INPUT(buffer, result, max_size) { \
-  yystream->read(buffer, max_size); \
-  result = yystream->gcount(); \
-}
-
-Recipe parse_mealmaster(std::istream &stream) {
-  recipe = Recipe();
-  yystream = &stream;
-  line_no = 1;
-  error_message.str("");
-  error_message.clear();
-  newlines = 0;
-  ingredient_column = 0;
-  right_continuation.clear();
-  right_column.clear();
-  int result = yylex();
-  yyrestart(NULL);
-  yy_start = 1;
-  if (result)
-    throw parse_exception(error_message.str());
-  return recipe;
-}
-
-void flush_right_column(void) {
-  if (!recipe.ingredients().empty() && !right_continuation.empty()) {
-    recipe.ingredients().back().add_text(right_continuation.c_str());
-  };
-  for (std::vector<Ingredient>::iterator i=right_column.begin(); i!=right_column.end(); i++) {
-    recipe.add_ingredient(*i);
-  };
-  right_continuation.clear();
-  right_column.clear();
-}
-
-void add_text_to_ingredient(const char *text) {
-  if (ingredient_column) {
-    if (!right_column.empty())
-      right_column.back().add_text(text);
-    else
-      right_continuation += text;
-  } else {
-    assert(!recipe.ingredients().empty());
-    recipe.ingredients().back().add_text(text);
-  };
+  result = yyextra->read(buffer, max_size); \
 }
 
 %}
 
+%option reentrant
+%option extra-type="MealMasterParser *"
 %option noyywrap
 %option never-interactive
 %option nostdinit
@@ -99,31 +44,32 @@ NOSPACEMINUS [!-,\.-\xFF]
 NOSLASH [ -\.0-\xFF]
 
 %%
+  MealMasterParser &parser = *yyextra;
 
 <INITIAL>(MMMMM|-----)[^\r\n]*[Mm][Ee][Aa][Ll]-[Mm][Aa][Ss][Tt][Ee][Rr][^\r\n]*\r?\n {
-  line_no++;
+  parser.m_line_no++;
   BEGIN(title);
 }
 
 <INITIAL>\r?\n {
-  line_no++;
+  parser.m_line_no++;
 }
 
 <INITIAL>.
 
 <title>" "
 <title>\r?\n {
-  line_no++;
+  parser.m_line_no++;
 }
 <title>"Title:"" "+ {
   BEGIN(titletext);
 }
 
 <titletext>{CHAR}* {
-  recipe.set_title(yytext);
+  parser.m_recipe.set_title(yytext);
 }
 <titletext>\r?\n {
-  line_no++;
+  parser.m_line_no++;
   BEGIN(categories);
 }
 
@@ -134,11 +80,11 @@ NOSLASH [ -\.0-\xFF]
 }
 
 <categoriestext>{NOCOMMA}* {
-  recipe.add_category(yytext);
+  parser.m_recipe.add_category(yytext);
 }
 <categoriestext>,\ *
 <categoriestext>\r?\n {
-  line_no++;
+  parser.m_line_no++;
   BEGIN(servings);
 }
 
@@ -148,70 +94,70 @@ NOSLASH [ -\.0-\xFF]
 }
 
 <servingsamount>[0-9]+ {
-  recipe.set_servings(atoi(yytext));
+  parser.m_recipe.set_servings(atoi(yytext));
   BEGIN(servingsunit);
 }
 
 <servingsunit>" "
 <servingsunit>{NOSPACE}{CHAR}* {
-  recipe.set_servings_unit(yytext);
+  parser.m_recipe.set_servings_unit(yytext);
 }
 <servingsunit>\r?\n {
-  line_no++;
-  ingredient_ = Ingredient();
-  buffer.clear();
+  parser.m_line_no++;
+  parser.m_ingredient = Ingredient();
+  parser.m_buffer.clear();
   BEGIN(head);
 }
 
 <head,rest>\ *\r?\n {
-  line_no++;
-  ingredient_column = 0;
-  if (!recipe.instructions().empty())
-    newlines++;
+  parser.m_line_no++;
+  parser.m_ingredient_column = 0;
+  if (!parser.m_recipe.instructions().empty())
+    parser.m_newlines++;
 }
 <head>\ {0,6}[0-9]+ {
-  buffer += yytext;
-  ingredient_.set_amount_integer(atoi(yytext));
+  parser.m_buffer += yytext;
+  parser.m_ingredient.set_amount_integer(atoi(yytext));
   BEGIN(amount);
 }
 <head>\ {0,6}[0-9]*\.[0-9]* {
-  buffer += yytext;
-  ingredient_.set_amount_float(atof(yytext));
+  parser.m_buffer += yytext;
+  parser.m_ingredient.set_amount_float(atof(yytext));
   BEGIN(unit1);
 }
 <head>\ {7} {
-  buffer += yytext;
+  parser.m_buffer += yytext;
   BEGIN(unit1);
 }
 <head>\ {11}-\ * {
-  buffer += yytext;
-  if (!recipe.ingredients().empty()) {
-    if (!recipe.ingredient_sections().empty() && recipe.ingredient_sections().back().first == recipe.ingredients().size()) {
+  parser.m_buffer += yytext;
+  if (!parser.m_recipe.ingredients().empty()) {
+    if (!parser.m_recipe.ingredient_sections().empty() && parser.m_recipe.ingredient_sections().back().first == parser.m_recipe.ingredients().size()) {
       unput('-');
-      ingredient_.set_unit("  ");
+      parser.m_ingredient.set_unit("  ");
       BEGIN(ingredienttext);
     } else {
-      add_text_to_ingredient(" ");
+      parser.add_text_to_ingredient(" ");
       BEGIN(ingredientcont);
     };
   } else {
     unput('-');
-    ingredient_.set_unit("  ");
+    parser.m_ingredient.set_unit("  ");
     BEGIN(ingredienttext);
   };
 }
 <head>\ {11} {
-  buffer += yytext;
-  if (recipe.instructions().empty()) {
-    ingredient_.set_unit("  ");
+  parser.m_buffer += yytext;
+  if (parser.m_recipe.instructions().empty()) {
+    parser.m_ingredient.set_unit("  ");
     BEGIN(ingredienttext);
   } else {
     BEGIN(instructionstext);
   };
 }
 <head,rest>(MMMMM|-----)-+\ * {
-  section.clear();
-  flush_right_column();
+  parser.m_section.clear();
+  parser.flush_right_column();
   BEGIN(sectionheader);
 }
 <head,rest>{CHAR} {
@@ -219,21 +165,21 @@ NOSLASH [ -\.0-\xFF]
   BEGIN(instructionstext);
 }
 <head,rest>(MMMMM|-----)\r?\n {
-  line_no++;
-  flush_right_column();
+  parser.m_line_no++;
+  parser.flush_right_column();
   BEGIN(INITIAL);
   return 0;
 }
 
 <amount>\/ {
-  buffer += yytext;
-  ingredient_.set_amount_numerator(ingredient_.amount_integer());
-  ingredient_.set_amount_integer(0);
+  parser.m_buffer += yytext;
+  parser.m_ingredient.set_amount_numerator(parser.m_ingredient.amount_integer());
+  parser.m_ingredient.set_amount_integer(0);
   BEGIN(fraction);
 }
 <amount>\ [0-9]+ {
-  buffer += yytext;
-  ingredient_.set_amount_numerator(atoi(yytext));
+  parser.m_buffer += yytext;
+  parser.m_ingredient.set_amount_numerator(atoi(yytext));
   BEGIN(amount2);
 }
 <amount>\r?\n {
@@ -246,7 +192,7 @@ NOSLASH [ -\.0-\xFF]
 }
 
 <amount2>\/ {
-  buffer += yytext;
+  parser.m_buffer += yytext;
   BEGIN(fraction);
 }
 <amount2>{NOSLASH} {
@@ -259,8 +205,8 @@ NOSLASH [ -\.0-\xFF]
 }
 
 <fraction>[0-9]+ {
-  buffer += yytext;
-  ingredient_.set_amount_denominator(atoi(yytext));
+  parser.m_buffer += yytext;
+  parser.m_ingredient.set_amount_denominator(atoi(yytext));
   BEGIN(unit1);
 }
 <fraction>[^0-9] {
@@ -273,7 +219,7 @@ NOSLASH [ -\.0-\xFF]
 }
 
 <unit1>" " {
-  buffer += yytext;
+  parser.m_buffer += yytext;
   BEGIN(unit2);
 }
 <unit1>[^ ] {
@@ -286,8 +232,8 @@ NOSLASH [ -\.0-\xFF]
 }
 
 <unit2>{UNIT} {
-  buffer += yytext;
-  ingredient_.set_unit(yytext);
+  parser.m_buffer += yytext;
+  parser.m_ingredient.set_unit(yytext);
   BEGIN(unit3);
 }
 <unit2>. {
@@ -300,8 +246,8 @@ NOSLASH [ -\.0-\xFF]
 }
 
 <unit3>" " {
-  buffer += yytext;
-  if (buffer.length() == 11) {
+  parser.m_buffer += yytext;
+  if (parser.m_buffer.length() == 11) {
     BEGIN(ingredienttext);
   } else {
     BEGIN(instructionstext);
@@ -317,166 +263,256 @@ NOSLASH [ -\.0-\xFF]
 }
 
 <ingredienttext>{NOSPACE}* {
-  buffer += yytext;
-  ingredient_.add_text(yytext);
+  parser.m_buffer += yytext;
+  parser.m_ingredient.add_text(yytext);
 }
 <ingredienttext>" " {
-  buffer += yytext;
-  if (buffer.length() == 41) {
-    while (!ingredient_.text().empty() && ingredient_.text()[ingredient_.text().length() - 1] == ' ')
-      ingredient_.text() = ingredient_.text().substr(0, ingredient_.text().length() - 1);
-    recipe.add_ingredient(ingredient_);
-    ingredient_ = Ingredient();
-    ingredient_column = 1;
-    buffer.clear();
+  parser.m_buffer += yytext;
+  if (parser.m_buffer.length() == 41) {
+    while (!parser.m_ingredient.text().empty() && parser.m_ingredient.text()[parser.m_ingredient.text().length() - 1] == ' ')
+      parser.m_ingredient.text() = parser.m_ingredient.text().substr(0, parser.m_ingredient.text().length() - 1);
+    parser.m_recipe.add_ingredient(parser.m_ingredient);
+    parser.m_ingredient = Ingredient();
+    parser.m_ingredient_column = 1;
+    parser.m_buffer.clear();
     BEGIN(head);
   } else
-    ingredient_.add_text(yytext);
+    parser.m_ingredient.add_text(yytext);
 }
 <ingredienttext>\r?\n {
-  line_no++;
-  if (ingredient_column)
-    right_column.push_back(ingredient_);
+  parser.m_line_no++;
+  if (parser.m_ingredient_column)
+    parser.m_right_column.push_back(parser.m_ingredient);
   else
-    recipe.add_ingredient(ingredient_);
+    parser.m_recipe.add_ingredient(parser.m_ingredient);
   BEGIN(head);
-  ingredient_column = 0;
-  ingredient_ = Ingredient();
-  buffer.clear();
+  parser.m_ingredient_column = 0;
+  parser.m_ingredient = Ingredient();
+  parser.m_buffer.clear();
 }
 
 <ingredientcont>{NOSPACE}* {
-  buffer += yytext;
-  add_text_to_ingredient(yytext);
+  parser.m_buffer += yytext;
+  parser.add_text_to_ingredient(yytext);
 }
 <ingredientcont>" " {
-  buffer += yytext;
-  if (buffer.length() == 41) {
-    while (!recipe.ingredients().back().text().empty() && recipe.ingredients().back().text()[recipe.ingredients().back().text().length() - 1] == ' ') {
-      std::string text = recipe.ingredients().back().text();
-      recipe.ingredients().back().text() = text.substr(0, text.length() - 1);
+  parser.m_buffer += yytext;
+  if (parser.m_buffer.length() == 41) {
+    while (!parser.m_recipe.ingredients().back().text().empty() && parser.m_recipe.ingredients().back().text()[parser.m_recipe.ingredients().back().text().length() - 1] == ' ') {
+      std::string text = parser.m_recipe.ingredients().back().text();
+      parser.m_recipe.ingredients().back().text() = text.substr(0, text.length() - 1);
     };
-    ingredient_column = 1;
-    buffer.clear();
+    parser.m_ingredient_column = 1;
+    parser.m_buffer.clear();
     BEGIN(head);
   } else
-    add_text_to_ingredient(" ");
+    parser.add_text_to_ingredient(" ");
 }
 <ingredientcont>\r?\n {
-  line_no++;
-  ingredient_ = Ingredient();
-  buffer.clear();
-  ingredient_column = 0;
+  parser.m_line_no++;
+  parser.m_ingredient = Ingredient();
+  parser.m_buffer.clear();
+  parser.m_ingredient_column = 0;
   BEGIN(head);
 }
 
 <sectionheader>\ *-*\ *\r?\n {
-  line_no++;
+  parser.m_line_no++;
   // Add a section to the ingredients or to the instructions.
-  if (recipe.instructions().empty()) {
-    if (!recipe.ingredient_sections().empty() && recipe.ingredient_sections().back().first == recipe.ingredients().size()) {
-      error_message << "Empty ingredient section in line " << line_no;
+  if (parser.m_recipe.instructions().empty()) {
+    if (!parser.m_recipe.ingredient_sections().empty() && parser.m_recipe.ingredient_sections().back().first == parser.m_recipe.ingredients().size()) {
+      parser.m_error_message << "Empty ingredient section in line " << parser.m_line_no;
       BEGIN(error);
     } else {
-      recipe.add_ingredient_section(recipe.ingredients().size(), section.c_str());
+      parser.m_recipe.add_ingredient_section(parser.m_recipe.ingredients().size(), parser.m_section.c_str());
       BEGIN(head);
     };
   } else {
-    recipe.add_instruction_section(recipe.instructions().size(), section.c_str());
-    recipe.add_instruction("");
+    parser.m_recipe.add_instruction_section(parser.m_recipe.instructions().size(), parser.m_section.c_str());
+    parser.m_recipe.add_instruction("");
     BEGIN(instructionstext);
   };
-  newlines = 0;
-  ingredient_ = Ingredient();
-  buffer.clear();
+  parser.m_newlines = 0;
+  parser.m_ingredient = Ingredient();
+  parser.m_buffer.clear();
 }
 <sectionheader>{NOSPACEMINUS}* {
-  section += yytext;
+  parser.m_section += yytext;
 }
 <sectionheader>[- ] {
-  section += yytext;
+  parser.m_section += yytext;
 }
 
 <instructionstext>{CHAR}* {
-  buffer += yytext;
+  parser.m_buffer += yytext;
 }
 <instructionstext>\x09 {
-  buffer += "    ";
+  parser.m_buffer += "    ";
 }
 <instructionstext>\r?\n {
-  line_no++;
-  if (ingredient_column) {
+  parser.m_line_no++;
+  if (parser.m_ingredient_column) {
     // Overlong ingredient line.
-    recipe.ingredients().back().add_text(" ");
-    recipe.ingredients().back().add_text(buffer.c_str());
+    parser.m_recipe.ingredients().back().add_text(" ");
+    parser.m_recipe.ingredients().back().add_text(parser.m_buffer.c_str());
     BEGIN(head);
   } else {
     // Remove up to two leading spaces.
     for (int i=0; i<2; i++) {
-      if (!buffer.empty() && buffer[0] == ' ')
-        buffer = buffer.substr(1, buffer.length() - 1);
+      if (!parser.m_buffer.empty() && parser.m_buffer[0] == ' ')
+        parser.m_buffer = parser.m_buffer.substr(1, parser.m_buffer.length() - 1);
     };
     // Remove trailing spaces.
-    while (!buffer.empty() && buffer[buffer.length() - 1] == ' ')
-      buffer = buffer.substr(0, buffer.length() - 1);
+    while (!parser.m_buffer.empty() && parser.m_buffer[parser.m_buffer.length() - 1] == ' ')
+      parser.m_buffer = parser.m_buffer.substr(0, parser.m_buffer.length() - 1);
     bool force_newline;
     // A colon forces a new line.
-    if (!buffer.empty() && buffer[0] == ':') {
+    if (!parser.m_buffer.empty() && parser.m_buffer[0] == ':') {
       force_newline = true;
-      buffer = buffer.substr(1, buffer.length() - 1);
-    } else if (!buffer.empty() && buffer[0] == ' ') {
+      parser.m_buffer = parser.m_buffer.substr(1, parser.m_buffer.length() - 1);
+    } else if (!parser.m_buffer.empty() && parser.m_buffer[0] == ' ') {
       force_newline = true;
     } else
       force_newline = false;
-    if (newlines >= 1) {
-      recipe.add_instruction("");
-      recipe.add_instruction(buffer.c_str());
+    if (parser.m_newlines >= 1) {
+      parser.m_recipe.add_instruction("");
+      parser.m_recipe.add_instruction(parser.m_buffer.c_str());
     } else {
-      if (recipe.instructions().size() && !force_newline)
-        recipe.append_instruction(buffer.c_str());
+      if (parser.m_recipe.instructions().size() && !force_newline)
+        parser.m_recipe.append_instruction(parser.m_buffer.c_str());
       else
-        recipe.add_instruction(buffer.c_str());
+        parser.m_recipe.add_instruction(parser.m_buffer.c_str());
     };
-    if (!recipe.ingredient_sections().empty()) {
-      std::pair<int, std::string> section = recipe.ingredient_sections().back();
+    if (!parser.m_recipe.ingredient_sections().empty()) {
+      std::pair<int, std::string> last = parser.m_recipe.ingredient_sections().back();
       // If there is a section at the end of the ingredients, it needs to be moved into the list of instruction sections.
-      if (section.first == recipe.ingredients().size()) {
-        recipe.ingredient_sections().pop_back();
-        recipe.add_instruction_section(0, section.second.c_str());
+      if (last.first == parser.m_recipe.ingredients().size()) {
+        parser.m_recipe.ingredient_sections().pop_back();
+        parser.m_recipe.add_instruction_section(0, last.second.c_str());
       };
     };
     BEGIN(rest);
   };
-  newlines = 0;
-  ingredient_column = 0;
-  ingredient_ = Ingredient();
-  buffer.clear();
+  parser.m_newlines = 0;
+  parser.m_ingredient_column = 0;
+  parser.m_ingredient = Ingredient();
+  parser.m_buffer.clear();
 }
 
 <error>.
 <error>\r?\n {
-  line_no++;
+  parser.m_line_no++;
 }
 
 <*>\x14
 
 <*>. {
-  error_message << "Problem in state " << YY_START << " and line " << line_no << ": unexpected character ";
+  parser.m_error_message << "Problem in state " << YY_START << " and line " << parser.m_line_no << ": unexpected character ";
   if (*yytext < ' ')
-    error_message << "0x" << std::hex << (int)*yytext << std::dec;
+    parser.m_error_message << "0x" << std::hex << (int)*yytext << std::dec;
   else
-    error_message << "'" << *yytext << "'";
+    parser.m_error_message << "'" << *yytext << "'";
   BEGIN(error);
 }
 
 <*>\r?\n {
-  error_message << "Problem in state " << YY_START << " and line " << line_no << ": unexpected newline";
+  parser.m_error_message << "Problem in state " << YY_START << " and line " << parser.m_line_no << ": unexpected newline";
   BEGIN(error);
 }
 
 <*><<EOF>> {
-  if (error_message.str().empty())
-    error_message << "Unexpected end of file";
+  if (parser.m_error_message.str().empty())
+    parser.m_error_message << "Unexpected end of file";
   return 1;
 }
 %%
+
+MealMasterParser::MealMasterParser(void): m_stream(NULL), m_newlines(0), m_ingredient_column(0), m_line_no(1) {
+  yylex_init_extra(this, &m_scanner);
+}
+
+MealMasterParser::~MealMasterParser(void) {
+  yylex_destroy(m_scanner);
+}
+
+int MealMasterParser::read(char *buffer, int max_size) {
+  m_stream->read(buffer, max_size);
+  return m_stream->gcount();
+}
+
+void MealMasterParser::reset(void) {
+  m_recipe = Recipe();
+  m_line_no = 1;
+  m_error_message.str("");
+  m_error_message.clear();
+  m_newlines = 0;
+  m_ingredient_column = 0;
+  m_right_continuation.clear();
+  m_right_column.clear();
+}
+
+int MealMasterParser::scan(void) {
+  struct yyguts_t *yyg = (struct yyguts_t *)m_scanner;
+  BEGIN(INITIAL);
+  return yylex(m_scanner);
+}
+
+Recipe MealMasterParser::parse(std::istream &stream) {
+  reset();
+  m_stream = &stream;
+  // Discard input left over from the previous recipe and start in the initial state.
+  yyrestart(NULL, m_scanner);
+  int result = scan();
+  m_stream = NULL;
+  if (result)
+    throw parse_exception(m_error_message.str());
+  return m_recipe;
+}
+
+Recipe MealMasterParser::parse(std::string_view text) {
+  reset();
+  // Flex modifies the buffer while scanning and needs two terminating NUL characters. The buffer is reused for the
+  // next recipe. The end marker of a recipe at the end of the file might be missing the line break.
+  m_input.assign(text.data(), text.size());
+  if (!m_input.empty() && m_input.back() != '\n')
+    m_input += "\r\n";
+  m_input.append(2, '\0');
+  // Release the buffer of a previously parsed stream. Switching to the memory buffer would otherwise leak it.
+  struct yyguts_t *yyg = (struct yyguts_t *)m_scanner;
+  if (YY_CURRENT_BUFFER)
+    yy_delete_buffer(YY_CURRENT_BUFFER, m_scanner);
+  YY_BUFFER_STATE buffer = yy_scan_buffer(&m_input[0], m_input.size(), m_scanner);
+  int result = scan();
+  yy_delete_buffer(buffer, m_scanner);
+  if (result)
+    throw parse_exception(m_error_message.str());
+  return m_recipe;
+}
+
+void MealMasterParser::flush_right_column(void) {
+  if (!m_recipe.ingredients().empty() && !m_right_continuation.empty()) {
+    m_recipe.ingredients().back().add_text(m_right_continuation.c_str());
+  };
+  for (std::vector<Ingredient>::iterator i=m_right_column.begin(); i!=m_right_column.end(); i++) {
+    m_recipe.add_ingredient(*i);
+  };
+  m_right_continuation.clear();
+  m_right_column.clear();
+}
+
+void MealMasterParser::add_text_to_ingredient(const char *text) {
+  if (m_ingredient_column) {
+    if (!m_right_column.empty())
+      m_right_column.back().add_text(text);
+    else
+      m_right_continuation += text;
+  } else {
+    assert(!m_recipe.ingredients().empty());
+    m_recipe.ingredients().back().add_text(text);
+  };
+}
+
+Recipe parse_mealmaster(std::istream &stream) {
+  MealMasterParser parser;
+  return parser.parse(stream);
+}
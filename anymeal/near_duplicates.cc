@@ -0,0 +1,223 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <algorithm>
+#include <cctype>
+#include <thread>
+#include "near_duplicates.hh"
+
+
+using namespace std;
+
+#define INGREDIENT_FEATURE 0x8000000000000000ULL
+#define MAX_BUCKET_PAIRS 64
+
+static uint64_t mix(uint64_t x) {
+  // Finalizer of SplitMix64.
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ULL;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebULL;
+  x ^= x >> 31;
+  return x;
+}
+
+vector<uint64_t> title_features(const char *title) {
+  // FNV-1a hashes of the lower case words.
+  vector<uint64_t> result;
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  bool word = false;
+  for (const char *p=title; ; p++) {
+    unsigned char c = *p;
+    if (c >= 0x80 || isalnum(c)) {
+      hash = (hash ^ (unsigned char)tolower(c)) * 0x100000001b3ULL;
+      word = true;
+    } else {
+      if (word)
+        result.push_back(hash & ~INGREDIENT_FEATURE);
+      hash = 0xcbf29ce484222325ULL;
+      word = false;
+      if (!c)
+        break;
+    };
+  };
+  return result;
+}
+
+uint64_t ingredient_feature(sqlite3_int64 ingredient_id) {
+  return (uint64_t)ingredient_id | INGREDIENT_FEATURE;
+}
+
+double jaccard(const vector<uint64_t> &a, const vector<uint64_t> &b) {
+  size_t common = 0;
+  vector<uint64_t>::const_iterator i = a.begin();
+  vector<uint64_t>::const_iterator j = b.begin();
+  while (i != a.end() && j != b.end()) {
+    if (*i < *j)
+      i++;
+    else if (*j < *i)
+      j++;
+    else {
+      common++;
+      i++;
+      j++;
+    };
+  };
+  size_t total = a.size() + b.size() - common;
+  return total == 0 ? 0.0 : (double)common / total;
+}
+
+NearDuplicates::NearDuplicates(int bands, int rows, int threads): m_bands(bands), m_rows(rows), m_threads(threads) {
+  if (m_threads <= 0)
+    m_threads = max(1, (int)thread::hardware_concurrency());
+  for (int i=0; i<bands * rows; i++)
+    m_seeds.push_back(mix(i + 1));
+}
+
+vector<uint32_t> NearDuplicates::signature(const vector<uint64_t> &features) const {
+  vector<uint32_t> result(m_seeds.size(), UINT32_MAX);
+  for (vector<uint64_t>::const_iterator feature=features.begin(); feature!=features.end(); feature++)
+    for (size_t i=0; i<m_seeds.size(); i++) {
+      uint32_t value = mix(*feature ^ m_seeds[i]) >> 32;
+      if (value < result[i])
+        result[i] = value;
+    };
+  return result;
+}
+
+void NearDuplicates::signatures(const vector<RecipeFeatures> &recipes, size_t begin, size_t end,
+                                vector<uint32_t> &result) const {
+  for (size_t i=begin; i<end; i++) {
+    vector<uint32_t> values = signature(recipes[i].features);
+    copy(values.begin(), values.end(), result.begin() + i * m_seeds.size());
+  };
+}
+
+void NearDuplicates::candidates(const vector<uint32_t> &signatures, size_t count, int band,
+                                vector<pair<uint32_t, uint32_t> > &result) const {
+  // Sort the recipes by the hash of the band and pair up the recipes in each bucket.
+  vector<pair<uint64_t, uint32_t> > buckets;
+  buckets.reserve(count);
+  for (size_t i=0; i<count; i++) {
+    uint64_t hash = band;
+    for (int j=0; j<m_rows; j++)
+      hash = mix(hash ^ signatures[i * m_seeds.size() + band * m_rows + j]);
+    buckets.push_back(make_pair(hash, i));
+  };
+  sort(buckets.begin(), buckets.end());
+  size_t start = 0;
+  while (start < buckets.size()) {
+    size_t stop = start + 1;
+    while (stop < buckets.size() && buckets[stop].first == buckets[start].first)
+      stop++;
+    // Large buckets only pair each recipe with the first and the next one to avoid a quadratic number of pairs.
+    if (stop - start <= MAX_BUCKET_PAIRS) {
+      for (size_t i=start; i<stop; i++)
+        for (size_t j=i+1; j<stop; j++)
+          result.push_back(make_pair(buckets[i].second, buckets[j].second));
+    } else {
+      for (size_t i=start+1; i<stop; i++) {
+        result.push_back(make_pair(buckets[start].second, buckets[i].second));
+        if (i + 1 < stop)
+          result.push_back(make_pair(buckets[i].second, buckets[i + 1].second));
+      };
+    };
+    start = stop;
+  };
+}
+
+void NearDuplicates::bands_candidates(const vector<uint32_t> &signatures, size_t count, int first,
+                                      vector<vector<pair<uint32_t, uint32_t> > > &result) const {
+  for (int band=first; band<m_bands; band+=m_threads)
+    candidates(signatures, count, band, result[band]);
+}
+
+void NearDuplicates::check(const vector<RecipeFeatures> &recipes, const vector<pair<uint32_t, uint32_t> > &pairs,
+                           size_t begin, size_t end, double threshold, vector<char> &similar) {
+  for (size_t i=begin; i<end; i++)
+    similar[i] = jaccard(recipes[pairs[i].first].features, recipes[pairs[i].second].features) >= threshold;
+}
+
+static size_t root(vector<size_t> &parents, size_t i) {
+  while (parents[i] != i) {
+    parents[i] = parents[parents[i]];
+    i = parents[i];
+  };
+  return i;
+}
+
+vector<vector<sqlite3_int64> > NearDuplicates::clusters(const vector<RecipeFeatures> &recipes, double threshold) const {
+  // Recipes without features are never similar to each other.
+  vector<RecipeFeatures> nonempty;
+  for (vector<RecipeFeatures>::const_iterator recipe=recipes.begin(); recipe!=recipes.end(); recipe++)
+    if (!recipe->features.empty())
+      nonempty.push_back(*recipe);
+  size_t count = nonempty.size();
+  // Compute the signatures in parallel.
+  vector<uint32_t> values(count * m_seeds.size());
+  vector<thread> threads;
+  size_t chunk = (count + m_threads - 1) / m_threads;
+  for (int t=0; t<m_threads; t++) {
+    size_t begin = min(count, t * chunk);
+    size_t end = min(count, begin + chunk);
+    threads.push_back(thread(&NearDuplicates::signatures, this, cref(nonempty), begin, end, ref(values)));
+  };
+  for (vector<thread>::iterator t=threads.begin(); t!=threads.end(); t++)
+    t->join();
+  threads.clear();
+  // Collect candidate pairs of each band in parallel.
+  vector<vector<pair<uint32_t, uint32_t> > > pairs(m_bands);
+  for (int t=0; t<m_threads; t++)
+    threads.push_back(thread(&NearDuplicates::bands_candidates, this, cref(values), count, t, ref(pairs)));
+  for (vector<thread>::iterator t=threads.begin(); t!=threads.end(); t++)
+    t->join();
+  threads.clear();
+  vector<pair<uint32_t, uint32_t> > all;
+  for (int band=0; band<m_bands; band++)
+    all.insert(all.end(), pairs[band].begin(), pairs[band].end());
+  for (vector<pair<uint32_t, uint32_t> >::iterator p=all.begin(); p!=all.end(); p++)
+    if (p->first > p->second)
+      swap(p->first, p->second);
+  sort(all.begin(), all.end());
+  all.erase(unique(all.begin(), all.end()), all.end());
+  // Check the similarity of the candidates in parallel.
+  vector<char> similar(all.size());
+  chunk = (all.size() + m_threads - 1) / m_threads;
+  for (int t=0; t<m_threads; t++) {
+    size_t begin = min(all.size(), t * chunk);
+    size_t end = min(all.size(), begin + chunk);
+    threads.push_back(thread(&NearDuplicates::check, cref(nonempty), cref(all), begin, end, threshold, ref(similar)));
+  };
+  for (vector<thread>::iterator t=threads.begin(); t!=threads.end(); t++)
+    t->join();
+  // Merge similar recipes into clusters.
+  vector<size_t> parents(count);
+  for (size_t i=0; i<count; i++)
+    parents[i] = i;
+  for (size_t i=0; i<all.size(); i++)
+    if (similar[i])
+      parents[root(parents, all[i].second)] = root(parents, all[i].first);
+  vector<vector<sqlite3_int64> > members(count);
+  for (size_t i=0; i<count; i++)
+    members[root(parents, i)].push_back(nonempty[i].id);
+  vector<vector<sqlite3_int64> > result;
+  for (size_t i=0; i<count; i++)
+    if (members[i].size() > 1) {
+      sort(members[i].begin(), members[i].end());
+      result.push_back(members[i]);
+    };
+  sort(result.begin(), result.end());
+  return result;
+}
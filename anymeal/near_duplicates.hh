@@ -0,0 +1,56 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <vector>
+#include <stdint.h>
+#include <sqlite3.h>
+
+
+// Sorted set of features of a recipe. Features are the ids of the ingredients and hashes of the words in the title.
+struct RecipeFeatures {
+  sqlite3_int64 id;
+  std::vector<uint64_t> features;
+};
+
+std::vector<uint64_t> title_features(const char *title);
+
+uint64_t ingredient_feature(sqlite3_int64 ingredient_id);
+
+double jaccard(const std::vector<uint64_t> &a, const std::vector<uint64_t> &b);
+
+// Finds clusters of similar recipes. Recipes sharing all MinHash values of at least one band are candidates. The
+// Jaccard similarity of the candidates is checked exactly.
+class NearDuplicates
+{
+public:
+  NearDuplicates(int bands, int rows, int threads=0);
+  int bands(void) const { return m_bands; }
+  int rows(void) const { return m_rows; }
+  std::vector<uint32_t> signature(const std::vector<uint64_t> &features) const;
+  std::vector<std::vector<sqlite3_int64> > clusters(const std::vector<RecipeFeatures> &recipes, double threshold) const;
+protected:
+  void signatures(const std::vector<RecipeFeatures> &recipes, size_t begin, size_t end, std::vector<uint32_t> &result) const;
+  void candidates(const std::vector<uint32_t> &signatures, size_t count, int band,
+                  std::vector<std::pair<uint32_t, uint32_t> > &result) const;
+  void bands_candidates(const std::vector<uint32_t> &signatures, size_t count, int first,
+                        std::vector<std::vector<std::pair<uint32_t, uint32_t> > > &result) const;
+  static void check(const std::vector<RecipeFeatures> &recipes, const std::vector<std::pair<uint32_t, uint32_t> > &pairs,
+                    size_t begin, size_t end, double threshold, std::vector<char> &similar);
+  int m_bands;
+  int m_rows;
+  int m_threads;
+  std::vector<uint64_t> m_seeds;
+};
@@ -13,30 +13,105 @@
 
    You should have received a copy of the GNU General Public License
    along with this program.  If not, see <https://www.gnu.org/licenses/>. */
-#include <sstream>
+#include <cstring>
 #include "partition.hh"
+#include "boundary_scanner.hh"
 
 
 using namespace std;
 
-vector<string> recipes(istream &stream) {
-  vector<string> result;
-  ostringstream recipe;
-  string line;
+Partitioner::Partitioner(istream &stream, size_t read_ahead):
+  m_stream(stream), m_begin(0), m_end(0), m_read_ahead(read_ahead)
+{
+  if (m_read_ahead < 1)
+    m_read_ahead = 1;
+}
+
+bool Partitioner::next_line(const char *&line, size_t &length) {
+  size_t scanned = m_begin;
+  while (true) {
+    const char *newline = scanned < m_end ? (const char *)memchr(m_buffer.data() + scanned, '\n', m_end - scanned) : NULL;
+    if (newline) {
+      line = m_buffer.data() + m_begin;
+      length = newline - line;
+      m_begin += length + 1;
+      break;
+    };
+    if (!m_stream) {
+      // Return the last line even if it is not terminated.
+      if (m_begin == m_end)
+        return false;
+      line = m_buffer.data() + m_begin;
+      length = m_end - m_begin;
+      m_begin = m_end;
+      break;
+    };
+    // Move the incomplete line to the start of the buffer and read more data.
+    scanned = m_end - m_begin;
+    if (m_begin > 0) {
+      memmove(m_buffer.data(), m_buffer.data() + m_begin, scanned);
+      m_begin = 0;
+      m_end = scanned;
+    };
+    if (m_buffer.size() < m_end + m_read_ahead)
+      m_buffer.resize(m_end + m_read_ahead);
+    m_stream.read(m_buffer.data() + m_end, m_read_ahead);
+    m_end += m_stream.gcount();
+  };
+  if (length > 0 && line[length - 1] == '\r')
+    length--;
+  return true;
+}
+
+bool Partitioner::next(string &recipe) {
+  recipe.clear();
+  const char *line;
+  size_t length;
   bool on = false;
-  while (getline(stream, line)) {
-    if (!line.empty() && *line.rbegin() == '\r')
-      line.erase(line.length() - 1, 1);
-    if ((line.rfind("MMMMM", 0) == 0 || line.rfind("-----", 0) == 0) && line.length() > 5)
+  while (next_line(line, length)) {
+    if (length > 5 && (strncmp(line, "MMMMM", 5) == 0 || strncmp(line, "-----", 5) == 0))
       on = true;
-    if (on)
-      recipe << line << "\r\n";
+    if (on) {
+      recipe.append(line, length);
+      recipe.append("\r\n");
+    };
+    if (length == 5 && (strncmp(line, "MMMMM", 5) == 0 || strncmp(line, "-----", 5) == 0))
+      return true;
+  };
+  recipe.clear();
+  return false;
+}
+
+bool MemoryPartitioner::next(string_view &recipe) {
+  size_t start = string_view::npos;
+  while (m_position < m_text.size()) {
+    // Skip lines which cannot be delimiters.
+    m_position = next_delimiter(m_text.data(), m_text.size(), m_position);
+    if (m_position >= m_text.size())
+      break;
+    size_t newline = m_text.find('\n', m_position);
+    size_t end = newline == string_view::npos ? m_text.size() : newline + 1;
+    string_view line = m_text.substr(m_position, (newline == string_view::npos ? m_text.size() : newline) - m_position);
+    if (!line.empty() && line.back() == '\r')
+      line.remove_suffix(1);
+    if (start == string_view::npos && line.size() > 5 && (line.substr(0, 5) == "MMMMM" || line.substr(0, 5) == "-----"))
+      start = m_position;
+    m_position = end;
     if (line == "MMMMM" || line == "-----") {
-      result.push_back(recipe.str());
-      recipe.str("");
-      recipe.clear();
-      on = false;
+      // The range includes the line break of the end marker.
+      recipe = start == string_view::npos ? string_view() : m_text.substr(start, end - start);
+      return true;
     };
   };
+  recipe = string_view();
+  return false;
+}
+
+vector<string> recipes(istream &stream) {
+  vector<string> result;
+  Partitioner partitioner(stream);
+  string recipe;
+  while (partitioner.next(recipe))
+    result.push_back(recipe);
   return result;
 }
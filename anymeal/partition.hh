@@ -16,7 +16,39 @@
 #pragma once
 #include <vector>
 #include <string>
+#include <string_view>
 #include <istream>
 
 
+#define PARTITION_READ_AHEAD 65536
+
+// Splits a stream of MealMaster recipes one recipe at a time. The input is read in blocks of the specified size into a
+// buffer which is reused for the whole stream, so the memory use does not depend on the size of the file.
+class Partitioner
+{
+public:
+  Partitioner(std::istream &stream, size_t read_ahead=PARTITION_READ_AHEAD);
+  bool next(std::string &recipe);
+protected:
+  bool next_line(const char *&line, size_t &length);
+  std::istream &m_stream;
+  std::vector<char> m_buffer;
+  size_t m_begin;
+  size_t m_end;
+  size_t m_read_ahead;
+};
+
+// Finds the recipes in a block of memory such as a mapped file. The recipes are returned as ranges of the original
+// text without copying it.
+class MemoryPartitioner
+{
+public:
+  MemoryPartitioner(std::string_view text): m_text(text), m_position(0) {}
+  bool next(std::string_view &recipe);
+  size_t position(void) const { return m_position; }
+protected:
+  std::string_view m_text;
+  size_t m_position;
+};
+
 std::vector<std::string> recipes(std::istream &stream);
@@ -0,0 +1,217 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <cstring>
+#include <stdint.h>
+#include "recipe_codec.hh"
+
+
+#define CODEC_VERSION 1
+
+using namespace std;
+
+static void put_number(string &data, int64_t value) {
+  // Zig-zag encoding followed by 7 bits per byte.
+  uint64_t bits = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+  while (bits >= 0x80) {
+    data += (char)(bits | 0x80);
+    bits >>= 7;
+  };
+  data += (char)bits;
+}
+
+static void put_string(string &data, const string &text) {
+  put_number(data, text.size());
+  data += text;
+}
+
+static void put_sections(string &data, vector<pair<int, string> > &sections) {
+  put_number(data, sections.size());
+  for (vector<pair<int, string> >::iterator section=sections.begin(); section!=sections.end(); section++) {
+    put_number(data, section->first);
+    put_string(data, section->second);
+  };
+}
+
+static void put_header(string &data, Recipe &recipe) {
+  put_string(data, recipe.title());
+  put_number(data, recipe.servings());
+  put_string(data, recipe.servings_unit());
+}
+
+static void put_content(string &data, Recipe &recipe) {
+  put_number(data, recipe.ingredients().size());
+  for (vector<Ingredient>::iterator ingredient=recipe.ingredients().begin(); ingredient!=recipe.ingredients().end(); ingredient++) {
+    put_number(data, ingredient->amount_integer());
+    put_number(data, ingredient->amount_numerator());
+    put_number(data, ingredient->amount_denominator());
+    double amount_float = ingredient->amount_float();
+    data.append((const char *)&amount_float, sizeof(double));
+    put_string(data, ingredient->unit());
+    put_string(data, ingredient->text());
+  };
+  put_sections(data, recipe.ingredient_sections());
+  put_number(data, recipe.instructions().size());
+  for (vector<string>::iterator instruction=recipe.instructions().begin(); instruction!=recipe.instructions().end(); instruction++)
+    put_string(data, *instruction);
+  put_sections(data, recipe.instruction_sections());
+}
+
+string encode_recipe(Recipe &recipe) {
+  string data;
+  data += (char)CODEC_VERSION;
+  put_header(data, recipe);
+  put_number(data, recipe.categories().size());
+  for (set<string>::iterator category=recipe.categories().begin(); category!=recipe.categories().end(); category++)
+    put_string(data, *category);
+  put_content(data, recipe);
+  return data;
+}
+
+static uint64_t hash64(const string &data) {
+  // MurmurHash64A by Austin Appleby.
+  const uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+  uint64_t h = 0x5bd1e995ULL ^ (data.size() * m);
+  size_t blocks = data.size() / 8;
+  for (size_t i=0; i<blocks; i++) {
+    uint64_t k;
+    memcpy(&k, data.data() + i * 8, 8);
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  };
+  const unsigned char *tail = (const unsigned char *)data.data() + blocks * 8;
+  switch (data.size() & 7) {
+  case 7: h ^= (uint64_t)tail[6] << 48; // fall through
+  case 6: h ^= (uint64_t)tail[5] << 40; // fall through
+  case 5: h ^= (uint64_t)tail[4] << 32; // fall through
+  case 4: h ^= (uint64_t)tail[3] << 24; // fall through
+  case 3: h ^= (uint64_t)tail[2] << 16; // fall through
+  case 2: h ^= (uint64_t)tail[1] << 8; // fall through
+  case 1: h ^= (uint64_t)tail[0];
+          h *= m;
+  };
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+  return h;
+}
+
+uint64_t hash_recipe(Recipe &recipe) {
+  // Categories can change after the recipe was stored and are not part of the hash.
+  string data;
+  put_header(data, recipe);
+  put_content(data, recipe);
+  return hash64(data);
+}
+
+class Decoder
+{
+public:
+  Decoder(const char *data, size_t size): m_p(data), m_end(data + size), m_valid(true) {}
+  bool valid(void) const { return m_valid && m_p == m_end; }
+  int64_t number(void) {
+    uint64_t bits = 0;
+    int shift = 0;
+    while (true) {
+      if (m_p == m_end || shift > 63) {
+        m_valid = false;
+        return 0;
+      };
+      unsigned char c = *m_p++;
+      bits |= (uint64_t)(c & 0x7f) << shift;
+      if (!(c & 0x80))
+        break;
+      shift += 7;
+    };
+    return (int64_t)(bits >> 1) ^ -(int64_t)(bits & 1);
+  }
+  size_t count(void) {
+    int64_t value = number();
+    // Each element takes at least one byte.
+    if (value < 0 || value > m_end - m_p) {
+      m_valid = false;
+      return 0;
+    };
+    return value;
+  }
+  string text(void) {
+    size_t size = count();
+    string result(m_p, size);
+    m_p += size;
+    return result;
+  }
+  double floating(void) {
+    double result = 0;
+    if (m_end - m_p < (ptrdiff_t)sizeof(double)) {
+      m_valid = false;
+      return result;
+    };
+    memcpy(&result, m_p, sizeof(double));
+    m_p += sizeof(double);
+    return result;
+  }
+  vector<pair<int, string> > sections(void) {
+    vector<pair<int, string> > result;
+    size_t n = count();
+    for (size_t i=0; i<n && m_valid; i++) {
+      int row = number();
+      result.push_back(make_pair(row, text()));
+    };
+    return result;
+  }
+protected:
+  const char *m_p;
+  const char *m_end;
+  bool m_valid;
+};
+
+bool decode_recipe(const char *data, size_t size, Recipe &recipe) {
+  if (size < 1 || data[0] != CODEC_VERSION)
+    return false;
+  Decoder decoder(data + 1, size - 1);
+  Recipe result;
+  result.set_title(decoder.text().c_str());
+  result.set_servings(decoder.number());
+  result.set_servings_unit(decoder.text().c_str());
+  size_t categories = decoder.count();
+  for (size_t i=0; i<categories; i++)
+    result.add_category(decoder.text().c_str());
+  size_t ingredients = decoder.count();
+  result.ingredients().reserve(ingredients);
+  for (size_t i=0; i<ingredients; i++) {
+    Ingredient ingredient;
+    ingredient.set_amount_integer(decoder.number());
+    ingredient.set_amount_numerator(decoder.number());
+    ingredient.set_amount_denominator(decoder.number());
+    ingredient.set_amount_float(decoder.floating());
+    ingredient.set_unit(decoder.text().c_str());
+    ingredient.set_text(decoder.text().c_str());
+    result.add_ingredient(ingredient);
+  };
+  result.set_ingredient_sections(decoder.sections());
+  size_t instructions = decoder.count();
+  result.instructions().reserve(instructions);
+  for (size_t i=0; i<instructions; i++)
+    result.add_instruction(decoder.text().c_str());
+  result.set_instruction_sections(decoder.sections());
+  if (!decoder.valid())
+    return false;
+  recipe = result;
+  return true;
+}
@@ -0,0 +1,60 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include "search_history.hh"
+
+
+using namespace std;
+
+void SearchHistory::clear(void) {
+  m_steps.clear();
+}
+
+void SearchHistory::push(const string &label, const Bitmap &previous, const string &previous_chain, const Bitmap &current) {
+  Step step;
+  step.label = label;
+  step.chain = previous_chain;
+  step.removed = previous - current;
+  m_steps.push_back(step);
+  while (m_steps.size() > m_capacity)
+    m_steps.pop_front();
+}
+
+void SearchHistory::jump(size_t step, Bitmap &selection, string &chain) {
+  // Add the recipes removed by the later steps and restore the chain of filters before them.
+  while (m_steps.size() > step) {
+    selection |= m_steps.back().removed;
+    chain = m_steps.back().chain;
+    m_steps.pop_back();
+  };
+}
+
+void SearchHistory::undo(Bitmap &selection, string &chain) {
+  if (!m_steps.empty())
+    jump(m_steps.size() - 1, selection, chain);
+}
+
+void SearchHistory::erase(const Bitmap &ids) {
+  // Deleted recipes must not come back when going back in the history.
+  for (deque<Step>::iterator step=m_steps.begin(); step!=m_steps.end(); step++)
+    step->removed -= ids;
+}
+
+size_t SearchHistory::memory(void) const {
+  size_t result = 0;
+  for (deque<Step>::const_iterator step=m_steps.begin(); step!=m_steps.end(); step++)
+    result += step->label.capacity() + step->chain.capacity() + step->removed.memory();
+  return result;
+}
@@ -0,0 +1,46 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <deque>
+#include <string>
+#include "bitmap.hh"
+
+
+// Steps of the search history. Each step only stores the recipes it removed from the selection, so that going back to
+// an earlier step is a union of bitmaps. The oldest steps are dropped when the capacity is exceeded.
+class SearchHistory
+{
+public:
+  SearchHistory(size_t capacity): m_capacity(capacity) {}
+  size_t size(void) const { return m_steps.size(); }
+  bool empty(void) const { return m_steps.empty(); }
+  size_t capacity(void) const { return m_capacity; }
+  const std::string &label(size_t step) const { return m_steps[step].label; }
+  void clear(void);
+  void push(const std::string &label, const Bitmap &previous, const std::string &previous_chain, const Bitmap &current);
+  void jump(size_t step, Bitmap &selection, std::string &chain);
+  void undo(Bitmap &selection, std::string &chain);
+  void erase(const Bitmap &ids);
+  size_t memory(void) const;
+protected:
+  struct Step {
+    std::string label;
+    std::string chain;
+    Bitmap removed;
+  };
+  size_t m_capacity;
+  std::deque<Step> m_steps;
+};
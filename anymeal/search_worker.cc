@@ -0,0 +1,143 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include "search_worker.hh"
+#include "title_pager.hh"
+
+
+using namespace std;
+
+SearchWorker::SearchWorker(void): QObject(NULL), m_search_serial(0), m_fetch_serial(0), m_count_serial(0), m_searching(0) {
+  qRegisterMetaType<Bitmap>();
+  qRegisterMetaType<Filter>();
+  qRegisterMetaType<Recipe>();
+  qRegisterMetaType<SearchResult>();
+  qRegisterMetaType<std::string>();
+}
+
+void SearchWorker::open(const char *filename) {
+  // Open the connection before moving the object to the worker thread.
+  m_database.open(filename);
+  m_database.set_progress_handler(&SearchWorker::progress, this);
+}
+
+int SearchWorker::next_search(void) {
+  // Cancel the running search. Later statements check the serial number in the progress handler.
+  int serial = m_search_serial.fetchAndAddOrdered(1) + 1;
+  if (m_searching.loadAcquire())
+    m_database.interrupt();
+  return serial;
+}
+
+int SearchWorker::next_fetch(void) {
+  return m_fetch_serial.fetchAndAddOrdered(1) + 1;
+}
+
+int SearchWorker::next_count(void) {
+  return m_count_serial.fetchAndAddOrdered(1) + 1;
+}
+
+bool SearchWorker::stale_search(int serial) const {
+  return serial != m_search_serial.loadAcquire();
+}
+
+bool SearchWorker::stale_fetch(int serial) const {
+  return serial != m_fetch_serial.loadAcquire();
+}
+
+bool SearchWorker::stale_count(int serial) const {
+  return serial != m_count_serial.loadAcquire();
+}
+
+int SearchWorker::progress(void *data) {
+  SearchWorker *worker = (SearchWorker *)data;
+  int serial = worker->m_searching.loadAcquire();
+  return serial != 0 && worker->stale_search(serial);
+}
+
+void SearchWorker::search(int serial, bool all, Bitmap selection, string chain, Filter filter) {
+  if (stale_search(serial))
+    return;
+  try {
+    // Apply the filter to all recipes or to the given selection. Known chains of filters are replayed from the cache.
+    m_searching.storeRelease(serial);
+    if (all)
+      m_database.select_all();
+    else
+      m_database.set_selection(selection, chain);
+    SearchResult result;
+    result.base = m_database.selection();
+    result.base_chain = m_database.chain();
+    m_database.select_by_filter(filter);
+    // Also load the first page of titles and count the recipes per category and ingredient in the selection.
+    m_database.recipe_info_page("", 0, TITLES_PAGE_SIZE, result.titles);
+    m_database.count_facets(m_facets);
+    result.categories = m_database.category_facets(m_facets);
+    result.ingredients = m_database.ingredient_facets(m_facets, INGREDIENT_FACETS);
+    result.selection = m_database.selection();
+    result.chain = m_database.chain();
+    m_searching.storeRelease(0);
+    if (!stale_search(serial))
+      emit finished(serial, result);
+  } catch (exception &e) {
+    m_searching.storeRelease(0);
+    if (!stale_search(serial))
+      emit failed(serial, e.what());
+  };
+}
+
+void SearchWorker::fetch(int serial, qlonglong id) {
+  if (stale_fetch(serial))
+    return;
+  // Retry if the interrupt meant for a search arrived after the search had finished.
+  for (int attempt=0; ; attempt++) {
+    try {
+      Recipe recipe = m_database.fetch_recipe(id);
+      if (!stale_fetch(serial))
+        emit fetched(serial, recipe);
+      break;
+    } catch (exception &e) {
+      if (attempt > 0 || sqlite3_errcode(m_database.db()) != SQLITE_INTERRUPT) {
+        if (!stale_fetch(serial))
+          emit fetch_failed(serial, e.what());
+        break;
+      };
+    };
+  };
+}
+
+void SearchWorker::count(int serial, Bitmap selection) {
+  if (stale_count(serial))
+    return;
+  // Count the recipes per category and ingredient in the selection after the recipes were modified.
+  for (int attempt=0; ; attempt++) {
+    try {
+      m_database.set_selection(selection);
+      m_database.count_facets(m_facets);
+      SearchResult result;
+      result.categories = m_database.category_facets(m_facets);
+      result.ingredients = m_database.ingredient_facets(m_facets, INGREDIENT_FACETS);
+      if (!stale_count(serial))
+        emit counted(serial, result);
+      break;
+    } catch (exception &e) {
+      if (attempt > 0 || sqlite3_errcode(m_database.db()) != SQLITE_INTERRUPT) {
+        if (!stale_count(serial))
+          emit count_failed(serial, e.what());
+        break;
+      };
+    };
+  };
+}
@@ -0,0 +1,77 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <string>
+#include <vector>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMetaType>
+#include <QtCore/QObject>
+#include <QtCore/QString>
+#include "database.hh"
+
+
+#define INGREDIENT_FACETS 50
+
+struct SearchResult {
+  Bitmap base;
+  std::string base_chain;
+  Bitmap selection;
+  std::string chain;
+  TitleArena titles;
+  std::vector<std::pair<std::string, int> > categories;
+  std::vector<std::pair<std::string, int> > ingredients;
+};
+
+Q_DECLARE_METATYPE(Bitmap)
+Q_DECLARE_METATYPE(Filter)
+Q_DECLARE_METATYPE(Recipe)
+Q_DECLARE_METATYPE(SearchResult)
+Q_DECLARE_METATYPE(std::string)
+
+// Runs searches on a separate database connection. The object is meant to be moved to a worker thread. Each request
+// gets a serial number and starting a new search cancels the one which is still running.
+class SearchWorker: public QObject
+{
+  Q_OBJECT
+public:
+  SearchWorker(void);
+  void open(const char *filename);
+  int next_search(void);
+  int next_fetch(void);
+  int next_count(void);
+  bool stale_search(int serial) const;
+  bool stale_fetch(int serial) const;
+  bool stale_count(int serial) const;
+public slots:
+  void search(int serial, bool all, Bitmap selection, std::string chain, Filter filter);
+  void fetch(int serial, qlonglong id);
+  void count(int serial, Bitmap selection);
+signals:
+  void finished(int serial, SearchResult result);
+  void fetched(int serial, Recipe recipe);
+  void counted(int serial, SearchResult result);
+  void failed(int serial, QString message);
+  void fetch_failed(int serial, QString message);
+  void count_failed(int serial, QString message);
+protected:
+  static int progress(void *data);
+  Database m_database;
+  Facets m_facets;
+  QAtomicInt m_search_serial;
+  QAtomicInt m_fetch_serial;
+  QAtomicInt m_count_serial;
+  QAtomicInt m_searching;
+};
@@ -0,0 +1,59 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <atomic>
+#include <utility>
+#include <vector>
+
+
+// Bounded lock-free queue for exactly one producer thread and one consumer thread. The capacity is rounded up to a
+// power of two.
+template <typename T>
+class SpscRing
+{
+public:
+  SpscRing(size_t capacity): m_head(0), m_tail(0) {
+    size_t size = 1;
+    while (size < capacity)
+      size <<= 1;
+    m_items.resize(size);
+    m_mask = size - 1;
+  }
+  size_t capacity(void) const { return m_items.size(); }
+  bool empty(void) const { return m_head.load(std::memory_order_acquire) == m_tail.load(std::memory_order_acquire); }
+  bool push(T &item) {
+    size_t tail = m_tail.load(std::memory_order_relaxed);
+    if (tail - m_head.load(std::memory_order_acquire) == m_items.size())
+      return false;
+    m_items[tail & m_mask] = std::move(item);
+    m_tail.store(tail + 1, std::memory_order_release);
+    return true;
+  }
+  bool pop(T &item) {
+    size_t head = m_head.load(std::memory_order_relaxed);
+    if (head == m_tail.load(std::memory_order_acquire))
+      return false;
+    item = std::move(m_items[head & m_mask]);
+    m_head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+protected:
+  std::vector<T> m_items;
+  size_t m_mask;
+  // Keep the indices of the consumer and the producer in separate cache lines.
+  alignas(64) std::atomic<size_t> m_head;
+  alignas(64) std::atomic<size_t> m_tail;
+};
@@ -0,0 +1,62 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <cstring>
+#include "title_arena.hh"
+
+
+using namespace std;
+
+void TitleArena::clear(void) {
+  // Keep the allocated capacity for the next list.
+  m_text.clear();
+  m_ids.clear();
+  m_offsets.clear();
+  m_lengths.clear();
+}
+
+void TitleArena::reserve(size_t rows, size_t bytes) {
+  m_text.reserve(bytes);
+  m_ids.reserve(rows);
+  m_offsets.reserve(rows);
+  m_lengths.reserve(rows);
+}
+
+void TitleArena::push_back(sqlite3_int64 id, const char *title, size_t length) {
+  m_ids.push_back(id);
+  m_offsets.push_back(m_text.size());
+  m_lengths.push_back(length);
+  m_text.append(title, length);
+  m_text.push_back('\0');
+}
+
+void TitleArena::push_back(sqlite3_int64 id, const char *title) {
+  push_back(id, title, strlen(title));
+}
+
+void TitleArena::set(size_t row, sqlite3_int64 id, const char *title) {
+  // Append the new title. The old one stays in the buffer until the arena is cleared.
+  size_t length = strlen(title);
+  m_ids[row] = id;
+  m_offsets[row] = m_text.size();
+  m_lengths[row] = length;
+  m_text.append(title, length);
+  m_text.push_back('\0');
+}
+
+size_t TitleArena::memory(void) const {
+  return m_text.capacity() + m_ids.capacity() * sizeof(sqlite3_int64) + m_offsets.capacity() * sizeof(size_t) +
+    m_lengths.capacity() * sizeof(uint32_t);
+}
@@ -0,0 +1,45 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <sqlite3.h>
+
+
+// List of recipe ids and titles. The titles are stored as zero-terminated UTF-8 strings in one contiguous buffer.
+class TitleArena
+{
+public:
+  TitleArena(void) {}
+  size_t size(void) const { return m_ids.size(); }
+  bool empty(void) const { return m_ids.empty(); }
+  void clear(void);
+  void reserve(size_t rows, size_t bytes);
+  void push_back(sqlite3_int64 id, const char *title, size_t length);
+  void push_back(sqlite3_int64 id, const char *title);
+  void set(size_t row, sqlite3_int64 id, const char *title);
+  sqlite3_int64 id(size_t row) const { return m_ids[row]; }
+  const char *title(size_t row) const { return m_text.data() + m_offsets[row]; }
+  size_t length(size_t row) const { return m_lengths[row]; }
+  const std::string &text(void) const { return m_text; }
+  size_t memory(void) const;
+protected:
+  std::string m_text;
+  std::vector<sqlite3_int64> m_ids;
+  std::vector<size_t> m_offsets;
+  std::vector<uint32_t> m_lengths;
+};
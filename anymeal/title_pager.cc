@@ -0,0 +1,68 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include "title_pager.hh"
+#include "title_search.hh"
+
+
+using namespace std;
+
+TitlePager::TitlePager(Database *database): m_database(database), m_last_id(0), m_more(true) {
+}
+
+void TitlePager::reset(const TitleArena &page) {
+  m_titles.clear();
+  m_last_title.clear();
+  m_last_id = 0;
+  m_more = true;
+  m_added.clear();
+  m_page = page;
+  append_page();
+}
+
+int TitlePager::load_page(void) {
+  // Returns the number of titles the next call to append_page will add.
+  m_database->recipe_info_page(m_last_title.c_str(), m_last_id, TITLES_PAGE_SIZE, m_page);
+  int count = 0;
+  for (size_t i=0; i<m_page.size(); i++)
+    if (m_added.find(m_page.id(i)) == m_added.end())
+      count++;
+  return count;
+}
+
+void TitlePager::append_page(void) {
+  // Remember the position of the last row for fetching the next page.
+  m_more = m_page.size() >= TITLES_PAGE_SIZE;
+  if (!m_page.empty()) {
+    m_last_title = m_page.title(m_page.size() - 1);
+    m_last_id = m_page.id(m_page.size() - 1);
+  };
+  for (size_t i=0; i<m_page.size(); i++)
+    if (m_added.find(m_page.id(i)) == m_added.end())
+      m_titles.push_back(m_page.id(i), m_page.title(i), m_page.length(i));
+  m_page.clear();
+}
+
+vector<size_t> TitlePager::fetch_matches(const char *pattern, int max_pages) {
+  // Skip pages without matching titles so that the caller gets rows to show.
+  vector<size_t> rows;
+  for (int i=0; i<max_pages && rows.empty() && m_more; i++) {
+    size_t first = m_titles.size();
+    load_page();
+    append_page();
+    rows = search_titles(m_titles, pattern, first);
+  };
+  return rows;
+}
@@ -0,0 +1,49 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <set>
+#include <string>
+#include <vector>
+#include "database.hh"
+#include "title_arena.hh"
+
+
+#define TITLES_PAGE_SIZE 256
+
+
+// Loads the titles of the selected recipes page by page in title order. Recipes which were added to the end of the
+// list already are skipped when their page is loaded.
+class TitlePager
+{
+public:
+  TitlePager(Database *database);
+  TitleArena &titles(void) { return m_titles; }
+  const TitleArena &titles(void) const { return m_titles; }
+  bool more(void) const { return m_more; }
+  void reset(const TitleArena &page);
+  int load_page(void);
+  void append_page(void);
+  std::vector<size_t> fetch_matches(const char *pattern, int max_pages);
+  void added(sqlite3_int64 id) { m_added.insert(id); }
+protected:
+  Database *m_database;
+  TitleArena m_titles;
+  TitleArena m_page;
+  std::string m_last_title;
+  sqlite3_int64 m_last_id;
+  bool m_more;
+  std::set<sqlite3_int64> m_added;
+};
@@ -0,0 +1,126 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <algorithm>
+#include <cstring>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#include "title_search.hh"
+
+
+using namespace std;
+
+static inline char fold(char c) {
+  return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+}
+
+static string fold(const char *text) {
+  string result(text);
+  for (string::iterator c=result.begin(); c!=result.end(); c++)
+    *c = fold(*c);
+  return result;
+}
+
+static bool matches(const char *text, const string &pattern) {
+  for (size_t i=0; i<pattern.size(); i++)
+    if (fold(text[i]) != pattern[i])
+      return false;
+  return true;
+}
+
+static void scan_scalar(const char *text, size_t begin, size_t length, const string &pattern, vector<size_t> &positions) {
+  for (size_t i=begin; i + pattern.size() <= length; i++)
+    if (matches(text + i, pattern))
+      positions.push_back(i);
+}
+
+void find_nocase_scalar(const char *text, size_t length, const string &pattern, vector<size_t> &positions) {
+  if (pattern.empty())
+    return;
+  scan_scalar(text, 0, length, fold(pattern.c_str()), positions);
+}
+
+#ifdef __SSE2__
+static inline __m128i fold(__m128i block) {
+  __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)), _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+  return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8('a' - 'A')));
+}
+#endif
+
+void find_nocase(const char *text, size_t length, const string &pattern, vector<size_t> &positions) {
+  if (pattern.empty())
+    return;
+  string folded = fold(pattern.c_str());
+  size_t i = 0;
+#ifdef __SSE2__
+  // Compare the first and the last character of the pattern with 16 positions at a time and only check candidates
+  // matching both.
+  size_t last = folded.size() - 1;
+  __m128i first_char = _mm_set1_epi8(folded[0]);
+  __m128i last_char = _mm_set1_epi8(folded[last]);
+  for (; i + last + 16 <= length; i += 16) {
+    __m128i first_block = fold(_mm_loadu_si128((const __m128i *)(text + i)));
+    __m128i last_block = fold(_mm_loadu_si128((const __m128i *)(text + i + last)));
+    int mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(first_block, first_char),
+                                               _mm_cmpeq_epi8(last_block, last_char)));
+    while (mask != 0) {
+      int bit = __builtin_ctz(mask);
+      if (matches(text + i + bit, folded))
+        positions.push_back(i + bit);
+      mask &= mask - 1;
+    };
+  };
+#endif
+  scan_scalar(text, i, length, folded, positions);
+}
+
+vector<size_t> search_titles(const TitleArena &titles, const char *pattern, size_t first) {
+  vector<size_t> result;
+  string folded = fold(pattern);
+  if (folded.empty()) {
+    for (size_t row=first; row<titles.size(); row++)
+      result.push_back(row);
+    return result;
+  };
+  if (first >= titles.size())
+    return result;
+  // Search the buffer from the first stored title of the rows onwards at once. Matches cannot span two titles because
+  // they are separated by zero bytes.
+  size_t base = titles.text().size();
+  for (size_t row=first; row<titles.size(); row++)
+    base = min(base, (size_t)(titles.title(row) - titles.text().data()));
+  vector<size_t> positions;
+  find_nocase(titles.text().data() + base, titles.text().size() - base, folded, positions);
+  if (positions.empty())
+    return result;
+  for (vector<size_t>::iterator position=positions.begin(); position!=positions.end(); position++)
+    *position += base;
+  // Titles are usually stored in order so the matches can be merged with the rows. Replaced titles need a binary search.
+  vector<size_t>::const_iterator match = positions.begin();
+  size_t previous = base;
+  for (size_t row=first; row<titles.size(); row++) {
+    size_t offset = titles.title(row) - titles.text().data();
+    if (offset < previous)
+      match = lower_bound(positions.begin(), positions.end(), offset);
+    else
+      while (match != positions.end() && *match < offset)
+        match++;
+    previous = offset;
+    if (match != positions.end() && *match + folded.size() <= offset + titles.length(row))
+      result.push_back(row);
+  };
+  return result;
+}
@@ -0,0 +1,28 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#pragma once
+#include <string>
+#include <vector>
+#include "title_arena.hh"
+
+
+// Case-insensitive substring search. Only ASCII letters are folded, other UTF-8 bytes have to match exactly.
+void find_nocase(const char *text, size_t length, const std::string &pattern, std::vector<size_t> &positions);
+
+void find_nocase_scalar(const char *text, size_t length, const std::string &pattern, std::vector<size_t> &positions);
+
+// Returns the rows from the specified one onwards with titles containing the pattern.
+std::vector<size_t> search_titles(const TitleArena &titles, const char *pattern, size_t first=0);
@@ -13,50 +13,131 @@
 
    You should have received a copy of the GNU General Public License
    along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include "title_search.hh"
 #include "titles_model.hh"
 
 
 using namespace std;
 
-TitlesModel::TitlesModel(QObject *parent, Database *database): QAbstractListModel(parent), m_database(database) {
-  m_titles = m_database->recipe_info();
+TitlesModel::TitlesModel(QObject *parent, Database *database):
+  QAbstractListModel(parent), m_database(database), m_pager(database), m_strings(TITLES_CACHE_SIZE), m_filtered(false)
+{
+  TitleArena page;
+  m_database->recipe_info_page("", 0, TITLES_PAGE_SIZE, page);
+  m_pager.reset(page);
 }
 
 void TitlesModel::reset(void) {
+  TitleArena page;
+  m_database->recipe_info_page("", 0, TITLES_PAGE_SIZE, page);
+  reset(page);
+}
+
+void TitlesModel::reset(const TitleArena &page) {
+  beginResetModel();
+  m_strings.clear();
+  m_filtered = false;
+  m_rows.clear();
+  m_pager.reset(page);
+  endResetModel();
+}
+
+bool TitlesModel::canFetchMore(const QModelIndex &parent) const {
+  if (parent.isValid())
+    return false;
+  return m_pager.more();
+}
+
+void TitlesModel::fetchMore(const QModelIndex &parent) {
+  if (parent.isValid() || !m_pager.more())
+    return;
+  if (m_filtered) {
+    // Only the matching titles of the new pages become visible.
+    vector<size_t> rows = m_pager.fetch_matches(m_pattern.c_str(), TITLES_SEARCH_PAGES);
+    if (!rows.empty()) {
+      int row = m_rows.size();
+      beginInsertRows(QModelIndex(), row, row + rows.size() - 1);
+      m_rows.insert(m_rows.end(), rows.begin(), rows.end());
+      endInsertRows();
+    } else if (m_pager.more()) {
+      // The view only fetches again after rows were inserted or the layout changed.
+      emit layoutAboutToBeChanged();
+      emit layoutChanged();
+    };
+    return;
+  };
+  int count = m_pager.load_page();
+  if (count > 0) {
+    int row = m_pager.titles().size();
+    beginInsertRows(QModelIndex(), row, row + count - 1);
+    m_pager.append_page();
+    endInsertRows();
+  } else
+    m_pager.append_page();
+}
+
+void TitlesModel::fetch_all(void) {
+  while (canFetchMore(QModelIndex()))
+    fetchMore(QModelIndex());
+}
+
+void TitlesModel::set_pattern(const QString &pattern) {
   beginResetModel();
-  m_titles = m_database->recipe_info();
+  if (pattern.isEmpty()) {
+    m_filtered = false;
+    m_rows.clear();
+  } else {
+    // Search the loaded titles only. Further pages are searched when the view fetches them.
+    m_pattern = pattern.toUtf8().constData();
+    m_rows = search_titles(m_pager.titles(), m_pattern.c_str());
+    m_filtered = true;
+  };
   endResetModel();
 }
 
+size_t TitlesModel::row(const QModelIndex &index) const {
+  return m_filtered ? m_rows[index.row()] : index.row();
+}
+
 int TitlesModel::rowCount(const QModelIndex &) const {
-  return m_titles.size();
+  return m_filtered ? m_rows.size() : m_pager.titles().size();
 }
 
 QVariant TitlesModel::data(const QModelIndex &index, int role) const {
   QVariant result;
   if (role == Qt::DisplayRole) {
-    int row = index.row();
-    result = QString(m_titles[row].second.c_str());
+    // Convert the titles of visible rows only once.
+    int title_row = row(index);
+    QString *title = m_strings.object(title_row);
+    if (title == NULL) {
+      title = new QString(QString::fromUtf8(m_pager.titles().title(title_row), m_pager.titles().length(title_row)));
+      m_strings.insert(title_row, title);
+    };
+    result = *title;
   };
   return result;
 }
 
 sqlite_int64 TitlesModel::recipeid(const QModelIndex &index) {
-  int row = index.row();
-  return m_titles[row].first;
+  return m_pager.titles().id(row(index));
 }
 
 QModelIndex TitlesModel::edit_entry(const QModelIndex &index, sqlite3_int64 id, const char *title) {
-  int row = index.row();
-  m_titles[row] = pair<sqlite3_int64, string>(id, title);
+  int title_row = row(index);
+  m_pager.titles().set(title_row, id, title);
+  m_strings.remove(title_row);
+  m_pager.added(id);
   emit dataChanged(index, index);
   return index;
 }
 
 QModelIndex TitlesModel::add_entry(sqlite3_int64 id, const char *title) {
-  int row = m_titles.size();
+  int row = rowCount();
   beginInsertRows(QModelIndex(), row, row);
-  m_titles.push_back(pair<sqlite3_int64, string>(id, title));
+  if (m_filtered)
+    m_rows.push_back(m_pager.titles().size());
+  m_pager.titles().push_back(id, title);
+  m_pager.added(id);
   endInsertRows();
   return index(row);
 }
@@ -14,10 +14,18 @@
    You should have received a copy of the GNU General Public License
    along with this program.  If not, see <https://www.gnu.org/licenses/>. */
 #pragma once
-#include <vector>
 #include <string>
+#include <vector>
 #include <QtCore/QAbstractListModel>
+#include <QtCore/QCache>
+#include <QtCore/QString>
 #include "database.hh"
+#include "title_arena.hh"
+#include "title_pager.hh"
+
+
+#define TITLES_CACHE_SIZE 1024
+#define TITLES_SEARCH_PAGES 16
 
 
 class TitlesModel: public QAbstractListModel
@@ -26,12 +34,22 @@ class TitlesModel: public QAbstractListModel
 public:
   TitlesModel(QObject *parent, Database *database);
   void reset(void);
+  void reset(const TitleArena &page);
   virtual int rowCount(const QModelIndex &parent=QModelIndex()) const;
   virtual QVariant data(const QModelIndex &index, int role=Qt::DisplayRole) const;
+  virtual bool canFetchMore(const QModelIndex &parent) const;
+  virtual void fetchMore(const QModelIndex &parent);
+  void fetch_all(void);
+  void set_pattern(const QString &pattern);
   sqlite3_int64 recipeid(const QModelIndex &index);
   QModelIndex edit_entry(const QModelIndex &index, sqlite3_int64 id, const char *title);
   QModelIndex add_entry(sqlite3_int64 id, const char *title);
 protected:
+  size_t row(const QModelIndex &index) const;
   Database *m_database;
-  std::vector<std::pair<sqlite3_int64, std::string> > m_titles;
+  TitlePager m_pager;
+  mutable QCache<int, QString> m_strings;
+  bool m_filtered;
+  std::string m_pattern;
+  std::vector<size_t> m_rows;
 };
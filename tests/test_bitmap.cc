@@ -0,0 +1,134 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <set>
+#include <gtest/gtest.h>
+#include "bitmap.hh"
+
+
+using namespace testing;
+using namespace std;
+
+static Bitmap range(sqlite3_int64 start, sqlite3_int64 stop, sqlite3_int64 step) {
+  Bitmap result;
+  for (sqlite3_int64 i=start; i<stop; i+=step)
+    result.add(i);
+  return result;
+}
+
+TEST(BitmapTest, Empty) {
+  Bitmap bitmap;
+  EXPECT_TRUE(bitmap.empty());
+  EXPECT_EQ(0, bitmap.size());
+  EXPECT_FALSE(bitmap.contains(1));
+  EXPECT_TRUE(bitmap.begin() == bitmap.end());
+}
+
+TEST(BitmapTest, AddAndContains) {
+  Bitmap bitmap;
+  bitmap.add(5);
+  bitmap.add(3);
+  bitmap.add(5);
+  bitmap.add(70000);
+  EXPECT_EQ(3, bitmap.size());
+  EXPECT_TRUE(bitmap.contains(3));
+  EXPECT_TRUE(bitmap.contains(70000));
+  EXPECT_FALSE(bitmap.contains(4));
+  vector<sqlite3_int64> ids = bitmap.ids();
+  ASSERT_EQ(3, ids.size());
+  EXPECT_EQ(3, ids[0]);
+  EXPECT_EQ(5, ids[1]);
+  EXPECT_EQ(70000, ids[2]);
+}
+
+TEST(BitmapTest, Remove) {
+  Bitmap bitmap = range(1, 10, 1);
+  bitmap.remove(4);
+  bitmap.remove(42);
+  EXPECT_EQ(8, bitmap.size());
+  EXPECT_FALSE(bitmap.contains(4));
+  for (sqlite3_int64 i=1; i<10; i++)
+    bitmap.remove(i);
+  EXPECT_TRUE(bitmap.empty());
+  EXPECT_TRUE(bitmap == Bitmap());
+}
+
+TEST(BitmapTest, DenseContainer) {
+  Bitmap bitmap = range(0, 100000, 1);
+  EXPECT_EQ(100000, bitmap.size());
+  EXPECT_TRUE(bitmap.contains(65536 + 4097));
+  EXPECT_LT(bitmap.memory(), 100000 / 4);
+  sqlite3_int64 expected = 0;
+  for (Bitmap::const_iterator i=bitmap.begin(); i!=bitmap.end(); ++i)
+    EXPECT_EQ(expected++, *i);
+  EXPECT_EQ(100000, expected);
+}
+
+TEST(BitmapTest, ConvertBackToArray) {
+  Bitmap bitmap = range(0, 5000, 1);
+  for (sqlite3_int64 i=0; i<2000; i++)
+    bitmap.remove(i);
+  EXPECT_TRUE(bitmap == range(2000, 5000, 1));
+}
+
+TEST(BitmapTest, Intersect) {
+  EXPECT_TRUE((range(0, 200000, 2) & range(0, 200000, 3)) == range(0, 200000, 6));
+  EXPECT_TRUE((range(0, 10, 1) & range(5, 200000, 1)) == range(5, 10, 1));
+  EXPECT_TRUE((range(0, 10, 1) & range(100000, 100010, 1)).empty());
+}
+
+TEST(BitmapTest, Subtract) {
+  Bitmap odd = range(1, 200000, 2);
+  EXPECT_TRUE((range(0, 200000, 1) - odd) == range(0, 200000, 2));
+  EXPECT_TRUE((range(0, 10, 1) - range(0, 200000, 1)).empty());
+  EXPECT_TRUE((range(0, 10, 1) - range(5, 200000, 1)) == range(0, 5, 1));
+}
+
+TEST(BitmapTest, Unite) {
+  EXPECT_TRUE((range(0, 200000, 2) | range(1, 200000, 2)) == range(0, 200000, 1));
+  EXPECT_TRUE((range(0, 3, 1) | range(3, 6, 1)) == range(0, 6, 1));
+  EXPECT_EQ(4, (range(0, 3, 1) | range(100000, 100001, 1)).size());
+}
+
+TEST(BitmapTest, CompareWithSet) {
+  Bitmap a;
+  Bitmap b;
+  set<sqlite3_int64> sa;
+  set<sqlite3_int64> sb;
+  unsigned int seed = 42;
+  for (int i=0; i<20000; i++) {
+    seed = seed * 1103515245 + 12345;
+    sqlite3_int64 id = (seed >> 8) % 300000;
+    if (i % 2) {
+      a.add(id);
+      sa.insert(id);
+    } else {
+      b.add(id);
+      sb.insert(id);
+    };
+  };
+  EXPECT_EQ(sa.size(), a.size());
+  Bitmap c = a & b;
+  Bitmap d = a - b;
+  int common = 0;
+  for (set<sqlite3_int64>::iterator i=sa.begin(); i!=sa.end(); i++) {
+    bool both = sb.find(*i) != sb.end();
+    EXPECT_EQ(both, c.contains(*i));
+    EXPECT_EQ(!both, d.contains(*i));
+    common += both;
+  };
+  EXPECT_EQ(common, c.size());
+  EXPECT_EQ(sa.size() - common, d.size());
+}
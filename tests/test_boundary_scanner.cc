@@ -0,0 +1,147 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <gtest/gtest.h>
+#include "boundary_scanner.hh"
+#include "mapped_file.hh"
+#include "partition.hh"
+
+
+using namespace std;
+
+#define BENCHMARK_SIZE (2LL << 30)
+
+typedef size_t (*scanner_t)(const char *, size_t, size_t);
+
+static vector<scanner_t> scanners(void) {
+  vector<scanner_t> result;
+  result.push_back(&next_delimiter_scalar);
+#ifdef HAVE_SSE2_SCANNER
+  result.push_back(&next_delimiter_sse2);
+#endif
+#ifdef HAVE_AVX2_SCANNER
+  if (avx2_supported())
+    result.push_back(&next_delimiter_avx2);
+#endif
+  result.push_back(&next_delimiter);
+  return result;
+}
+
+TEST(BoundaryScannerTest, DelimiterAtPosition) {
+  vector<scanner_t> s = scanners();
+  for (vector<scanner_t>::iterator scanner=s.begin(); scanner!=s.end(); scanner++) {
+    EXPECT_EQ(0, (*scanner)("MMMMM", 5, 0));
+    EXPECT_EQ(0, (*scanner)("-----", 5, 0));
+  };
+}
+
+TEST(BoundaryScannerTest, NoDelimiter) {
+  vector<scanner_t> s = scanners();
+  for (vector<scanner_t>::iterator scanner=s.begin(); scanner!=s.end(); scanner++) {
+    EXPECT_EQ(0, (*scanner)("", 0, 0));
+    EXPECT_EQ(4, (*scanner)("text", 4, 0));
+    EXPECT_EQ(16, (*scanner)("text MMMMM text\n", 16, 0));
+  };
+}
+
+TEST(BoundaryScannerTest, DelimiterAfterLineBreak) {
+  string line = "a line of text which is longer than a vector register\r\n";
+  string text = line + "MMMMM\r\n";
+  vector<scanner_t> s = scanners();
+  for (vector<scanner_t>::iterator scanner=s.begin(); scanner!=s.end(); scanner++) {
+    EXPECT_EQ(line.size(), (*scanner)(text.data(), text.size(), 0));
+    EXPECT_EQ(line.size(), (*scanner)(text.data(), text.size(), line.size()));
+    EXPECT_EQ(text.size(), (*scanner)(text.data(), text.size(), text.size()));
+  };
+}
+
+TEST(BoundaryScannerTest, DelimiterAtEndOfData) {
+  string text = string(100, 'x') + "\n-";
+  vector<scanner_t> s = scanners();
+  for (vector<scanner_t>::iterator scanner=s.begin(); scanner!=s.end(); scanner++)
+    EXPECT_EQ(101, (*scanner)(text.data(), text.size(), 0));
+}
+
+TEST(BoundaryScannerTest, SameResultsAsScalarScanner) {
+  mt19937 random(42);
+  const char alphabet[] = "\nM-ab";
+  string text;
+  for (int i=0; i<10000; i++)
+    text += alphabet[random() % 5];
+  vector<scanner_t> s = scanners();
+  for (vector<scanner_t>::iterator scanner=s.begin(); scanner!=s.end(); scanner++) {
+    bool same = true;
+    for (size_t position=0; position<=text.size(); position++)
+      if (position == 0 || text[position - 1] == '\n')
+        if ((*scanner)(text.data(), text.size(), position) != next_delimiter_scalar(text.data(), text.size(), position))
+          same = false;
+    EXPECT_TRUE(same);
+  };
+}
+
+TEST(BoundaryScannerTest, DISABLED_BenchmarkPartition) {
+  const char *filename = "/tmp/anymeal-benchmark.mmf";
+  string recipe = "MMMMM----- Recipe via Meal-Master (tm) v8.05\r\n\r\n      Title: Apple Pie\r\n Categories: Cakes, Pies\r\n"
+                  "      Yield: 6 servings\r\n\r\n      2 c  Flour\r\n      1 ts Salt\r\n    2/3 c  Shortening\r\n"
+                  "      6    Apples; peeled and sliced\r\n\r\n  Mix the flour and the salt. Cut in the shortening.\r\n"
+                  "  Fill with the apples and bake.\r\n\r\nMMMMM\r\n\r\n";
+  long long n = BENCHMARK_SIZE / recipe.size();
+  {
+    ofstream f(filename, ofstream::binary);
+    for (long long i=0; i<n; i++)
+      f << recipe;
+  }
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  ifstream f(filename, ofstream::binary);
+  Partitioner partitioner(f);
+  string text;
+  long long count = 0;
+  while (partitioner.next(text))
+    count++;
+  double stream_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(n, count);
+  MappedFile file(filename);
+  start = chrono::steady_clock::now();
+  MemoryPartitioner ranges(file.text());
+  string_view range;
+  count = 0;
+  while (ranges.next(range))
+    count++;
+  double mapped_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  EXPECT_EQ(n, count);
+  double gigabytes = file.size() / 1073741824.0;
+  cout << "Partitioning " << gigabytes << " GB: stream " << gigabytes / stream_time << " GB/s, mapped "
+       << gigabytes / mapped_time << " GB/s" << endl;
+  // Skip from one delimiter candidate to the next as the partitioner does.
+  vector<scanner_t> s = scanners();
+  for (vector<scanner_t>::iterator scanner=s.begin(); scanner!=s.end(); scanner++) {
+    start = chrono::steady_clock::now();
+    size_t position = 0;
+    while ((position = (*scanner)(file.data(), file.size(), position)) < file.size()) {
+      const char *newline = (const char *)memchr(file.data() + position, '\n', file.size() - position);
+      if (!newline)
+        break;
+      position = newline - file.data() + 1;
+    };
+    double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    cout << "Scanner " << scanner - s.begin() << ": " << gigabytes / time << " GB/s" << endl;
+  };
+  remove(filename);
+}
@@ -13,6 +13,11 @@
 
    You should have received a copy of the GNU General Public License
    along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sstream>
 #include <gtest/gtest.h>
 #include "database.hh"
 
@@ -536,3 +541,1433 @@ TEST(DatabaseTest, CountCategory) {
   ASSERT_EQ(2, database.count_recipes("A"));
   ASSERT_EQ(1, database.count_recipes("B"));
 }
+
+TEST(DatabaseTest, SelectByTitlePrefix) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe1;
+  recipe1.set_title("Apple pie");
+  database.insert_recipe(recipe1);
+  Recipe recipe2;
+  recipe2.set_title("Banana bread");
+  database.insert_recipe(recipe2);
+  database.select_all();
+  database.select_by_title("app");
+  ASSERT_EQ(1, database.num_recipes());
+  vector<pair<sqlite3_int64, string> > info = database.recipe_info();
+  EXPECT_EQ("Apple pie", info[0].second);
+}
+
+TEST(DatabaseTest, SelectByTitleIgnoresInstructions) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.add_instruction("Bake the bananas.");
+  database.insert_recipe(recipe);
+  database.select_all();
+  database.select_by_title("bananas");
+  EXPECT_EQ(0, database.num_recipes());
+}
+
+TEST(DatabaseTest, SelectByTitleSubstring) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe1;
+  recipe1.set_title("Pancakes");
+  database.insert_recipe(recipe1);
+  Recipe recipe2;
+  recipe2.set_title("Spaghetti");
+  database.insert_recipe(recipe2);
+  database.select_all();
+  database.select_by_title("cake");
+  ASSERT_EQ(1, database.num_recipes());
+  EXPECT_TRUE(database.selection().contains(1));
+  database.select_all();
+  database.select_by_title("GHETTI");
+  ASSERT_EQ(1, database.num_recipes());
+  EXPECT_TRUE(database.selection().contains(2));
+  database.select_all();
+  database.select_by_title("a");
+  EXPECT_EQ(2, database.num_recipes());
+}
+
+TEST(DatabaseTest, SelectByTitleWithWildcardCharacters) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe1;
+  recipe1.set_title("Cheese 50% fat");
+  database.insert_recipe(recipe1);
+  Recipe recipe2;
+  recipe2.set_title("Cheese 50 fat");
+  database.insert_recipe(recipe2);
+  database.select_all();
+  database.select_by_title("0%");
+  ASSERT_EQ(1, database.num_recipes());
+  EXPECT_TRUE(database.selection().contains(1));
+  database.select_all();
+  database.select_by_title("50_");
+  EXPECT_EQ(0, database.num_recipes());
+}
+
+TEST(DatabaseTest, DeleteRecipeFromTitleIndex) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  vector<sqlite3_int64> ids;
+  ids.push_back(database.insert_recipe(recipe));
+  database.delete_recipes(ids);
+  int exist = 0;
+  sqlite3_exec(database.db(), "SELECT rowid FROM titletext WHERE title LIKE '%pie%';", &has_row, &exist, NULL);
+  EXPECT_EQ(exist, 0);
+}
+
+TEST(DatabaseTest, SelectByText) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe1;
+  recipe1.set_title("Recipe A");
+  recipe1.add_instruction("Stir well.");
+  database.insert_recipe(recipe1);
+  Recipe recipe2;
+  recipe2.set_title("Recipe B");
+  recipe2.add_instruction("Whisk the eggs.");
+  database.insert_recipe(recipe2);
+  database.select_all();
+  database.select_by_text("whisk eggs");
+  ASSERT_EQ(1, database.num_recipes());
+  vector<pair<sqlite3_int64, string> > info = database.recipe_info();
+  EXPECT_EQ("Recipe B", info[0].second);
+}
+
+TEST(DatabaseTest, SearchRecipesRanksTitleFirst) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe1;
+  recipe1.set_title("Bread");
+  recipe1.add_instruction("Serve with soup.");
+  database.insert_recipe(recipe1);
+  Recipe recipe2;
+  recipe2.set_title("Soup");
+  recipe2.add_instruction("Simmer.");
+  database.insert_recipe(recipe2);
+  vector<pair<sqlite3_int64, string> > result = database.search_recipes("soup", 10);
+  ASSERT_EQ(2, result.size());
+  EXPECT_EQ("Soup", result[0].second);
+  EXPECT_EQ("Bread", result[1].second);
+  EXPECT_EQ(1, database.search_recipes("soup", 1).size());
+}
+
+TEST(DatabaseTest, DeleteRecipeFromTextIndex) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.add_instruction("Bake.");
+  vector<sqlite3_int64> ids;
+  ids.push_back(database.insert_recipe(recipe));
+  database.delete_recipes(ids);
+  int exist = 0;
+  sqlite3_exec(database.db(), "SELECT rowid FROM recipetext WHERE recipetext MATCH 'apple OR bake';", &has_row, &exist, NULL);
+  EXPECT_EQ(exist, 0);
+}
+
+TEST(DatabaseTest, DeleteAllTokensOfRecipeText) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  for (int i=0; i<20; i++)
+    recipe.add_instruction(("Step " + to_string(i) + " of the recipe.").c_str());
+  vector<sqlite3_int64> ids;
+  ids.push_back(database.insert_recipe(recipe));
+  database.delete_recipes(ids);
+  sqlite3_exec(database.db(), "CREATE VIRTUAL TABLE temp.recipetokens USING fts5vocab(main, recipetext, 'row');", NULL,
+               NULL, NULL);
+  int exist = 0;
+  sqlite3_exec(database.db(), "SELECT term FROM recipetokens WHERE cnt > 0;", &has_row, &exist, NULL);
+  EXPECT_EQ(exist, 0);
+}
+
+static void create_version_1(const char *filename) {
+  sqlite3 *db;
+  remove(filename);
+  sqlite3_open(filename, &db);
+  sqlite3_exec(db,
+    "PRAGMA user_version = 1;\n"
+    "CREATE TABLE recipes(id INTEGER PRIMARY KEY, title VARCHAR(60) NOT NULL, servings INTEGER NOT NULL, "
+    "servingsunit VARCHAR(40) NOT NULL);\n"
+    "CREATE TABLE categories(id INTEGER PRIMARY KEY, name VARCHAR(40) UNIQUE NOT NULL);\n"
+    "CREATE TABLE category(recipeid INTEGER NOT NULL, categoryid INTEGER NOT NULL, PRIMARY KEY(recipeid, categoryid), "
+    "FOREIGN KEY(recipeid) REFERENCES recipes(id), FOREIGN KEY(categoryid) REFERENCES categories(id));\n"
+    "CREATE TABLE ingredients(id INTEGER PRIMARY KEY, name VARCHAR(60) UNIQUE NOT NULL);\n"
+    "CREATE TABLE ingredient(recipeid INTEGER NOT NULL, line INTEGER NOT NULL, amountint INTEGER NOT NULL, "
+    "amountnum INTEGER NOT NULL, amountdenom INTEGER NOT NULL, amountfloat REAL NOT NULL, unit CHARACTER(2) NOT NULL, "
+    "ingredientid INTEGER NOT NULL, PRIMARY KEY(recipeid, line), FOREIGN KEY(recipeid) REFERENCES recipes(id), "
+    "FOREIGN KEY(ingredientid) REFERENCES ingredients(id));\n"
+    "CREATE TABLE instruction(recipeid INTEGER NOT NULL, line INTEGER NOT NULL, txt TEXT NOT NULL, "
+    "PRIMARY KEY(recipeid, line), FOREIGN KEY(recipeid) REFERENCES recipes(id));\n"
+    "CREATE TABLE ingredientsection(recipeid INTEGER NOT NULL, line INTEGER NOT NULL, title VARCHAR(60) NOT NULL, "
+    "PRIMARY KEY (recipeid, line), FOREIGN KEY(recipeid) REFERENCES recipes(id));\n"
+    "CREATE TABLE instructionsection(recipeid INTEGER NOT NULL, line INTEGER NOT NULL, title VARCHAR(60) NOT NULL, "
+    "PRIMARY KEY (recipeid, line), FOREIGN KEY(recipeid) REFERENCES recipes(id));\n"
+    "INSERT INTO recipes VALUES(1, 'Apple pie', 1, 'pie');\n"
+    "INSERT INTO ingredients VALUES(1, 'green apples');\n"
+    "INSERT INTO ingredient VALUES(1, 1, 2, 0, 0, 0.0, '  ', 1);\n"
+    "INSERT INTO instruction VALUES(1, 1, 'Bake.');\n",
+    NULL, NULL, NULL);
+  sqlite3_close(db);
+}
+
+TEST(DatabaseTest, MigrateTextIndex) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  create_version_1(filename);
+  Database database;
+  database.open(filename);
+  database.select_by_text("apple bake");
+  EXPECT_EQ(1, database.num_recipes());
+  remove(filename);
+}
+
+TEST(DatabaseTest, MigrateIngredientIndex) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  create_version_1(filename);
+  Database database;
+  database.open(filename);
+  database.select_by_ingredient("een app");
+  EXPECT_EQ(1, database.num_recipes());
+  remove(filename);
+}
+
+TEST(DatabaseTest, MigrateTitleIndex) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  create_version_1(filename);
+  Database database;
+  database.open(filename);
+  database.select_by_title("le p");
+  EXPECT_EQ(1, database.num_recipes());
+  remove(filename);
+}
+
+TEST(DatabaseTest, SelectByIngredientSubstring) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe1;
+  recipe1.set_title("Recipe A");
+  Ingredient ingredient1;
+  ingredient1.add_text("Granny Smith apples");
+  recipe1.add_ingredient(ingredient1);
+  database.insert_recipe(recipe1);
+  Recipe recipe2;
+  recipe2.set_title("Recipe B");
+  Ingredient ingredient2;
+  ingredient2.add_text("bananas");
+  recipe2.add_ingredient(ingredient2);
+  database.insert_recipe(recipe2);
+  database.select_all();
+  database.select_by_ingredient("SMITH APP");
+  ASSERT_EQ(1, database.num_recipes());
+  EXPECT_EQ("Recipe A", database.recipe_info()[0].second);
+  database.select_all();
+  database.select_by_ingredient("na");
+  ASSERT_EQ(1, database.num_recipes());
+  EXPECT_EQ("Recipe B", database.recipe_info()[0].second);
+}
+
+TEST(DatabaseTest, IngredientIndexFollowsGarbageCollection) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  Ingredient ingredient;
+  ingredient.add_text("apples");
+  recipe.add_ingredient(ingredient);
+  vector<sqlite3_int64> ids;
+  ids.push_back(database.insert_recipe(recipe));
+  database.delete_recipes(ids);
+  database.garbage_collect();
+  int exist = 0;
+  sqlite3_exec(database.db(), "SELECT rowid FROM ingredienttext WHERE name LIKE '%apple%';", &has_row, &exist, NULL);
+  EXPECT_EQ(exist, 0);
+}
+
+TEST(DatabaseTest, IngredientFilterUsesIndexes) {
+  Database database;
+  database.open(":memory:");
+  string plan;
+  sqlite3_stmt *stmt;
+  sqlite3_prepare_v2(database.db(), "EXPLAIN QUERY PLAN SELECT recipeid FROM ingredient WHERE ingredientid IN "
+                     "(SELECT rowid FROM ingredienttext WHERE name LIKE '%' || ?001 || '%');", -1, &stmt, NULL);
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+    plan += string((const char *)sqlite3_column_text(stmt, 3)) + "\n";
+  sqlite3_finalize(stmt);
+  EXPECT_NE(string::npos, plan.find("SEARCH ingredient USING COVERING INDEX ingredient_ingredientid")) << plan;
+  EXPECT_NE(string::npos, plan.find("VIRTUAL TABLE INDEX 0:L")) << plan;
+}
+
+TEST(DatabaseTest, RollbackRestoresSelection) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Recipe A");
+  vector<sqlite3_int64> ids;
+  ids.push_back(database.insert_recipe(recipe));
+  database.begin();
+  database.insert_recipe(recipe);
+  database.delete_recipes(ids);
+  EXPECT_EQ(1, database.num_recipes());
+  database.rollback();
+  ASSERT_EQ(1, database.num_recipes());
+  EXPECT_TRUE(database.selection().contains(ids[0]));
+}
+
+TEST(DatabaseTest, ChainFilters) {
+  Database database;
+  database.open(":memory:");
+  for (int i=0; i<6; i++) {
+    Recipe recipe;
+    recipe.set_title(i % 2 ? "Apple pie" : "Apple cake");
+    recipe.add_category(i % 3 ? "Dessert" : "Snack");
+    database.insert_recipe(recipe);
+  };
+  database.select_all();
+  database.select_by_title("apple");
+  database.select_by_category("Dessert");
+  database.select_by_no_category("Snack");
+  database.select_by_title("pie");
+  ASSERT_EQ(2, database.num_recipes());
+  EXPECT_TRUE(database.selection().contains(2));
+  EXPECT_TRUE(database.selection().contains(6));
+  EXPECT_FALSE(database.selection().contains(4));
+  EXPECT_EQ(2, database.recipe_info().size());
+}
+
+TEST(DatabaseTest, SelectionTableLookup) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  database.insert_recipe(recipe);
+  database.insert_recipe(recipe);
+  Bitmap selection;
+  selection.add(2);
+  database.set_selection(selection);
+  int exist = 0;
+  sqlite3_exec(database.db(), "SELECT id FROM selection WHERE id = 2;", &has_row, &exist, NULL);
+  EXPECT_EQ(exist, 1);
+  exist = 0;
+  sqlite3_exec(database.db(), "SELECT id FROM selection WHERE id = 1;", &has_row, &exist, NULL);
+  EXPECT_EQ(exist, 0);
+  exist = 0;
+  sqlite3_exec(database.db(), "SELECT recipes.id FROM recipes, selection WHERE recipes.id = selection.id;", &has_row, &exist,
+               NULL);
+  EXPECT_EQ(exist, 1);
+}
+
+TEST(DatabaseTest, SelectByIngredients) {
+  Database database;
+  database.open(":memory:");
+  const char *ingredients[][3] = {{"butter", "flour", "lemon juice"},
+                                  {"butter", "flour", "lime"},
+                                  {"butter", "flour", "chopped nuts"},
+                                  {"butter", "sugar", "lemon"}};
+  for (int i=0; i<4; i++) {
+    Recipe recipe;
+    for (int j=0; j<3; j++) {
+      Ingredient ingredient;
+      ingredient.add_text(ingredients[i][j]);
+      recipe.add_ingredient(ingredient);
+    };
+    database.insert_recipe(recipe);
+  };
+  vector<string> all;
+  all.push_back("butter");
+  all.push_back("flour");
+  vector<string> any;
+  any.push_back("lemon");
+  any.push_back("lime");
+  vector<string> none;
+  none.push_back("nuts");
+  database.select_by_ingredients(all, vector<string>(), none);
+  EXPECT_EQ(2, database.num_recipes());
+  database.select_all();
+  database.select_by_ingredients(all, any, none);
+  ASSERT_EQ(2, database.num_recipes());
+  EXPECT_TRUE(database.selection().contains(1));
+  EXPECT_TRUE(database.selection().contains(2));
+  database.select_all();
+  database.select_by_ingredients(vector<string>(), any, vector<string>());
+  EXPECT_EQ(3, database.num_recipes());
+}
+
+TEST(DatabaseTest, IngredientIndexFollowsUpdates) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  Ingredient ingredient;
+  ingredient.add_text("butter");
+  recipe.add_ingredient(ingredient);
+  database.insert_recipe(recipe);
+  database.select_by_ingredient("butter");
+  EXPECT_EQ(1, database.num_recipes());
+  sqlite3_int64 id = database.insert_recipe(recipe);
+  database.select_all();
+  database.select_by_ingredient("butter");
+  EXPECT_EQ(2, database.num_recipes());
+  database.delete_recipes(vector<sqlite3_int64>(1, id));
+  database.select_all();
+  database.select_by_ingredient("butter");
+  EXPECT_EQ(1, database.num_recipes());
+  database.begin();
+  database.insert_recipe(recipe);
+  database.rollback();
+  database.select_all();
+  database.select_by_ingredient("butter");
+  EXPECT_EQ(1, database.num_recipes());
+}
+
+TEST(DatabaseTest, SelectByFilter) {
+  Database database;
+  database.open(":memory:");
+  for (int i=0; i<6; i++) {
+    Recipe recipe;
+    recipe.set_title(i % 2 ? "Apple pie" : "Apple cake");
+    recipe.add_category(i % 3 ? "Dessert" : "Snack");
+    Ingredient ingredient;
+    ingredient.add_text(i < 3 ? "green apples" : "chopped nuts");
+    recipe.add_ingredient(ingredient);
+    database.insert_recipe(recipe);
+  };
+  Filter filter;
+  filter.add(Filter::TITLE, "pie").add(Filter::CATEGORY, "snack", true).add(Filter::INGREDIENT, "apple");
+  database.select_by_filter(filter);
+  ASSERT_EQ(1, database.num_recipes());
+  EXPECT_TRUE(database.selection().contains(2));
+  database.select_by_filter(Filter().add(Filter::INGREDIENT, "nuts"));
+  EXPECT_EQ(0, database.num_recipes());
+}
+
+TEST(DatabaseTest, SelectByFilterIgnoresPunctuation) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  database.insert_recipe(recipe);
+  database.select_by_filter(Filter().add(Filter::TEXT, "\"*"));
+  EXPECT_EQ(1, database.num_recipes());
+  database.select_by_filter(Filter().add(Filter::TITLE, "\"*"));
+  EXPECT_EQ(0, database.num_recipes());
+}
+
+TEST(DatabaseTest, SelectByFilterTitleSubstring) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe1;
+  recipe1.set_title("Pancakes");
+  database.insert_recipe(recipe1);
+  Recipe recipe2;
+  recipe2.set_title("Spaghetti");
+  database.insert_recipe(recipe2);
+  database.select_by_filter(Filter().add(Filter::TITLE, "CAKE"));
+  ASSERT_EQ(1, database.num_recipes());
+  EXPECT_TRUE(database.selection().contains(1));
+  database.select_all();
+  database.select_by_filter(Filter().add(Filter::TITLE, "ghetti", true));
+  ASSERT_EQ(1, database.num_recipes());
+  EXPECT_TRUE(database.selection().contains(1));
+}
+
+static string query_plan(Database &database, const string &sql) {
+  string plan;
+  sqlite3_stmt *stmt;
+  sqlite3_prepare_v2(database.db(), ("EXPLAIN QUERY PLAN " + sql).c_str(), -1, &stmt, NULL);
+  while (sqlite3_step(stmt) == SQLITE_ROW)
+    plan += string((const char *)sqlite3_column_text(stmt, 3)) + "\n";
+  sqlite3_finalize(stmt);
+  return plan;
+}
+
+TEST(DatabaseTest, FilterQueryUsesIndexes) {
+  Database database;
+  database.open(":memory:");
+  Filter filter;
+  filter.add(Filter::TITLE, "pie").add(Filter::CATEGORY, "Snack", true).add(Filter::INGREDIENT, "apple");
+  string plan = query_plan(database, filter.sql());
+  EXPECT_NE(string::npos, plan.find("SCAN selection VIRTUAL TABLE INDEX 1:")) << plan;
+  EXPECT_NE(string::npos, plan.find("SCAN titletext VIRTUAL TABLE INDEX 0:L")) << plan;
+  EXPECT_NE(string::npos, plan.find("SEARCH categories USING INTEGER PRIMARY KEY")) << plan;
+  EXPECT_NE(string::npos, plan.find("SEARCH ingredient USING COVERING INDEX ingredient_ingredientid")) << plan;
+  EXPECT_NE(string::npos, plan.find("VIRTUAL TABLE INDEX 0:L")) << plan;
+  EXPECT_EQ(string::npos, plan.find("SCAN ingredient\n")) << plan;
+}
+
+TEST(DatabaseTest, FetchRecipesInRequestedOrder) {
+  Database database;
+  database.open(":memory:");
+  vector<sqlite3_int64> ids;
+  for (int i=0; i<5; i++) {
+    Recipe recipe;
+    ostringstream title;
+    title << "Recipe " << i;
+    recipe.set_title(title.str().c_str());
+    recipe.set_servings(i + 1);
+    if (i % 2)
+      recipe.add_category("Odd");
+    recipe.add_category(i < 3 ? "Small" : "Large");
+    for (int j=0; j<i; j++) {
+      Ingredient ingredient;
+      ostringstream text;
+      text << "ingredient " << i << " " << j;
+      ingredient.add_text(text.str().c_str());
+      recipe.add_ingredient(ingredient);
+      recipe.add_instruction(text.str().c_str());
+    };
+    if (i == 3) {
+      recipe.add_ingredient_section(1, "Topping");
+      recipe.add_instruction_section(2, "Serving");
+    };
+    ids.insert(ids.begin(), database.insert_recipe(recipe));
+  };
+  ids.push_back(ids[1]);
+  vector<Recipe> recipes = database.fetch_recipes(ids);
+  ASSERT_EQ(6, recipes.size());
+  for (int i=0; i<6; i++) {
+    Recipe expected = database.fetch_recipe(ids[i]);
+    EXPECT_EQ(expected.title(), recipes[i].title());
+    EXPECT_EQ(expected.servings(), recipes[i].servings());
+    EXPECT_EQ(expected.categories(), recipes[i].categories());
+    EXPECT_EQ(expected.instructions(), recipes[i].instructions());
+    EXPECT_EQ(expected.ingredient_sections(), recipes[i].ingredient_sections());
+    EXPECT_EQ(expected.instruction_sections(), recipes[i].instruction_sections());
+    ASSERT_EQ(expected.ingredients().size(), recipes[i].ingredients().size());
+    for (unsigned int j=0; j<expected.ingredients().size(); j++)
+      EXPECT_EQ(expected.ingredients()[j].text(), recipes[i].ingredients()[j].text());
+  };
+  EXPECT_EQ("Recipe 4", recipes[0].title());
+  EXPECT_EQ(1, recipes[1].ingredient_sections().size());
+  EXPECT_EQ(1, recipes[5].instruction_sections().size());
+}
+
+TEST(DatabaseTest, FetchRecipesRejectsUnknownId) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  vector<sqlite3_int64> ids;
+  ids.push_back(database.insert_recipe(recipe));
+  ids.push_back(42);
+  EXPECT_THROW(database.fetch_recipes(ids), database_exception);
+}
+
+static int count_rows(Database &database, const char *sql) {
+  int count = 0;
+  sqlite3_exec(database.db(), sql, &has_row, &count, NULL);
+  return count;
+}
+
+TEST(DatabaseTest, InsertRecipeIntoCache) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.add_category("Dessert");
+  recipe.add_instruction("Bake.");
+  database.insert_recipe(recipe);
+  EXPECT_EQ(1, count_rows(database, "SELECT recipeid FROM recipecache WHERE recipeid = 1;"));
+  sqlite3_exec(database.db(), "UPDATE recipes SET title = 'Changed';", NULL, NULL, NULL);
+  EXPECT_EQ("Apple pie", database.fetch_recipe(1).title());
+}
+
+TEST(DatabaseTest, FetchWithoutWritingCache) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.add_category("Dessert");
+  database.insert_recipe(recipe);
+  database.insert_recipe(recipe);
+  sqlite3_exec(database.db(), "DELETE FROM recipecache; UPDATE recipes SET title = 'Changed';", NULL, NULL, NULL);
+  EXPECT_EQ("Changed", database.fetch_recipe(1).title());
+  EXPECT_EQ("Changed", database.fetch_recipes(vector<sqlite3_int64>(1, 2))[0].title());
+  EXPECT_EQ(0, count_rows(database, "SELECT recipeid FROM recipecache;"));
+}
+
+TEST(DatabaseTest, IgnoreCorruptCacheEntry) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  database.insert_recipe(recipe);
+  sqlite3_exec(database.db(), "UPDATE recipecache SET data = x'01ff';", NULL, NULL, NULL);
+  EXPECT_EQ("Apple pie", database.fetch_recipe(1).title());
+  sqlite3_exec(database.db(), "UPDATE recipecache SET data = x'01ff';", NULL, NULL, NULL);
+  EXPECT_EQ("Apple pie", database.fetch_recipes(vector<sqlite3_int64>(1, 1))[0].title());
+}
+
+TEST(DatabaseTest, CategoryChangesUpdateCache) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.add_category("A");
+  database.insert_recipe(recipe);
+  database.insert_recipe(recipe);
+  database.rename_category("A", "B");
+  EXPECT_EQ(2, count_rows(database, "SELECT recipeid FROM recipecache;"));
+  ASSERT_EQ(1, database.fetch_recipe(1).categories().size());
+  EXPECT_EQ("B", *database.fetch_recipe(1).categories().begin());
+  database.add_recipes_to_category(vector<sqlite3_int64>(1, 1), "C");
+  EXPECT_EQ(2, count_rows(database, "SELECT recipeid FROM recipecache;"));
+  EXPECT_EQ(2, database.fetch_recipe(1).categories().size());
+  database.remove_recipes_from_category(vector<sqlite3_int64>(1, 1), "B");
+  EXPECT_EQ(1, database.fetch_recipe(1).categories().size());
+  database.merge_category("B", "C");
+  EXPECT_EQ(2, count_rows(database, "SELECT recipeid FROM recipecache;"));
+  ASSERT_EQ(1, database.fetch_recipe(2).categories().size());
+  EXPECT_EQ("C", *database.fetch_recipe(2).categories().begin());
+  database.delete_category("C");
+  EXPECT_EQ(2, count_rows(database, "SELECT recipeid FROM recipecache;"));
+  EXPECT_EQ(0, database.fetch_recipe(1).categories().size());
+  EXPECT_EQ(0, database.fetch_recipe(2).categories().size());
+}
+
+TEST(DatabaseTest, ServeFromCacheAfterCategoryChange) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.add_category("A");
+  database.insert_recipe(recipe);
+  database.add_recipes_to_category(vector<sqlite3_int64>(1, 1), "B");
+  sqlite3_exec(database.db(), "UPDATE recipes SET title = 'Changed';", NULL, NULL, NULL);
+  Recipe result = database.fetch_recipes(vector<sqlite3_int64>(1, 1))[0];
+  EXPECT_EQ("Apple pie", result.title());
+  EXPECT_EQ(2, result.categories().size());
+}
+
+TEST(DatabaseTest, MigrateRecipeCache) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  create_version_1(filename);
+  sqlite3 *db;
+  sqlite3_open(filename, &db);
+  sqlite3_exec(db, "INSERT INTO categories VALUES(1, 'Dessert'); INSERT INTO category VALUES(1, 1);", NULL, NULL, NULL);
+  sqlite3_close(db);
+  Database database;
+  database.open(filename);
+  EXPECT_EQ(1, count_rows(database, "SELECT recipeid FROM recipecache;"));
+  sqlite3_exec(database.db(), "UPDATE recipes SET title = 'Changed';", NULL, NULL, NULL);
+  Recipe recipe = database.fetch_recipe(1);
+  EXPECT_EQ("Apple pie", recipe.title());
+  ASSERT_EQ(1, recipe.ingredients().size());
+  EXPECT_EQ(1, recipe.categories().size());
+  remove(filename);
+}
+
+TEST(DatabaseTest, ReuseIngredientAndCategoryIds) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.add_category("Dessert");
+  Ingredient ingredient;
+  ingredient.add_text("butter");
+  recipe.add_ingredient(ingredient);
+  recipe.add_ingredient(ingredient);
+  database.insert_recipe(recipe);
+  database.insert_recipe(recipe);
+  EXPECT_EQ(1, count_rows(database, "SELECT id FROM ingredients;"));
+  EXPECT_EQ(1, count_rows(database, "SELECT id FROM categories;"));
+  EXPECT_EQ(4, count_rows(database, "SELECT recipeid FROM ingredient WHERE ingredientid = 1;"));
+  EXPECT_EQ(2, database.count_recipes("Dessert"));
+}
+
+TEST(DatabaseTest, IdCachesSurviveRollback) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.add_category("Dessert");
+  Ingredient ingredient;
+  ingredient.add_text("butter");
+  recipe.add_ingredient(ingredient);
+  database.begin();
+  database.insert_recipe(recipe);
+  database.rollback();
+  database.insert_recipe(recipe);
+  Recipe result = database.fetch_recipes(vector<sqlite3_int64>(1, 1))[0];
+  ASSERT_EQ(1, result.categories().size());
+  EXPECT_EQ("Dessert", *result.categories().begin());
+  ASSERT_EQ(1, result.ingredients().size());
+  EXPECT_EQ("butter", result.ingredients()[0].text());
+}
+
+TEST(DatabaseTest, IdCachesFollowCategoryChanges) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.add_category("A");
+  Ingredient ingredient;
+  ingredient.add_text("butter");
+  recipe.add_ingredient(ingredient);
+  database.insert_recipe(recipe);
+  database.rename_category("A", "B");
+  database.insert_recipe(recipe);
+  EXPECT_EQ(1, database.count_recipes("A"));
+  EXPECT_EQ(1, database.count_recipes("B"));
+  database.delete_recipes(vector<sqlite3_int64>(1, 1));
+  database.delete_recipes(vector<sqlite3_int64>(1, 2));
+  database.garbage_collect();
+  database.insert_recipe(recipe);
+  EXPECT_EQ(1, database.count_recipes("A"));
+  EXPECT_EQ(1, count_rows(database, "SELECT id FROM ingredients;"));
+  database.select_all();
+  database.select_by_ingredient("butter");
+  EXPECT_EQ(1, database.num_recipes());
+}
+
+TEST(DatabaseTest, DeleteRecipesInBulk) {
+  Database database;
+  database.open(":memory:");
+  vector<sqlite3_int64> ids;
+  for (int i=0; i<3; i++) {
+    Recipe recipe;
+    recipe.set_title("Apple pie");
+    recipe.add_category("Dessert");
+    Ingredient ingredient;
+    ingredient.add_text("butter");
+    recipe.add_ingredient(ingredient);
+    recipe.add_ingredient_section(0, "Dough");
+    recipe.add_instruction("Bake.");
+    recipe.add_instruction_section(0, "Baking");
+    ids.push_back(database.insert_recipe(recipe));
+  };
+  database.select_by_ingredient("butter");
+  ids.erase(ids.begin() + 1);
+  ids.push_back(ids[0]);
+  database.delete_recipes(ids);
+  EXPECT_EQ(1, database.num_recipes());
+  EXPECT_EQ(1, count_rows(database, "SELECT id FROM recipes;"));
+  EXPECT_EQ(1, count_rows(database, "SELECT recipeid FROM category;"));
+  EXPECT_EQ(1, count_rows(database, "SELECT recipeid FROM ingredient;"));
+  EXPECT_EQ(1, count_rows(database, "SELECT recipeid FROM instruction;"));
+  EXPECT_EQ(1, count_rows(database, "SELECT recipeid FROM ingredientsection;"));
+  EXPECT_EQ(1, count_rows(database, "SELECT recipeid FROM instructionsection;"));
+  EXPECT_EQ(1, count_rows(database, "SELECT recipeid FROM recipecache;"));
+  database.select_all();
+  database.select_by_text("apple");
+  EXPECT_EQ(1, database.num_recipes());
+  database.select_by_ingredient("butter");
+  EXPECT_EQ(1, database.num_recipes());
+}
+
+static vector<sqlite3_int64> insert_benchmark_recipes(Database &database, int n) {
+  vector<sqlite3_int64> ids;
+  database.begin();
+  for (int i=0; i<n; i++) {
+    Recipe recipe;
+    recipe.set_title("Recipe");
+    recipe.add_category(i % 2 ? "A" : "B");
+    for (int j=0; j<8; j++) {
+      ostringstream text;
+      text << "ingredient " << j * i % 300;
+      Ingredient ingredient;
+      ingredient.add_text(text.str().c_str());
+      recipe.add_ingredient(ingredient);
+      recipe.add_instruction("Stir well and bake.");
+    };
+    ids.push_back(database.insert_recipe(recipe));
+  };
+  database.commit();
+  return ids;
+}
+
+TEST(DatabaseTest, DISABLED_BenchmarkDeleteRecipes) {
+  const int n = 20000;
+  Database bulk;
+  bulk.open(":memory:");
+  vector<sqlite3_int64> ids = insert_benchmark_recipes(bulk, n);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  bulk.begin();
+  bulk.delete_recipes(ids);
+  bulk.commit();
+  double bulk_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  Database single;
+  single.open(":memory:");
+  ids = insert_benchmark_recipes(single, n);
+  start = chrono::steady_clock::now();
+  single.begin();
+  for (vector<sqlite3_int64>::iterator id=ids.begin(); id!=ids.end(); id++)
+    single.delete_recipes(vector<sqlite3_int64>(1, *id));
+  single.commit();
+  double single_time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  cout << "Deleting " << n << " recipes: " << bulk_time << " s in bulk, " << single_time << " s one by one" << endl;
+  EXPECT_EQ(0, count_rows(bulk, "SELECT id FROM recipes;"));
+  EXPECT_EQ(0, count_rows(single, "SELECT id FROM recipes;"));
+}
+
+static void count_progress(int step, int steps, void *data) {
+  vector<pair<int, int> > *calls = (vector<pair<int, int> > *)data;
+  calls->push_back(make_pair(step, steps));
+}
+
+TEST(DatabaseTest, MigrationProgress) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  create_version_1(filename);
+  vector<pair<int, int> > calls;
+  {
+    Database database;
+    database.open(filename, &count_progress, &calls);
+  }
+  int steps = SCHEMA_VERSION - 1;
+  ASSERT_EQ(steps + 1, calls.size());
+  for (int i=0; i<=steps; i++) {
+    EXPECT_EQ(i, calls[i].first);
+    EXPECT_EQ(steps, calls[i].second);
+  };
+  calls.clear();
+  Database database;
+  database.open(filename, &count_progress, &calls);
+  EXPECT_TRUE(calls.empty());
+  remove(filename);
+}
+
+static int read_int(void *value, int, char **text, char **) {
+  *(int *)value = atoi(text[0]);
+  return 0;
+}
+
+TEST(DatabaseTest, MigrateToLatestVersion) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  create_version_1(filename);
+  Database database;
+  database.open(filename);
+  int version = 0;
+  sqlite3_exec(database.db(), "PRAGMA user_version;", &read_int, &version, NULL);
+  EXPECT_EQ(SCHEMA_VERSION, version);
+  EXPECT_EQ(1, count_rows(database, "SELECT name FROM sqlite_master WHERE name = 'category_categoryid';"));
+  EXPECT_EQ(1, count_rows(database, "SELECT name FROM sqlite_master WHERE name = 'recipes_title';"));
+  remove(filename);
+}
+
+TEST(DatabaseTest, RejectNewerSchema) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  {
+    Database database;
+    database.open(filename);
+    sqlite3_exec(database.db(), "PRAGMA user_version = 99;", NULL, NULL, NULL);
+  }
+  Database database;
+  EXPECT_THROW(database.open(filename), database_exception);
+  remove(filename);
+}
+
+TEST(DatabaseTest, CategoryStatementsUseIndexes) {
+  Database database;
+  database.open(":memory:");
+  string plan = query_plan(database, "DELETE FROM categories WHERE id NOT IN (SELECT categoryid FROM category);");
+  EXPECT_NE(string::npos, plan.find("SEARCH category USING COVERING INDEX category_categoryid")) << plan;
+  plan = query_plan(database, "DELETE FROM ingredients WHERE id NOT IN (SELECT ingredientid FROM ingredient);");
+  EXPECT_NE(string::npos, plan.find("SEARCH ingredient USING COVERING INDEX ingredient_ingredientid")) << plan;
+  plan = query_plan(database, "DELETE FROM category WHERE categoryid = ?001;");
+  EXPECT_NE(string::npos, plan.find("SEARCH category USING COVERING INDEX category_categoryid")) << plan;
+  plan = query_plan(database, "SELECT COUNT(recipeid) FROM category, categories WHERE categoryid = id AND name = ?001");
+  EXPECT_NE(string::npos, plan.find("SEARCH category USING COVERING INDEX category_categoryid")) << plan;
+}
+
+TEST(DatabaseTest, RecipeInfoPages) {
+  Database database;
+  database.open(":memory:");
+  const char *titles[] = {"b", "A", "c", "B", "a", "C", "a"};
+  for (int i=0; i<7; i++) {
+    Recipe recipe;
+    recipe.set_title(titles[i]);
+    database.insert_recipe(recipe);
+  };
+  Bitmap selection = database.selection();
+  selection.remove(6);
+  database.set_selection(selection);
+  TitleArena paged;
+  TitleArena page;
+  database.recipe_info_page("", 0, 4, page);
+  EXPECT_EQ(4, page.size());
+  while (!page.empty()) {
+    for (size_t i=0; i<page.size(); i++)
+      paged.push_back(page.id(i), page.title(i));
+    string title = page.title(page.size() - 1);
+    sqlite3_int64 id = page.id(page.size() - 1);
+    page.clear();
+    database.recipe_info_page(title.c_str(), id, 4, page);
+  };
+  ASSERT_EQ(6, paged.size());
+  EXPECT_EQ(2, paged.id(0));
+  EXPECT_EQ(5, paged.id(1));
+  EXPECT_EQ(7, paged.id(2));
+  EXPECT_EQ(1, paged.id(3));
+  EXPECT_EQ(4, paged.id(4));
+  EXPECT_EQ(3, paged.id(5));
+  EXPECT_STREQ("a", paged.title(2));
+}
+
+TEST(DatabaseTest, RecipeInfoPageUsesTitleIndex) {
+  Database database;
+  database.open(":memory:");
+  string plan = query_plan(database, "SELECT recipes.id, title FROM recipes CROSS JOIN selection ON selection.id = recipes.id "
+                           "WHERE title COLLATE NOCASE >= ?001 AND (title COLLATE NOCASE > ?001 OR recipes.id > ?002) "
+                           "ORDER BY title COLLATE NOCASE, recipes.id LIMIT ?003;");
+  EXPECT_NE(string::npos, plan.find("SEARCH recipes USING COVERING INDEX recipes_title (title>?)")) << plan;
+  EXPECT_EQ(string::npos, plan.find("TEMP B-TREE")) << plan;
+}
+
+static int cancel_query(void *data) {
+  (*(int *)data)++;
+  return 1;
+}
+
+TEST(DatabaseTest, CancelFilterWithProgressHandler) {
+  Database database;
+  database.open(":memory:");
+  insert_benchmark_recipes(database, 200);
+  int calls = 0;
+  database.set_progress_handler(&cancel_query, &calls);
+  Filter filter;
+  filter.add(Filter::CATEGORY, "A");
+  EXPECT_THROW(database.select_by_filter(filter), database_exception);
+  EXPECT_LT(0, calls);
+  EXPECT_EQ(200, database.num_recipes());
+  database.set_progress_handler(NULL, NULL);
+  database.select_by_filter(filter);
+  EXPECT_EQ(100, database.num_recipes());
+}
+
+TEST(DatabaseTest, InterruptWithoutRunningQuery) {
+  Database database;
+  database.interrupt();
+  database.open(":memory:");
+  database.interrupt();
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  database.insert_recipe(recipe);
+  EXPECT_EQ(1, database.recipe_info().size());
+}
+
+static int count_statements(unsigned int, void *data, void *statement, void *) {
+  if (strcmp(sqlite3_sql((sqlite3_stmt *)statement), "PRAGMA data_version;") != 0)
+    (*(int *)data)++;
+  return 0;
+}
+
+TEST(DatabaseTest, ReplayCachedFilterChain) {
+  Database database;
+  database.open(":memory:");
+  insert_benchmark_recipes(database, 100);
+  Filter category;
+  category.add(Filter::CATEGORY, "A");
+  Filter ingredient;
+  ingredient.add(Filter::INGREDIENT, "ingredient 3");
+  database.select_all();
+  database.select_by_filter(category);
+  database.select_by_filter(ingredient);
+  Bitmap expected = database.selection();
+  database.select_all();
+  int statements = 0;
+  sqlite3_trace_v2(database.db(), SQLITE_TRACE_STMT, &count_statements, &statements);
+  Filter same_category;
+  same_category.add(Filter::CATEGORY, "a");
+  database.select_by_filter(same_category);
+  database.select_by_filter(ingredient);
+  sqlite3_trace_v2(database.db(), 0, NULL, NULL);
+  EXPECT_EQ(0, statements);
+  EXPECT_TRUE(expected == database.selection());
+  EXPECT_EQ(string("*") + category.key() + ingredient.key(), database.chain());
+}
+
+TEST(DatabaseTest, FilterChainDependsOnOrder) {
+  Database database;
+  database.open(":memory:");
+  insert_benchmark_recipes(database, 100);
+  Filter category;
+  category.add(Filter::CATEGORY, "A");
+  Filter no_category;
+  no_category.add(Filter::CATEGORY, "A", true);
+  database.select_all();
+  database.select_by_filter(category);
+  database.select_all();
+  database.select_by_filter(no_category);
+  EXPECT_EQ(50, database.num_recipes());
+  EXPECT_FALSE(database.selection().contains(2));
+}
+
+TEST(DatabaseTest, InsertInvalidatesFilterCache) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.add_category("Dessert");
+  database.insert_recipe(recipe);
+  Filter filter;
+  filter.add(Filter::CATEGORY, "Dessert");
+  database.select_by_filter(filter);
+  EXPECT_EQ(1, database.num_recipes());
+  database.insert_recipe(recipe);
+  EXPECT_EQ("", database.chain());
+  database.select_all();
+  database.select_by_filter(filter);
+  EXPECT_EQ(2, database.num_recipes());
+}
+
+TEST(DatabaseTest, CategoryChangeInvalidatesFilterCache) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  vector<sqlite3_int64> ids;
+  ids.push_back(database.insert_recipe(recipe));
+  database.select_all();
+  Filter filter;
+  filter.add(Filter::CATEGORY, "Dessert");
+  database.select_by_filter(filter);
+  EXPECT_EQ(0, database.num_recipes());
+  database.add_recipes_to_category(ids, "Dessert");
+  database.select_all();
+  database.select_by_filter(filter);
+  EXPECT_EQ(1, database.num_recipes());
+}
+
+TEST(DatabaseTest, OtherConnectionInvalidatesFilterCache) {
+  const char *filename = "/tmp/anymeal-test-cache.sqlite";
+  remove(filename);
+  {
+    Database database;
+    database.open(filename);
+    Database other;
+    other.open(filename);
+    Recipe recipe;
+    recipe.set_title("Apple pie");
+    recipe.add_category("Dessert");
+    database.insert_recipe(recipe);
+    Filter filter;
+    filter.add(Filter::CATEGORY, "Dessert");
+    other.select_all();
+    other.select_by_filter(filter);
+    EXPECT_EQ(1, other.num_recipes());
+    database.insert_recipe(recipe);
+    other.select_all();
+    other.select_by_filter(filter);
+    EXPECT_EQ(2, other.num_recipes());
+  };
+  remove(filename);
+}
+
+TEST(DatabaseTest, OtherConnectionInvalidatesIngredientIndex) {
+  const char *filename = "/tmp/anymeal-test-cache.sqlite";
+  remove(filename);
+  {
+    Database database;
+    database.open(filename);
+    Database other;
+    other.open(filename);
+    Recipe recipe;
+    Ingredient ingredient;
+    ingredient.add_text("butter");
+    recipe.add_ingredient(ingredient);
+    database.insert_recipe(recipe);
+    other.select_all();
+    other.select_by_filter(Filter().add(Filter::INGREDIENT, "butter"));
+    EXPECT_EQ(1, other.num_recipes());
+    database.insert_recipe(recipe);
+    other.select_all();
+    other.select_by_ingredient("butter");
+    EXPECT_EQ(2, other.num_recipes());
+  };
+  remove(filename);
+}
+
+TEST(DatabaseTest, FilterIngredientsUsingIndex) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  Ingredient ingredient;
+  ingredient.add_text("butter");
+  recipe.add_ingredient(ingredient);
+  database.insert_recipe(recipe);
+  database.select_by_ingredient("butter");
+  // Rows deleted behind the back of the database are still in the ingredient index.
+  sqlite3_exec(database.db(), "DELETE FROM ingredient;", NULL, NULL, NULL);
+  database.select_all();
+  database.select_by_filter(Filter().add(Filter::INGREDIENT, "butter"));
+  EXPECT_EQ(1, database.num_recipes());
+  database.select_by_filter(Filter().add(Filter::INGREDIENT, "butter", true));
+  EXPECT_EQ(0, database.num_recipes());
+}
+
+TEST(DatabaseTest, PassFilterChainWithSelection) {
+  Database database;
+  database.open(":memory:");
+  insert_benchmark_recipes(database, 10);
+  database.select_all();
+  Filter filter;
+  filter.add(Filter::CATEGORY, "A");
+  database.select_by_filter(filter);
+  EXPECT_EQ(string("*") + filter.key(), database.chain());
+  Database other;
+  other.open(":memory:");
+  other.set_selection(database.selection(), database.chain());
+  EXPECT_EQ(database.chain(), other.chain());
+  other.set_selection(database.selection());
+  EXPECT_EQ("", other.chain());
+}
+
+TEST(DatabaseTest, CountRecipesOfUnknownCategory) {
+  Database database;
+  database.open(":memory:");
+  EXPECT_EQ(0, database.count_recipes("A"));
+}
+
+TEST(DatabaseTest, MaintainCategoryCounts) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.add_category("A");
+  recipe.add_category("B");
+  vector<sqlite3_int64> ids;
+  ids.push_back(database.insert_recipe(recipe));
+  ids.push_back(database.insert_recipe(recipe));
+  EXPECT_EQ(2, database.count_recipes("A"));
+  database.remove_recipes_from_category(vector<sqlite3_int64>(1, ids[0]), "A");
+  EXPECT_EQ(1, database.count_recipes("A"));
+  database.add_recipes_to_category(ids, "C");
+  EXPECT_EQ(2, database.count_recipes("C"));
+  database.delete_recipes(vector<sqlite3_int64>(1, ids[1]));
+  EXPECT_EQ(0, database.count_recipes("A"));
+  EXPECT_EQ(1, database.count_recipes("B"));
+  EXPECT_EQ(1, database.count_recipes("C"));
+  EXPECT_TRUE(database.check_category_counts());
+}
+
+TEST(DatabaseTest, MergeOverlappingCategoriesKeepsCounts) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe1;
+  recipe1.add_category("A");
+  recipe1.add_category("B");
+  database.insert_recipe(recipe1);
+  Recipe recipe2;
+  recipe2.add_category("A");
+  database.insert_recipe(recipe2);
+  database.merge_category("A", "B");
+  EXPECT_EQ(2, database.count_recipes("B"));
+  EXPECT_TRUE(database.check_category_counts());
+}
+
+TEST(DatabaseTest, RenameCategoryKeepsCountAndCache) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.add_category("A");
+  database.insert_recipe(recipe);
+  database.insert_recipe(recipe);
+  EXPECT_EQ(2, database.count_recipes("A"));
+  EXPECT_EQ(2, count_rows(database, "SELECT recipeid FROM recipecache;"));
+  database.rename_category("A", "B");
+  EXPECT_EQ(2, database.count_recipes("B"));
+  EXPECT_EQ(2, count_rows(database, "SELECT recipeid FROM recipecache;"));
+}
+
+TEST(DatabaseTest, RebuildCategoryCounts) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.add_category("A");
+  database.insert_recipe(recipe);
+  sqlite3_exec(database.db(), "UPDATE categories SET recipecount = 5;", NULL, NULL, NULL);
+  EXPECT_FALSE(database.check_category_counts());
+  database.rebuild_category_counts();
+  EXPECT_TRUE(database.check_category_counts());
+  EXPECT_EQ(1, database.count_recipes("A"));
+}
+
+TEST(DatabaseTest, GarbageCollectionRepairsCategoryCounts) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.add_category("A");
+  database.insert_recipe(recipe);
+  sqlite3_exec(database.db(), "UPDATE categories SET recipecount = 5;", NULL, NULL, NULL);
+  database.garbage_collect();
+  EXPECT_EQ(1, database.count_recipes("A"));
+}
+
+TEST(DatabaseTest, MigrateCategoryCounts) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  create_version_1(filename);
+  Database database;
+  database.open(filename);
+  EXPECT_TRUE(database.check_category_counts());
+  vector<pair<string, int> > counts = database.categories_and_counts();
+  int total = 0;
+  for (vector<pair<string, int> >::iterator count=counts.begin(); count!=counts.end(); count++)
+    total += count->second;
+  EXPECT_EQ(count_rows(database, "SELECT recipeid FROM category;"), total);
+  remove(filename);
+}
+
+TEST(DatabaseTest, CategoryCountsDoNotScanCategoryTable) {
+  Database database;
+  database.open(":memory:");
+  string plan = query_plan(database, "SELECT name, recipecount FROM categories ORDER BY name;");
+  EXPECT_EQ(string::npos, plan.find("category ")) << plan;
+  plan = query_plan(database, "SELECT recipecount FROM categories WHERE name = ?001;");
+  EXPECT_NE(string::npos, plan.find("SEARCH categories USING INDEX")) << plan;
+}
+
+TEST(DatabaseTest, CountFacetsOfSelection) {
+  Database database;
+  database.open(":memory:");
+  insert_benchmark_recipes(database, 10);
+  database.select_all();
+  Facets facets;
+  database.count_facets(facets);
+  vector<pair<string, int> > categories = database.category_facets(facets);
+  ASSERT_EQ(2, categories.size());
+  EXPECT_EQ("A", categories[0].first);
+  EXPECT_EQ(5, categories[0].second);
+  EXPECT_EQ("B", categories[1].first);
+  vector<pair<string, int> > ingredients = database.ingredient_facets(facets, 2);
+  ASSERT_EQ(2, ingredients.size());
+  EXPECT_EQ("ingredient 0", ingredients[0].first);
+  EXPECT_EQ(10, ingredients[0].second);
+  EXPECT_GT(10, ingredients[1].second);
+}
+
+TEST(DatabaseTest, SortCategoryFacetsByCountAndName) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe1;
+  recipe1.add_category("C");
+  recipe1.add_category("B");
+  database.insert_recipe(recipe1);
+  Recipe recipe2;
+  recipe2.add_category("A");
+  recipe2.add_category("B");
+  database.insert_recipe(recipe2);
+  database.select_all();
+  Facets facets;
+  database.count_facets(facets);
+  vector<pair<string, int> > categories = database.category_facets(facets);
+  ASSERT_EQ(3, categories.size());
+  EXPECT_EQ("B", categories[0].first);
+  EXPECT_EQ("A", categories[1].first);
+  EXPECT_EQ("C", categories[2].first);
+  EXPECT_EQ(database.categories(), vector<string>({"B", "A", "C"}));
+}
+
+static void expect_same_facets(Database &database, Facets &facets) {
+  Facets expected;
+  database.count_facets(expected);
+  EXPECT_EQ(expected.categories(), facets.categories());
+  EXPECT_EQ(expected.ingredients(1000), facets.ingredients(1000));
+}
+
+TEST(DatabaseTest, CountFacetsIncrementally) {
+  Database database;
+  database.open(":memory:");
+  insert_benchmark_recipes(database, 100);
+  database.select_all();
+  Facets facets;
+  database.count_facets(facets);
+  Filter filter;
+  filter.add(Filter::CATEGORY, "A");
+  database.select_by_filter(filter);
+  database.count_facets(facets);
+  expect_same_facets(database, facets);
+  Filter ingredient;
+  ingredient.add(Filter::INGREDIENT, "ingredient 3");
+  database.select_by_filter(ingredient);
+  database.count_facets(facets);
+  expect_same_facets(database, facets);
+  EXPECT_TRUE(facets.ids() == database.selection());
+}
+
+TEST(DatabaseTest, RecountFacetsOfWiderSelection) {
+  Database database;
+  database.open(":memory:");
+  insert_benchmark_recipes(database, 20);
+  Filter filter;
+  filter.add(Filter::CATEGORY, "A");
+  database.select_all();
+  database.select_by_filter(filter);
+  Facets facets;
+  database.count_facets(facets);
+  database.select_all();
+  database.count_facets(facets);
+  expect_same_facets(database, facets);
+  EXPECT_EQ(20, facets.category_count(database.get_category_id("A")) +
+                facets.category_count(database.get_category_id("B")));
+}
+
+TEST(DatabaseTest, RecountFacetsAfterModification) {
+  Database database;
+  database.open(":memory:");
+  insert_benchmark_recipes(database, 20);
+  database.select_all();
+  Facets facets;
+  database.count_facets(facets);
+  vector<sqlite3_int64> ids = database.selection().ids();
+  database.remove_recipes_from_category(vector<sqlite3_int64>(1, ids[1]), "A");
+  database.count_facets(facets);
+  expect_same_facets(database, facets);
+  EXPECT_EQ(9, facets.category_count(database.get_category_id("A")));
+}
+
+TEST(DatabaseTest, CountFacetsByRecipeId) {
+  Database database;
+  database.open(":memory:");
+  string plan = query_plan(database, "SELECT 0, recipeid, categoryid FROM facetids CROSS JOIN category "
+                                     "ON category.recipeid = facetids.id UNION ALL "
+                                     "SELECT 1, recipeid, ingredientid FROM facetids CROSS JOIN ingredient "
+                                     "ON ingredient.recipeid = facetids.id;");
+  EXPECT_NE(string::npos, plan.find("SEARCH category USING")) << plan;
+  EXPECT_NE(string::npos, plan.find("SEARCH ingredient USING")) << plan;
+}
+
+static sqlite3_int64 content_hash(Database &database, sqlite3_int64 id) {
+  sqlite3_stmt *statement;
+  sqlite3_prepare_v2(database.db(), "SELECT contenthash FROM recipes WHERE id = ?001;", -1, &statement, NULL);
+  sqlite3_bind_int64(statement, 1, id);
+  sqlite3_step(statement);
+  sqlite3_int64 result = sqlite3_column_int64(statement, 0);
+  sqlite3_finalize(statement);
+  return result;
+}
+
+TEST(DatabaseTest, StoreContentHash) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.set_servings(4);
+  Ingredient ingredient;
+  ingredient.set_amount_float(1.5);
+  ingredient.set_unit("kg");
+  ingredient.add_text("apples");
+  recipe.add_ingredient(ingredient);
+  recipe.add_ingredient_section(0, "Filling");
+  recipe.add_instruction("Bake.");
+  sqlite3_int64 id = database.insert_recipe(recipe);
+  Recipe result = database.fetch_recipe(id);
+  EXPECT_EQ((sqlite3_int64)hash_recipe(result), content_hash(database, id));
+}
+
+TEST(DatabaseTest, MigrateContentHashes) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  create_version_1(filename);
+  Database database;
+  database.open(filename);
+  EXPECT_EQ(0, count_rows(database, "SELECT id FROM recipes WHERE contenthash IS NULL;"));
+  Recipe recipe = database.fetch_recipe(1);
+  EXPECT_EQ((sqlite3_int64)hash_recipe(recipe), content_hash(database, 1));
+  remove(filename);
+}
+
+TEST(DatabaseTest, OpenWithoutComputingHashes) {
+  const char *filename = "/tmp/anymeal-test-migrate.sqlite";
+  create_version_1(filename);
+  {
+    Database database;
+    database.open(filename);
+    sqlite3_exec(database.db(), "UPDATE recipes SET contenthash = NULL;", NULL, NULL, NULL);
+  }
+  Database database;
+  database.open(filename);
+  EXPECT_EQ(1, count_rows(database, "SELECT id FROM recipes WHERE contenthash IS NULL;"));
+  remove(filename);
+}
+
+TEST(DatabaseTest, FindDuplicates) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.add_category("Baking");
+  recipe.add_instruction("Bake.");
+  sqlite3_int64 id1 = database.insert_recipe(recipe);
+  sqlite3_int64 id2 = database.insert_recipe(recipe);
+  Recipe other = recipe;
+  other.set_title("Pear pie");
+  sqlite3_int64 id3 = database.insert_recipe(other);
+  Recipe category = recipe;
+  category.add_category("Desserts");
+  sqlite3_int64 id4 = database.insert_recipe(category);
+  sqlite3_int64 id5 = database.insert_recipe(recipe);
+  EXPECT_EQ(vector<sqlite3_int64>({id2, id5}), database.duplicates(vector<sqlite3_int64>({id5, id4, id3, id2, id1})));
+  EXPECT_EQ(vector<sqlite3_int64>({id5}), database.duplicates(vector<sqlite3_int64>({id2, id3, id4, id5})));
+  EXPECT_TRUE(database.duplicates(vector<sqlite3_int64>({id1, id3, id4})).empty());
+}
+
+TEST(DatabaseTest, DuplicatesIgnoreOrderOfCategories) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.add_category("B");
+  sqlite3_int64 id1 = database.insert_recipe(recipe);
+  recipe.add_category("A");
+  sqlite3_int64 id2 = database.insert_recipe(recipe);
+  database.add_recipes_to_category(vector<sqlite3_int64>(1, id1), "A");
+  EXPECT_EQ(vector<sqlite3_int64>({id2}), database.duplicates(vector<sqlite3_int64>({id1, id2})));
+}
+
+TEST(DatabaseTest, DuplicatesFollowCategoryChanges) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  sqlite3_int64 id1 = database.insert_recipe(recipe);
+  sqlite3_int64 id2 = database.insert_recipe(recipe);
+  database.add_recipes_to_category(vector<sqlite3_int64>(1, id2), "Baking");
+  EXPECT_TRUE(database.duplicates(vector<sqlite3_int64>({id1, id2})).empty());
+  database.add_recipes_to_category(vector<sqlite3_int64>(1, id1), "Baking");
+  EXPECT_EQ(vector<sqlite3_int64>({id2}), database.duplicates(vector<sqlite3_int64>({id1, id2})));
+}
+
+TEST(DatabaseTest, RecipeFeatures) {
+  Database database;
+  database.open(":memory:");
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  Ingredient apples;
+  apples.add_text("apples");
+  recipe.add_ingredient(apples);
+  recipe.add_ingredient(apples);
+  Ingredient sugar;
+  sugar.add_text("sugar");
+  recipe.add_ingredient(sugar);
+  sqlite3_int64 id1 = database.insert_recipe(recipe);
+  Recipe other;
+  other.set_title("Sugar");
+  sqlite3_int64 id2 = database.insert_recipe(other);
+  vector<RecipeFeatures> features = database.recipe_features(vector<sqlite3_int64>({id2, id1}));
+  ASSERT_EQ(2, features.size());
+  EXPECT_EQ(id1, features[0].id);
+  EXPECT_EQ(4, features[0].features.size());
+  EXPECT_TRUE(is_sorted(features[0].features.begin(), features[0].features.end()));
+  EXPECT_EQ(id2, features[1].id);
+  EXPECT_EQ(title_features("sugar"), features[1].features);
+}
+
+TEST(DatabaseTest, FindNearDuplicates) {
+  Database database;
+  database.open(":memory:");
+  vector<sqlite3_int64> ids;
+  for (int i=0; i<3; i++) {
+    Recipe recipe;
+    recipe.set_title(i == 1 ? "Banana bread" : "Apple pie");
+    for (int j=0; j<10 + i; j++) {
+      ostringstream text;
+      text << (i == 1 ? "banana " : "apple ") << j;
+      Ingredient ingredient;
+      ingredient.add_text(text.str().c_str());
+      recipe.add_ingredient(ingredient);
+    };
+    ids.push_back(database.insert_recipe(recipe));
+  };
+  NearDuplicates near_duplicates(16, 4);
+  vector<vector<sqlite3_int64> > clusters = near_duplicates.clusters(database.recipe_features(ids), 0.8);
+  ASSERT_EQ(1, clusters.size());
+  EXPECT_EQ(vector<sqlite3_int64>({ids[0], ids[2]}), clusters[0]);
+}
@@ -0,0 +1,85 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <gtest/gtest.h>
+#include "facets.hh"
+
+
+using namespace std;
+
+TEST(FacetsTest, EmptyByDefault) {
+  Facets facets;
+  EXPECT_TRUE(facets.ids().empty());
+  EXPECT_EQ(-1, facets.generation());
+  EXPECT_EQ(0, facets.category_count(1));
+  EXPECT_TRUE(facets.categories().empty());
+  EXPECT_TRUE(facets.ingredients(10).empty());
+}
+
+TEST(FacetsTest, CountCategories) {
+  Facets facets;
+  facets.count_category(3, 1);
+  facets.count_category(3, 1);
+  facets.count_category(4, 1);
+  EXPECT_EQ(2, facets.category_count(3));
+  EXPECT_EQ(1, facets.category_count(4));
+  EXPECT_EQ(0, facets.ingredient_count(3));
+}
+
+TEST(FacetsTest, DropZeroCounts) {
+  Facets facets;
+  facets.count_category(3, 1);
+  facets.count_category(3, -1);
+  EXPECT_TRUE(facets.categories().empty());
+}
+
+TEST(FacetsTest, SortCategoriesByFrequency) {
+  Facets facets;
+  facets.count_category(5, 1);
+  facets.count_category(3, 1);
+  facets.count_category(4, 2);
+  vector<pair<sqlite3_int64, int> > result = facets.categories();
+  ASSERT_EQ(3, result.size());
+  EXPECT_EQ(4, result[0].first);
+  EXPECT_EQ(2, result[0].second);
+  EXPECT_EQ(3, result[1].first);
+  EXPECT_EQ(5, result[2].first);
+}
+
+TEST(FacetsTest, MostFrequentIngredients) {
+  Facets facets;
+  for (int i=1; i<=10; i++)
+    facets.count_ingredient(i, i);
+  vector<pair<sqlite3_int64, int> > result = facets.ingredients(3);
+  ASSERT_EQ(3, result.size());
+  EXPECT_EQ(10, result[0].first);
+  EXPECT_EQ(9, result[1].first);
+  EXPECT_EQ(8, result[2].first);
+  EXPECT_EQ(10, facets.ingredients(20).size());
+}
+
+TEST(FacetsTest, UpdateIdsAndGeneration) {
+  Facets facets;
+  Bitmap ids;
+  ids.add(7);
+  facets.count_category(3, 1);
+  facets.update(ids, 5);
+  EXPECT_TRUE(facets.ids().contains(7));
+  EXPECT_EQ(5, facets.generation());
+  facets.clear();
+  EXPECT_TRUE(facets.ids().empty());
+  EXPECT_EQ(-1, facets.generation());
+  EXPECT_EQ(0, facets.category_count(3));
+}
@@ -0,0 +1,76 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <gtest/gtest.h>
+#include "filter.hh"
+
+
+using namespace testing;
+using namespace std;
+
+TEST(FilterTest, Empty) {
+  Filter filter;
+  EXPECT_TRUE(filter.empty());
+  EXPECT_EQ("SELECT id FROM selection;", filter.sql());
+}
+
+TEST(FilterTest, AddTerms) {
+  Filter filter;
+  filter.add(Filter::TITLE, "pie").add(Filter::CATEGORY, "Snack", true);
+  ASSERT_EQ(2, filter.terms().size());
+  EXPECT_EQ(Filter::TITLE, filter.terms()[0].field);
+  EXPECT_EQ("pie", filter.terms()[0].text);
+  EXPECT_FALSE(filter.terms()[0].negated);
+  EXPECT_TRUE(filter.terms()[1].negated);
+}
+
+TEST(FilterTest, CompileTerms) {
+  Filter filter;
+  filter.add(Filter::TITLE, "pie").add(Filter::INGREDIENT, "nuts", true);
+  string sql = filter.sql();
+  EXPECT_EQ(0, sql.find("WITH term1(id) AS (SELECT rowid FROM titletext WHERE title LIKE '%' || ?1 || '%' AND "
+                        "instr(lower(title), lower(?1)) > 0), term2(id) AS ("));
+  EXPECT_NE(string::npos, sql.find("LIKE '%' || ?2 || '%'"));
+  EXPECT_NE(string::npos, sql.find("SELECT id FROM selection WHERE id IN term1 AND id NOT IN term2;"));
+}
+
+TEST(FilterTest, KeyOfEmptyFilter) {
+  EXPECT_EQ(";", Filter().key());
+}
+
+TEST(FilterTest, KeyOfTerms) {
+  Filter filter;
+  filter.add(Filter::TITLE, "pie").add(Filter::CATEGORY, "Snack", true);
+  EXPECT_EQ("C-5:snackT+3:pie;", filter.key());
+}
+
+TEST(FilterTest, KeyIgnoresOrderCaseAndDuplicates) {
+  Filter a;
+  a.add(Filter::INGREDIENT, "Chocolate").add(Filter::CATEGORY, "desserts").add(Filter::CATEGORY, "Desserts");
+  Filter b;
+  b.add(Filter::CATEGORY, "DESSERTS").add(Filter::INGREDIENT, "chocolate");
+  EXPECT_EQ(a.key(), b.key());
+}
+
+TEST(FilterTest, KeyDistinguishesFieldsAndNegation) {
+  Filter a;
+  a.add(Filter::TITLE, "pie");
+  Filter b;
+  b.add(Filter::TEXT, "pie");
+  Filter c;
+  c.add(Filter::TITLE, "pie", true);
+  EXPECT_NE(a.key(), b.key());
+  EXPECT_NE(a.key(), c.key());
+}
@@ -0,0 +1,81 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <gtest/gtest.h>
+#include "filter_cache.hh"
+
+
+using namespace std;
+
+static Bitmap bitmap(sqlite3_int64 id) {
+  Bitmap result;
+  result.add(id);
+  return result;
+}
+
+TEST(FilterCacheTest, EmptyByDefault) {
+  FilterCache cache(4);
+  EXPECT_EQ(0, cache.size());
+  EXPECT_EQ(4, cache.capacity());
+  Bitmap selection;
+  EXPECT_FALSE(cache.find("*", 0, selection));
+}
+
+TEST(FilterCacheTest, FindInsertedSelection) {
+  FilterCache cache(4);
+  cache.insert("*", 0, bitmap(5));
+  Bitmap selection;
+  ASSERT_TRUE(cache.find("*", 0, selection));
+  EXPECT_TRUE(selection.contains(5));
+  EXPECT_EQ(1, selection.size());
+}
+
+TEST(FilterCacheTest, ReplaceSelection) {
+  FilterCache cache(4);
+  cache.insert("*", 0, bitmap(5));
+  cache.insert("*", 0, bitmap(7));
+  Bitmap selection;
+  ASSERT_TRUE(cache.find("*", 0, selection));
+  EXPECT_TRUE(selection.contains(7));
+  EXPECT_EQ(1, cache.size());
+}
+
+TEST(FilterCacheTest, EvictLeastRecentlyUsed) {
+  FilterCache cache(2);
+  cache.insert("a", 0, bitmap(1));
+  cache.insert("b", 0, bitmap(2));
+  Bitmap selection;
+  EXPECT_TRUE(cache.find("a", 0, selection));
+  cache.insert("c", 0, bitmap(3));
+  EXPECT_EQ(2, cache.size());
+  EXPECT_TRUE(cache.find("a", 0, selection));
+  EXPECT_FALSE(cache.find("b", 0, selection));
+  EXPECT_TRUE(cache.find("c", 0, selection));
+}
+
+TEST(FilterCacheTest, DropEntriesOfOldGeneration) {
+  FilterCache cache(4);
+  cache.insert("a", 0, bitmap(1));
+  Bitmap selection;
+  EXPECT_FALSE(cache.find("a", 1, selection));
+  EXPECT_EQ(0, cache.size());
+}
+
+TEST(FilterCacheTest, ZeroCapacity) {
+  FilterCache cache(0);
+  cache.insert("a", 0, bitmap(1));
+  Bitmap selection;
+  EXPECT_FALSE(cache.find("a", 0, selection));
+}
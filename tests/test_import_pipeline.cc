@@ -0,0 +1,224 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <sstream>
+#include <gtest/gtest.h>
+#include "import_pipeline.hh"
+
+
+using namespace std;
+
+static string mealmaster(const string &title) {
+  return "MMMMM----------------Meal-Master recipe exported by AnyMeal-----------------\r\n"
+         "      Title: " + title + "\r\n"
+         " Categories: pastries\r\n"
+         "   Servings: 1 pie\r\n"
+         "\r\n"
+         "MMMMM\r\n";
+}
+
+static string erroneous(void) {
+  return "MMMMM----------------Meal-Master recipe exported by AnyMeal-----------------\r\n"
+         "MMMMM\r\n";
+}
+
+static string titles(Database &database) {
+  database.select_all();
+  ostringstream s;
+  for (int i=1; i<=database.num_recipes(); i++)
+    s << database.fetch_recipe(i).title() << " ";
+  return s.str();
+}
+
+static void count_progress(int imported, int failed, void *data) {
+  ((vector<int> *)data)->push_back(imported + failed);
+}
+
+static void record_position(int imported, int failed, void *data) {
+  pair<ImportPipeline *, vector<size_t> > *positions = (pair<ImportPipeline *, vector<size_t> > *)data;
+  positions->second.push_back(positions->first->position());
+}
+
+static bool cancel_after_two(void *data) {
+  return ++*(int *)data >= 2;
+}
+
+static void collect_rejected(const string &text, const string &error, void *data) {
+  ((vector<string> *)data)->push_back(text);
+}
+
+TEST(ImportPipelineTest, DefaultWorkers) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8");
+  EXPECT_GE(pipeline.workers(), 1);
+}
+
+TEST(ImportPipelineTest, ImportRecipe) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 2);
+  istringstream s(mealmaster("apple pie"));
+  EXPECT_TRUE(pipeline.import(s));
+  EXPECT_EQ(1, pipeline.imported());
+  EXPECT_EQ(0, pipeline.failed());
+  EXPECT_EQ("apple pie ", titles(database));
+}
+
+TEST(ImportPipelineTest, EmptyInput) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 3);
+  istringstream s("");
+  EXPECT_TRUE(pipeline.import(s));
+  EXPECT_EQ(0, pipeline.imported());
+}
+
+TEST(ImportPipelineTest, PreserveOrder) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 3);
+  ostringstream input;
+  ostringstream expected;
+  for (int i=0; i<20; i++) {
+    input << mealmaster(to_string(i));
+    expected << i << " ";
+  };
+  istringstream s(input.str());
+  EXPECT_TRUE(pipeline.import(s));
+  EXPECT_EQ(20, pipeline.imported());
+  EXPECT_EQ(expected.str(), titles(database));
+}
+
+TEST(ImportPipelineTest, ImportSeveralFiles) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 2);
+  istringstream s1(mealmaster("apple pie") + mealmaster("bread"));
+  istringstream s2(mealmaster("cake"));
+  EXPECT_TRUE(pipeline.import(s1));
+  EXPECT_TRUE(pipeline.import(s2));
+  EXPECT_EQ(3, pipeline.imported());
+  EXPECT_EQ("apple pie bread cake ", titles(database));
+}
+
+TEST(ImportPipelineTest, RejectRecipe) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 2);
+  vector<string> rejected;
+  pipeline.set_rejected(&collect_rejected, &rejected);
+  istringstream s(mealmaster("apple pie") + erroneous() + mealmaster("cake"));
+  EXPECT_TRUE(pipeline.import(s));
+  EXPECT_EQ(2, pipeline.imported());
+  EXPECT_EQ(1, pipeline.failed());
+  ASSERT_EQ(1, rejected.size());
+  EXPECT_EQ(erroneous(), rejected[0]);
+  EXPECT_EQ("apple pie cake ", titles(database));
+}
+
+TEST(ImportPipelineTest, ReportProgress) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 2);
+  vector<int> progress;
+  pipeline.set_progress(&count_progress, &progress);
+  istringstream s(mealmaster("apple pie") + erroneous() + mealmaster("cake"));
+  pipeline.import(s);
+  ASSERT_EQ(3, progress.size());
+  EXPECT_EQ(1, progress[0]);
+  EXPECT_EQ(3, progress[2]);
+}
+
+TEST(ImportPipelineTest, ReportPosition) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 2);
+  pair<ImportPipeline *, vector<size_t> > positions(&pipeline, vector<size_t>());
+  pipeline.set_progress(&record_position, &positions);
+  string text = mealmaster("apple pie") + erroneous() + mealmaster("cake");
+  EXPECT_TRUE(pipeline.import(string_view(text)));
+  ASSERT_EQ(3, positions.second.size());
+  EXPECT_EQ(mealmaster("apple pie").size(), positions.second[0]);
+  EXPECT_EQ(text.size(), positions.second[2]);
+  istringstream s(text);
+  EXPECT_TRUE(pipeline.import(s));
+  ASSERT_EQ(6, positions.second.size());
+  EXPECT_EQ(mealmaster("apple pie").size(), positions.second[3]);
+  EXPECT_EQ(text.size(), positions.second[5]);
+}
+
+TEST(ImportPipelineTest, CancelImport) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 2);
+  int calls = 0;
+  pipeline.set_cancel(&cancel_after_two, &calls);
+  istringstream s(mealmaster("apple pie") + mealmaster("bread") + mealmaster("cake"));
+  EXPECT_FALSE(pipeline.import(s));
+  EXPECT_EQ(2, calls);
+  EXPECT_EQ(0, database.num_recipes());
+}
+
+TEST(ImportPipelineTest, KeepPreviousFilesWhenCancelling) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 2);
+  istringstream s1(mealmaster("apple pie"));
+  istringstream s2(mealmaster("bread") + mealmaster("cake") + mealmaster("pudding"));
+  EXPECT_TRUE(pipeline.import(s1));
+  int calls = 0;
+  pipeline.set_cancel(&cancel_after_two, &calls);
+  EXPECT_FALSE(pipeline.import(s2));
+  EXPECT_EQ(1, pipeline.imported());
+  EXPECT_EQ("apple pie ", titles(database));
+}
+
+TEST(ImportPipelineTest, RecodeRecipes) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "ISO-8859-1", 2);
+  istringstream s(mealmaster("cr\xe8me br\xfbl\xe9\x65"));
+  EXPECT_TRUE(pipeline.import(s));
+  EXPECT_EQ("cr\xc3\xa8me br\xc3\xbbl\xc3\xa9\x65 ", titles(database));
+}
+
+TEST(ImportPipelineTest, ImportText) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 3);
+  string text;
+  ostringstream expected;
+  for (int i=0; i<20; i++) {
+    text += mealmaster(to_string(i));
+    expected << i << " ";
+  };
+  EXPECT_TRUE(pipeline.import(string_view(text)));
+  EXPECT_EQ(20, pipeline.imported());
+  EXPECT_EQ(expected.str(), titles(database));
+}
+
+TEST(ImportPipelineTest, RejectRecipeFromText) {
+  Database database;
+  database.open(":memory:");
+  ImportPipeline pipeline(database, "UTF-8", 2);
+  vector<string> rejected;
+  pipeline.set_rejected(&collect_rejected, &rejected);
+  string text = mealmaster("apple pie") + erroneous() + mealmaster("cake");
+  EXPECT_TRUE(pipeline.import(string_view(text)));
+  EXPECT_EQ(2, pipeline.imported());
+  ASSERT_EQ(1, rejected.size());
+  EXPECT_EQ(erroneous(), rejected[0]);
+}
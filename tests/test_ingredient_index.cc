@@ -0,0 +1,117 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <gtest/gtest.h>
+#include "ingredient_index.hh"
+
+
+using namespace testing;
+using namespace std;
+
+static IngredientIndex::Postings postings(sqlite3_int64 start, sqlite3_int64 stop, sqlite3_int64 step) {
+  IngredientIndex::Postings result;
+  for (sqlite3_int64 i=start; i<stop; i+=step)
+    result.push_back(i);
+  return result;
+}
+
+static vector<vector<sqlite3_int64> > terms(sqlite3_int64 a) {
+  return vector<vector<sqlite3_int64> >(1, vector<sqlite3_int64>(1, a));
+}
+
+static Bitmap bitmap(sqlite3_int64 start, sqlite3_int64 stop) {
+  Bitmap result;
+  for (sqlite3_int64 i=start; i<stop; i++)
+    result.add(i);
+  return result;
+}
+
+TEST(IngredientIndexTest, Intersect) {
+  EXPECT_EQ(postings(0, 1000, 6), intersect_postings(postings(0, 1000, 2), postings(0, 1000, 3)));
+  EXPECT_EQ(postings(500, 501, 1), intersect_postings(postings(500, 501, 1), postings(0, 100000, 1)));
+  EXPECT_EQ(postings(0, 100000, 1000), intersect_postings(postings(0, 100000, 1), postings(0, 100000, 1000)));
+  EXPECT_TRUE(intersect_postings(postings(0, 10, 1), postings(10, 100, 1)).empty());
+  EXPECT_TRUE(intersect_postings(postings(0, 10, 1), IngredientIndex::Postings()).empty());
+}
+
+TEST(IngredientIndexTest, Unite) {
+  EXPECT_EQ(postings(0, 100, 1), unite_postings(postings(0, 100, 2), postings(1, 100, 2)));
+  EXPECT_EQ(postings(0, 10, 1), unite_postings(postings(0, 10, 1), postings(5, 10, 1)));
+}
+
+TEST(IngredientIndexTest, AddOutOfOrder) {
+  IngredientIndex index;
+  index.add(1, 5);
+  index.add(1, 3);
+  index.add(1, 5);
+  index.add(1, 7);
+  IngredientIndex::Postings expected;
+  expected.push_back(3);
+  expected.push_back(5);
+  expected.push_back(7);
+  EXPECT_EQ(expected, index.recipes(vector<sqlite3_int64>(1, 1)));
+}
+
+TEST(IngredientIndexTest, Remove) {
+  IngredientIndex index;
+  index.add(1, 3);
+  index.add(1, 5);
+  index.remove(1, 3);
+  index.remove(2, 3);
+  EXPECT_EQ(IngredientIndex::Postings(1, 5), index.recipes(vector<sqlite3_int64>(1, 1)));
+}
+
+TEST(IngredientIndexTest, RecipesOfSeveralIngredients) {
+  IngredientIndex index;
+  index.add(1, 3);
+  index.add(2, 3);
+  index.add(2, 1);
+  vector<sqlite3_int64> ingredients;
+  ingredients.push_back(1);
+  ingredients.push_back(2);
+  ingredients.push_back(4);
+  IngredientIndex::Postings expected;
+  expected.push_back(1);
+  expected.push_back(3);
+  EXPECT_EQ(expected, index.recipes(ingredients));
+}
+
+TEST(IngredientIndexTest, Query) {
+  IngredientIndex index;
+  for (sqlite3_int64 recipe=1; recipe<=12; recipe++) {
+    if (recipe % 2 == 0)
+      index.add(1, recipe);
+    if (recipe % 3 == 0)
+      index.add(2, recipe);
+    if (recipe % 4 == 0)
+      index.add(3, recipe);
+  };
+  vector<vector<sqlite3_int64> > none;
+  Bitmap all_of = index.query(bitmap(1, 13), terms(1), terms(2), none);
+  EXPECT_EQ(2, all_of.size());
+  EXPECT_TRUE(all_of.contains(6));
+  EXPECT_TRUE(all_of.contains(12));
+  vector<vector<sqlite3_int64> > any = terms(2);
+  any.push_back(vector<sqlite3_int64>(1, 3));
+  Bitmap any_of = index.query(bitmap(1, 13), vector<vector<sqlite3_int64> >(), any, terms(1));
+  EXPECT_EQ(2, any_of.size());
+  EXPECT_TRUE(any_of.contains(3));
+  EXPECT_TRUE(any_of.contains(9));
+  Bitmap none_of = index.query(bitmap(1, 13), vector<vector<sqlite3_int64> >(), vector<vector<sqlite3_int64> >(), terms(1));
+  EXPECT_EQ(6, none_of.size());
+  EXPECT_FALSE(none_of.contains(2));
+  Bitmap restricted = index.query(bitmap(1, 7), terms(1), vector<vector<sqlite3_int64> >(), none);
+  EXPECT_EQ(3, restricted.size());
+}
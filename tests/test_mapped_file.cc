@@ -0,0 +1,48 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <fstream>
+#include <gtest/gtest.h>
+#include "mapped_file.hh"
+
+
+using namespace std;
+
+TEST(MappedFileTest, MapFile) {
+  const char *filename = "/tmp/anymeal-test-mapped.txt";
+  {
+    ofstream f(filename, ofstream::binary);
+    f << "MMMMM\r\n";
+  }
+  MappedFile file(filename);
+  EXPECT_EQ(7, file.size());
+  EXPECT_EQ("MMMMM\r\n", file.text());
+  remove(filename);
+}
+
+TEST(MappedFileTest, EmptyFile) {
+  const char *filename = "/tmp/anymeal-test-mapped.txt";
+  {
+    ofstream f(filename, ofstream::binary);
+  }
+  MappedFile file(filename);
+  EXPECT_EQ(0, file.size());
+  EXPECT_EQ("", file.text());
+  remove(filename);
+}
+
+TEST(MappedFileTest, MissingFile) {
+  EXPECT_THROW(MappedFile("/tmp/nosuchdir/anymeal.mmf"), mapped_file_exception);
+}
@@ -15,6 +15,7 @@
    along with this program.  If not, see <https://www.gnu.org/licenses/>. */
 #include <fstream>
 #include <sstream>
+#include <thread>
 #include <gtest/gtest.h>
 #include "mealmaster.hh"
 
@@ -510,6 +511,17 @@ TEST(MealMasterTest, EmptyIngredientSection) {
   EXPECT_THROW(parse_mealmaster(f), parse_exception);
 }
 
+TEST(MealMasterTest, EmptyIngredientSectionMessage) {
+  ifstream f("fixtures/empty_ingredient_section.mmf");
+  string message;
+  try {
+    parse_mealmaster(f);
+  } catch (parse_exception &e) {
+    message = e.what();
+  };
+  EXPECT_EQ(0, message.rfind("Empty ingredient section in line ", 0)) << message;
+}
+
 TEST(MealMasterTest, SectionWithTrailingWhitespace) {
   ifstream f("fixtures/section_whitespace.mmf");
   Recipe result = parse_mealmaster(f);
@@ -541,3 +553,72 @@ TEST(MealMasterTest, OnlyDiscardTwoSpaces) {
   EXPECT_EQ("Only discard", result.instructions()[0]);
   EXPECT_EQ("         two leading spaces.", result.instructions()[1]);
 }
+
+TEST(MealMasterTest, ReuseParser) {
+  MealMasterParser parser;
+  ifstream f1("fixtures/header.mmf");
+  EXPECT_EQ("apple pie", parser.parse(f1).title());
+  ifstream f2("fixtures/header2.mmf");
+  Recipe result = parser.parse(f2);
+  EXPECT_EQ(42, result.servings());
+  EXPECT_EQ(2, result.categories().size());
+}
+
+TEST(MealMasterTest, ReuseParserAfterError) {
+  MealMasterParser parser;
+  istringstream s("MMMMM----- Recipe via Meal-Master\nTitle: apple pie\nCategories: cakes\n?");
+  EXPECT_THROW(parser.parse(s), parse_exception);
+  ifstream f("fixtures/header.mmf");
+  EXPECT_EQ("apple pie", parser.parse(f).title());
+}
+
+static void parse_titles(vector<string> *titles) {
+  MealMasterParser parser;
+  for (int i=0; i<100; i++) {
+    ifstream f(i % 2 ? "fixtures/header.mmf" : "fixtures/header2.mmf");
+    titles->push_back(parser.parse(f).title());
+  };
+}
+
+TEST(MealMasterTest, ParseInParallel) {
+  vector<vector<string> > titles(4);
+  vector<thread> threads;
+  for (int i=0; i<4; i++)
+    threads.push_back(thread(parse_titles, &titles[i]));
+  for (int i=0; i<4; i++)
+    threads[i].join();
+  for (int i=0; i<4; i++)
+    EXPECT_EQ(titles[0], titles[i]);
+  ASSERT_EQ(100, titles[0].size());
+  EXPECT_EQ("apple pie", titles[0][1]);
+}
+
+TEST(MealMasterTest, ParseText) {
+  MealMasterParser parser;
+  Recipe result = parser.parse(string_view("MMMMM----- Recipe via Meal-Master\r\n      Title: apple pie\r\n"
+                                           " Categories: cakes\r\n   Servings: 2\r\n\r\nMMMMM\r\n"));
+  EXPECT_EQ("apple pie", result.title());
+  EXPECT_EQ(2, result.servings());
+}
+
+TEST(MealMasterTest, ParseTextWithoutFinalLineBreak) {
+  MealMasterParser parser;
+  Recipe result = parser.parse(string_view("MMMMM----- Recipe via Meal-Master\n      Title: apple pie\n"
+                                           " Categories: cakes\n   Servings: 2\n\nMMMMM"));
+  EXPECT_EQ("apple pie", result.title());
+}
+
+TEST(MealMasterTest, ParseEmptyText) {
+  MealMasterParser parser;
+  EXPECT_THROW(parser.parse(string_view()), parse_exception);
+}
+
+TEST(MealMasterTest, AlternateTextAndStream) {
+  MealMasterParser parser;
+  ifstream f1("fixtures/header.mmf");
+  string text((istreambuf_iterator<char>(f1)), istreambuf_iterator<char>());
+  EXPECT_EQ("apple pie", parser.parse(string_view(text)).title());
+  ifstream f2("fixtures/header2.mmf");
+  EXPECT_EQ(42, parser.parse(f2).servings());
+  EXPECT_EQ("apple pie", parser.parse(string_view(text)).title());
+}
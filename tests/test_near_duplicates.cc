@@ -0,0 +1,136 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <chrono>
+#include <iostream>
+#include <gtest/gtest.h>
+#include "near_duplicates.hh"
+
+
+using namespace std;
+
+static RecipeFeatures recipe(sqlite3_int64 id, const char *title, int first, int count) {
+  RecipeFeatures result;
+  result.id = id;
+  result.features = title_features(title);
+  for (int i=first; i<first + count; i++)
+    result.features.push_back(ingredient_feature(i));
+  sort(result.features.begin(), result.features.end());
+  result.features.erase(unique(result.features.begin(), result.features.end()), result.features.end());
+  return result;
+}
+
+TEST(NearDuplicatesTest, TitleFeaturesIgnoreCaseAndPunctuation) {
+  EXPECT_EQ(title_features("apple pie"), title_features("Apple  Pie!"));
+  EXPECT_EQ(2, title_features("Apple pie").size());
+  EXPECT_TRUE(title_features(" - ").empty());
+  EXPECT_NE(title_features("apple"), title_features("pie"));
+}
+
+TEST(NearDuplicatesTest, IngredientAndTitleFeaturesDiffer) {
+  vector<uint64_t> title = title_features("1");
+  EXPECT_NE(ingredient_feature(1), title[0]);
+  EXPECT_NE(ingredient_feature(1), ingredient_feature(2));
+}
+
+TEST(NearDuplicatesTest, Jaccard) {
+  EXPECT_DOUBLE_EQ(1.0, jaccard({1, 2, 3}, {1, 2, 3}));
+  EXPECT_DOUBLE_EQ(0.5, jaccard({1, 2, 3}, {2, 3, 4}));
+  EXPECT_DOUBLE_EQ(0.0, jaccard({1, 2}, {3, 4}));
+  EXPECT_DOUBLE_EQ(0.0, jaccard({}, {}));
+}
+
+TEST(NearDuplicatesTest, SignatureSize) {
+  NearDuplicates near_duplicates(4, 3);
+  EXPECT_EQ(12, near_duplicates.signature({1, 2, 3}).size());
+}
+
+TEST(NearDuplicatesTest, SignatureOfSameFeatures) {
+  NearDuplicates near_duplicates(4, 3);
+  EXPECT_EQ(near_duplicates.signature({5, 7, 9}), near_duplicates.signature({5, 7, 9}));
+  EXPECT_NE(near_duplicates.signature({5, 7, 9}), near_duplicates.signature({6, 8, 10}));
+}
+
+TEST(NearDuplicatesTest, SignatureEstimatesSimilarity) {
+  NearDuplicates near_duplicates(32, 8);
+  vector<uint64_t> a;
+  vector<uint64_t> b;
+  for (int i=0; i<100; i++) {
+    a.push_back(i);
+    b.push_back(i + 50);
+  };
+  vector<uint32_t> sa = near_duplicates.signature(a);
+  vector<uint32_t> sb = near_duplicates.signature(b);
+  int same = 0;
+  for (size_t i=0; i<sa.size(); i++)
+    if (sa[i] == sb[i])
+      same++;
+  EXPECT_NEAR(jaccard(a, b), (double)same / sa.size(), 0.1);
+}
+
+TEST(NearDuplicatesTest, ClusterSimilarRecipes) {
+  NearDuplicates near_duplicates(16, 4, 2);
+  vector<RecipeFeatures> recipes;
+  recipes.push_back(recipe(1, "Apple pie", 0, 12));
+  recipes.push_back(recipe(2, "Lemon cake", 100, 10));
+  recipes.push_back(recipe(3, "Apple Pie", 0, 13));
+  recipes.push_back(recipe(4, "Apple pie", 1, 12));
+  recipes.push_back(recipe(5, "Pea soup", 200, 8));
+  vector<vector<sqlite3_int64> > clusters = near_duplicates.clusters(recipes, 0.8);
+  ASSERT_EQ(1, clusters.size());
+  EXPECT_EQ(vector<sqlite3_int64>({1, 3, 4}), clusters[0]);
+}
+
+TEST(NearDuplicatesTest, RespectThreshold) {
+  NearDuplicates near_duplicates(16, 4);
+  vector<RecipeFeatures> recipes;
+  recipes.push_back(recipe(1, "Stew", 0, 10));
+  recipes.push_back(recipe(2, "Stew", 5, 10));
+  EXPECT_TRUE(near_duplicates.clusters(recipes, 0.9).empty());
+}
+
+TEST(NearDuplicatesTest, IgnoreRecipesWithoutFeatures) {
+  NearDuplicates near_duplicates(16, 4);
+  vector<RecipeFeatures> recipes;
+  recipes.push_back(recipe(1, "", 0, 0));
+  recipes.push_back(recipe(2, "", 0, 0));
+  EXPECT_TRUE(near_duplicates.clusters(recipes, 0.5).empty());
+}
+
+TEST(NearDuplicatesTest, LargeBucketOfDuplicates) {
+  NearDuplicates near_duplicates(16, 4);
+  vector<RecipeFeatures> recipes;
+  for (int i=0; i<1000; i++)
+    recipes.push_back(recipe(i + 1, "Bread", 0, 5));
+  vector<vector<sqlite3_int64> > clusters = near_duplicates.clusters(recipes, 0.9);
+  ASSERT_EQ(1, clusters.size());
+  EXPECT_EQ(1000, clusters[0].size());
+}
+
+TEST(NearDuplicatesTest, DISABLED_BenchmarkClusters) {
+  const int n = 250000;
+  vector<RecipeFeatures> recipes;
+  for (int i=0; i<n; i++) {
+    // Every tenth recipe is a copy of the previous one with an extra ingredient.
+    int base = i % 10 == 9 ? i - 1 : i;
+    recipes.push_back(recipe(i + 1, "Recipe", base * 7, 12 + (i != base)));
+  };
+  NearDuplicates near_duplicates(16, 4);
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  vector<vector<sqlite3_int64> > clusters = near_duplicates.clusters(recipes, 0.7);
+  double time = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+  cout << "Clustering " << n << " recipes: " << time << " s, " << clusters.size() << " clusters" << endl;
+  EXPECT_EQ(n / 10, clusters.size());
+}
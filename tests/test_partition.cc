@@ -69,3 +69,99 @@ TEST(PartitionTest, RecipeWithSection) {
   istringstream s("MMMMM---MEAL-MASTER Format-----\r\nMMMMM----section-----\r\nMMMMM\r\n");
   EXPECT_EQ("MMMMM---MEAL-MASTER Format-----\r\nMMMMM----section-----\r\nMMMMM\r\n", recipes(s)[0]);
 }
+
+TEST(PartitionTest, NextRecipe) {
+  istringstream s("MMMMM---MEAL-MASTER Format---\r\nMMMMM\r\nMMMMM---Recipe via Meal-Master\r\nMMMMM");
+  Partitioner partitioner(s);
+  string recipe;
+  ASSERT_TRUE(partitioner.next(recipe));
+  EXPECT_EQ("MMMMM---MEAL-MASTER Format---\r\nMMMMM\r\n", recipe);
+  ASSERT_TRUE(partitioner.next(recipe));
+  EXPECT_EQ("MMMMM---Recipe via Meal-Master\r\nMMMMM\r\n", recipe);
+  EXPECT_FALSE(partitioner.next(recipe));
+  EXPECT_EQ("", recipe);
+}
+
+TEST(PartitionTest, NoRecipeInStream) {
+  istringstream s("text\r\n");
+  Partitioner partitioner(s);
+  string recipe;
+  EXPECT_FALSE(partitioner.next(recipe));
+}
+
+TEST(PartitionTest, DropIncompleteRecipe) {
+  istringstream s("MMMMM---MEAL-MASTER Format---\r\nMMMMM\r\nMMMMM---Recipe via Meal-Master\r\n");
+  Partitioner partitioner(s);
+  string recipe;
+  EXPECT_TRUE(partitioner.next(recipe));
+  EXPECT_FALSE(partitioner.next(recipe));
+}
+
+TEST(PartitionTest, SmallReadAhead) {
+  istringstream s("MMMMM---MEAL-MASTER Format---\r\ningredient\r\nMMMMM\r\n--------Recipe via Meal-Master\r\n-----");
+  Partitioner partitioner(s, 3);
+  string recipe;
+  ASSERT_TRUE(partitioner.next(recipe));
+  EXPECT_EQ("MMMMM---MEAL-MASTER Format---\r\ningredient\r\nMMMMM\r\n", recipe);
+  ASSERT_TRUE(partitioner.next(recipe));
+  EXPECT_EQ("--------Recipe via Meal-Master\r\n-----\r\n", recipe);
+  EXPECT_FALSE(partitioner.next(recipe));
+}
+
+TEST(PartitionTest, SameResultForAnyReadAhead) {
+  ostringstream input;
+  for (int i=0; i<50; i++)
+    input << "stray text\nMMMMM---MEAL-MASTER Format---\r\nrecipe " << i << "\r\n\r\nMMMMM\r\n";
+  istringstream s(input.str());
+  vector<string> expected = recipes(s);
+  ASSERT_EQ(50, expected.size());
+  for (int read_ahead=1; read_ahead<100; read_ahead+=7) {
+    istringstream s(input.str());
+    Partitioner partitioner(s, read_ahead);
+    vector<string> result;
+    string recipe;
+    while (partitioner.next(recipe))
+      result.push_back(recipe);
+    EXPECT_EQ(expected, result);
+  };
+}
+
+static vector<string> ranges(const string &text) {
+  MemoryPartitioner partitioner(text);
+  vector<string> result;
+  string_view recipe;
+  while (partitioner.next(recipe))
+    result.push_back(string(recipe));
+  return result;
+}
+
+TEST(PartitionTest, RecipeRange) {
+  string text = "text\r\nMMMMM---MEAL-MASTER Format---\r\nMMMMM\r\ntext";
+  MemoryPartitioner partitioner(text);
+  string_view recipe;
+  ASSERT_TRUE(partitioner.next(recipe));
+  EXPECT_EQ(text.data() + 6, recipe.data());
+  EXPECT_EQ("MMMMM---MEAL-MASTER Format---\r\nMMMMM\r\n", recipe);
+  EXPECT_FALSE(partitioner.next(recipe));
+}
+
+TEST(PartitionTest, RangesKeepLineBreaks) {
+  vector<string> result = ranges("MMMMM---MEAL-MASTER Format---\nMMMMM\n--------Recipe via Meal-Master\r\n-----");
+  ASSERT_EQ(2, result.size());
+  EXPECT_EQ("MMMMM---MEAL-MASTER Format---\nMMMMM\n", result[0]);
+  EXPECT_EQ("--------Recipe via Meal-Master\r\n-----", result[1]);
+}
+
+TEST(PartitionTest, RangesOfEmptyText) {
+  EXPECT_TRUE(ranges("").empty());
+  EXPECT_TRUE(ranges("text\n").empty());
+}
+
+TEST(PartitionTest, RangesLikeRecipes) {
+  string text = "stray\r\nMMMMM---MEAL-MASTER Format---\r\nMMMMM----section-----\r\nMMMMM\r\nMMMMM\r\n"
+                "MMMMM---Recipe via Meal-Master\nincomplete\n";
+  istringstream s(text);
+  vector<string> expected = recipes(s);
+  vector<string> result = ranges(text);
+  EXPECT_EQ(expected, result);
+}
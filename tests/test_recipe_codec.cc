@@ -0,0 +1,108 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <gtest/gtest.h>
+#include "recipe_codec.hh"
+
+
+using namespace testing;
+using namespace std;
+
+static Recipe sample_recipe(void) {
+  Recipe recipe;
+  recipe.set_title("Apple pie");
+  recipe.set_servings(4);
+  recipe.set_servings_unit("pieces");
+  recipe.add_category("Dessert");
+  recipe.add_category("Baking");
+  Ingredient ingredient;
+  ingredient.set_amount_integer(1);
+  ingredient.set_amount_numerator(-3);
+  ingredient.set_amount_denominator(400);
+  ingredient.set_amount_float(1.75);
+  ingredient.set_unit("kg");
+  ingredient.add_text("green apples");
+  recipe.add_ingredient(ingredient);
+  recipe.add_ingredient(Ingredient());
+  recipe.add_ingredient_section(1, "Topping");
+  recipe.add_instruction("Peel apples.");
+  recipe.add_instruction(string(300, 'x').c_str());
+  recipe.add_instruction_section(1, "Baking");
+  return recipe;
+}
+
+TEST(RecipeCodecTest, Roundtrip) {
+  Recipe recipe = sample_recipe();
+  string data = encode_recipe(recipe);
+  Recipe result;
+  ASSERT_TRUE(decode_recipe(data.data(), data.size(), result));
+  EXPECT_EQ("Apple pie", result.title());
+  EXPECT_EQ(4, result.servings());
+  EXPECT_EQ("pieces", result.servings_unit());
+  EXPECT_EQ(recipe.categories(), result.categories());
+  ASSERT_EQ(2, result.ingredients().size());
+  EXPECT_EQ(1, result.ingredients()[0].amount_integer());
+  EXPECT_EQ(-3, result.ingredients()[0].amount_numerator());
+  EXPECT_EQ(400, result.ingredients()[0].amount_denominator());
+  EXPECT_EQ(1.75, result.ingredients()[0].amount_float());
+  EXPECT_EQ("kg", result.ingredients()[0].unit());
+  EXPECT_EQ("green apples", result.ingredients()[0].text());
+  EXPECT_EQ(recipe.ingredient_sections(), result.ingredient_sections());
+  EXPECT_EQ(recipe.instructions(), result.instructions());
+  EXPECT_EQ(recipe.instruction_sections(), result.instruction_sections());
+}
+
+TEST(RecipeCodecTest, RejectUnknownVersion) {
+  Recipe recipe = sample_recipe();
+  string data = encode_recipe(recipe);
+  data[0] = 99;
+  Recipe result;
+  EXPECT_FALSE(decode_recipe(data.data(), data.size(), result));
+  EXPECT_FALSE(decode_recipe(data.data(), 0, result));
+}
+
+TEST(RecipeCodecTest, RejectTruncatedData) {
+  Recipe recipe = sample_recipe();
+  string data = encode_recipe(recipe);
+  for (size_t size=1; size<data.size(); size++) {
+    Recipe result;
+    EXPECT_FALSE(decode_recipe(data.data(), size, result)) << size;
+  };
+  Recipe result;
+  EXPECT_FALSE(decode_recipe((data + "x").data(), data.size() + 1, result));
+}
+
+TEST(RecipeCodecTest, HashIgnoresCategories) {
+  Recipe recipe = sample_recipe();
+  uint64_t hash = hash_recipe(recipe);
+  recipe.add_category("Other");
+  EXPECT_EQ(hash, hash_recipe(recipe));
+}
+
+TEST(RecipeCodecTest, HashDependsOnContent) {
+  Recipe recipe = sample_recipe();
+  uint64_t hash = hash_recipe(recipe);
+  Recipe title = sample_recipe();
+  title.set_title("Apple pies");
+  EXPECT_NE(hash, hash_recipe(title));
+  Recipe instruction = sample_recipe();
+  instruction.add_instruction("Serve.");
+  EXPECT_NE(hash, hash_recipe(instruction));
+  Recipe amount = sample_recipe();
+  amount.ingredients()[0].set_amount_integer(2);
+  EXPECT_NE(hash, hash_recipe(amount));
+  Recipe same = sample_recipe();
+  EXPECT_EQ(hash, hash_recipe(same));
+}
@@ -0,0 +1,122 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <gtest/gtest.h>
+#include "search_history.hh"
+
+
+using namespace std;
+
+static Bitmap range(sqlite3_int64 begin, sqlite3_int64 end) {
+  Bitmap result;
+  for (sqlite3_int64 id=begin; id<end; id++)
+    result.add(id);
+  return result;
+}
+
+TEST(SearchHistoryTest, EmptyByDefault) {
+  SearchHistory history(4);
+  EXPECT_TRUE(history.empty());
+  EXPECT_EQ(0, history.size());
+  EXPECT_EQ(4, history.capacity());
+}
+
+TEST(SearchHistoryTest, PushSteps) {
+  SearchHistory history(4);
+  history.push("title: pie", range(1, 100), "*", range(1, 50));
+  history.push("category: Dessert", range(1, 50), "*a;", range(1, 10));
+  ASSERT_EQ(2, history.size());
+  EXPECT_EQ("title: pie", history.label(0));
+  EXPECT_EQ("category: Dessert", history.label(1));
+}
+
+TEST(SearchHistoryTest, UndoLastStep) {
+  SearchHistory history(4);
+  history.push("title: pie", range(1, 100), "*", range(1, 50));
+  history.push("category: Dessert", range(1, 50), "*a;", range(1, 10));
+  Bitmap selection = range(1, 10);
+  string chain = "*a;b;";
+  history.undo(selection, chain);
+  EXPECT_TRUE(range(1, 50) == selection);
+  EXPECT_EQ("*a;", chain);
+  EXPECT_EQ(1, history.size());
+}
+
+TEST(SearchHistoryTest, UndoWithoutSteps) {
+  SearchHistory history(4);
+  Bitmap selection = range(1, 10);
+  string chain = "*";
+  history.undo(selection, chain);
+  EXPECT_TRUE(range(1, 10) == selection);
+  EXPECT_EQ("*", chain);
+}
+
+TEST(SearchHistoryTest, JumpToStep) {
+  SearchHistory history(4);
+  history.push("a", range(1, 100), "*", range(1, 50));
+  history.push("b", range(1, 50), "*a;", range(1, 20));
+  history.push("c", range(1, 20), "*a;b;", range(1, 10));
+  Bitmap selection = range(1, 10);
+  string chain = "*a;b;c;";
+  history.jump(1, selection, chain);
+  EXPECT_TRUE(range(1, 50) == selection);
+  EXPECT_EQ("*a;", chain);
+  EXPECT_EQ(1, history.size());
+  history.jump(0, selection, chain);
+  EXPECT_TRUE(range(1, 100) == selection);
+  EXPECT_EQ("*", chain);
+  EXPECT_TRUE(history.empty());
+}
+
+TEST(SearchHistoryTest, KeepRecipesAddedLater) {
+  SearchHistory history(4);
+  history.push("a", range(1, 100), "*", range(1, 50));
+  Bitmap selection = range(1, 50);
+  selection.add(200);
+  string chain;
+  history.undo(selection, chain);
+  EXPECT_EQ(100, selection.size());
+  EXPECT_TRUE(selection.contains(200));
+}
+
+TEST(SearchHistoryTest, EraseDeletedRecipes) {
+  SearchHistory history(4);
+  history.push("a", range(1, 100), "*", range(1, 50));
+  history.erase(range(90, 100));
+  Bitmap selection = range(1, 50);
+  string chain;
+  history.undo(selection, chain);
+  EXPECT_TRUE(range(1, 90) == selection);
+}
+
+TEST(SearchHistoryTest, DropOldestSteps) {
+  SearchHistory history(2);
+  history.push("a", range(1, 100), "*", range(1, 50));
+  history.push("b", range(1, 50), "*a;", range(1, 20));
+  history.push("c", range(1, 20), "*a;b;", range(1, 10));
+  ASSERT_EQ(2, history.size());
+  EXPECT_EQ("b", history.label(0));
+  Bitmap selection = range(1, 10);
+  string chain;
+  history.jump(0, selection, chain);
+  EXPECT_TRUE(range(1, 50) == selection);
+  EXPECT_EQ("*a;", chain);
+}
+
+TEST(SearchHistoryTest, StoreOnlyRemovedRecipes) {
+  SearchHistory history(4);
+  history.push("a", range(1, 100000), "*", range(1, 99990));
+  EXPECT_LT(history.memory(), range(1, 100000).memory());
+}
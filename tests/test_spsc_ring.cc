@@ -0,0 +1,88 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <thread>
+#include <gtest/gtest.h>
+#include "spsc_ring.hh"
+
+
+using namespace std;
+
+TEST(SpscRingTest, RoundUpCapacity) {
+  SpscRing<int> ring(5);
+  EXPECT_EQ(8, ring.capacity());
+}
+
+TEST(SpscRingTest, EmptyByDefault) {
+  SpscRing<int> ring(4);
+  int value;
+  EXPECT_TRUE(ring.empty());
+  EXPECT_FALSE(ring.pop(value));
+}
+
+TEST(SpscRingTest, FirstInFirstOut) {
+  SpscRing<int> ring(4);
+  int a = 2, b = 3, value;
+  EXPECT_TRUE(ring.push(a));
+  EXPECT_TRUE(ring.push(b));
+  EXPECT_FALSE(ring.empty());
+  ASSERT_TRUE(ring.pop(value));
+  EXPECT_EQ(2, value);
+  ASSERT_TRUE(ring.pop(value));
+  EXPECT_EQ(3, value);
+  EXPECT_TRUE(ring.empty());
+}
+
+TEST(SpscRingTest, RejectWhenFull) {
+  SpscRing<int> ring(2);
+  int value = 5;
+  EXPECT_TRUE(ring.push(value));
+  EXPECT_TRUE(ring.push(value));
+  EXPECT_FALSE(ring.push(value));
+  ring.pop(value);
+  EXPECT_TRUE(ring.push(value));
+}
+
+TEST(SpscRingTest, MoveStrings) {
+  SpscRing<string> ring(2);
+  string text = "apple pie";
+  string result;
+  ring.push(text);
+  ring.pop(result);
+  EXPECT_EQ("apple pie", result);
+}
+
+static void produce(SpscRing<int> *ring) {
+  for (int i=0; i<100000; i++) {
+    int value = i;
+    while (!ring->push(value))
+      this_thread::yield();
+  };
+}
+
+TEST(SpscRingTest, PassValuesBetweenThreads) {
+  SpscRing<int> ring(16);
+  thread producer(produce, &ring);
+  bool ordered = true;
+  for (int i=0; i<100000; i++) {
+    int value;
+    while (!ring.pop(value))
+      this_thread::yield();
+    if (value != i)
+      ordered = false;
+  };
+  producer.join();
+  EXPECT_TRUE(ordered);
+}
@@ -0,0 +1,75 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <gtest/gtest.h>
+#include "title_arena.hh"
+
+
+TEST(TitleArenaTest, EmptyByDefault) {
+  TitleArena arena;
+  EXPECT_TRUE(arena.empty());
+  EXPECT_EQ(0, arena.size());
+}
+
+TEST(TitleArenaTest, AppendTitles) {
+  TitleArena arena;
+  arena.push_back(5, "Apple pie");
+  arena.push_back(3, "Bread");
+  EXPECT_FALSE(arena.empty());
+  ASSERT_EQ(2, arena.size());
+  EXPECT_EQ(5, arena.id(0));
+  EXPECT_EQ(3, arena.id(1));
+  EXPECT_STREQ("Apple pie", arena.title(0));
+  EXPECT_STREQ("Bread", arena.title(1));
+  EXPECT_EQ(9, arena.length(0));
+  EXPECT_EQ(5, arena.length(1));
+}
+
+TEST(TitleArenaTest, StoreTitlesContiguously) {
+  TitleArena arena;
+  arena.push_back(1, "ab");
+  arena.push_back(2, "cd");
+  EXPECT_EQ(std::string("ab\0cd\0", 6), arena.text());
+  EXPECT_EQ(arena.title(0) + 3, arena.title(1));
+}
+
+TEST(TitleArenaTest, AppendWithLength) {
+  TitleArena arena;
+  arena.push_back(1, "Soup of the day", 4);
+  EXPECT_STREQ("Soup", arena.title(0));
+  EXPECT_EQ(4, arena.length(0));
+}
+
+TEST(TitleArenaTest, ReplaceTitle) {
+  TitleArena arena;
+  arena.push_back(1, "Cake");
+  arena.push_back(2, "Soup");
+  arena.set(0, 7, "Lemon cake");
+  EXPECT_EQ(7, arena.id(0));
+  EXPECT_STREQ("Lemon cake", arena.title(0));
+  EXPECT_EQ(10, arena.length(0));
+  EXPECT_STREQ("Soup", arena.title(1));
+}
+
+TEST(TitleArenaTest, ClearKeepsCapacity) {
+  TitleArena arena;
+  arena.reserve(100, 1000);
+  arena.push_back(1, "Cake");
+  size_t memory = arena.memory();
+  arena.clear();
+  EXPECT_TRUE(arena.empty());
+  EXPECT_EQ(0, arena.text().size());
+  EXPECT_EQ(memory, arena.memory());
+}
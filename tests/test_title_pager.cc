@@ -0,0 +1,86 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <sstream>
+#include <gtest/gtest.h>
+#include "title_pager.hh"
+
+
+using namespace std;
+
+static void insert_titles(Database &database, const char *prefix, int count) {
+  for (int i=0; i<count; i++) {
+    ostringstream title;
+    title << prefix << " " << 1000 + i;
+    Recipe recipe;
+    recipe.set_title(title.str().c_str());
+    database.insert_recipe(recipe);
+  };
+}
+
+static TitlePager first_page(Database &database) {
+  TitlePager pager(&database);
+  TitleArena page;
+  database.recipe_info_page("", 0, TITLES_PAGE_SIZE, page);
+  pager.reset(page);
+  return pager;
+}
+
+TEST(TitlePagerTest, LoadFirstPage) {
+  Database database;
+  database.open(":memory:");
+  insert_titles(database, "Apple pie", TITLES_PAGE_SIZE + 1);
+  TitlePager pager = first_page(database);
+  EXPECT_EQ(TITLES_PAGE_SIZE, pager.titles().size());
+  EXPECT_TRUE(pager.more());
+  EXPECT_EQ(1, pager.load_page());
+  pager.append_page();
+  EXPECT_EQ(TITLES_PAGE_SIZE + 1, pager.titles().size());
+  EXPECT_FALSE(pager.more());
+}
+
+TEST(TitlePagerTest, SkipPagesWithoutMatches) {
+  Database database;
+  database.open(":memory:");
+  insert_titles(database, "Apple pie", 2 * TITLES_PAGE_SIZE);
+  insert_titles(database, "Banana bread", 1);
+  TitlePager pager = first_page(database);
+  vector<size_t> rows = pager.fetch_matches("banana", 4);
+  ASSERT_EQ(1, rows.size());
+  EXPECT_STREQ("Banana bread 1000", pager.titles().title(rows[0]));
+  EXPECT_FALSE(pager.more());
+}
+
+TEST(TitlePagerTest, LimitPagesPerFetch) {
+  Database database;
+  database.open(":memory:");
+  insert_titles(database, "Apple pie", 3 * TITLES_PAGE_SIZE);
+  insert_titles(database, "Banana bread", 1);
+  TitlePager pager = first_page(database);
+  EXPECT_TRUE(pager.fetch_matches("banana", 1).empty());
+  EXPECT_TRUE(pager.more());
+  EXPECT_EQ(1, pager.fetch_matches("banana", 4).size());
+}
+
+TEST(TitlePagerTest, SkipAddedRecipes) {
+  Database database;
+  database.open(":memory:");
+  insert_titles(database, "Apple pie", TITLES_PAGE_SIZE + 2);
+  TitlePager pager = first_page(database);
+  pager.added(TITLES_PAGE_SIZE + 1);
+  EXPECT_EQ(1, pager.load_page());
+  pager.append_page();
+  EXPECT_EQ(TITLES_PAGE_SIZE + 1, pager.titles().size());
+}
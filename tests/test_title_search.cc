@@ -0,0 +1,167 @@
+/* AnyMeal recipe management software
+   Copyright (C) 2026 Jan Wedekind
+
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <https://www.gnu.org/licenses/>. */
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <gtest/gtest.h>
+#include "title_search.hh"
+
+
+using namespace std;
+
+static vector<size_t> find(const char *text, const char *pattern, bool simd) {
+  vector<size_t> positions;
+  string s(text);
+  if (simd)
+    find_nocase(s.data(), s.size(), pattern, positions);
+  else
+    find_nocase_scalar(s.data(), s.size(), pattern, positions);
+  return positions;
+}
+
+TEST(TitleSearchTest, NoMatch) {
+  EXPECT_TRUE(find("Apple pie", "cake", true).empty());
+}
+
+TEST(TitleSearchTest, EmptyPatternHasNoPositions) {
+  EXPECT_TRUE(find("Apple pie", "", true).empty());
+}
+
+TEST(TitleSearchTest, FindIgnoringCase) {
+  vector<size_t> positions = find("Apple PIE and apple pie", "apple", true);
+  ASSERT_EQ(2, positions.size());
+  EXPECT_EQ(0, positions[0]);
+  EXPECT_EQ(14, positions[1]);
+}
+
+TEST(TitleSearchTest, FindInLongText) {
+  vector<size_t> positions = find("Chocolate cake with hazelnuts and a CHOCOLATE glaze", "chocolate", true);
+  ASSERT_EQ(2, positions.size());
+  EXPECT_EQ(0, positions[0]);
+  EXPECT_EQ(36, positions[1]);
+}
+
+TEST(TitleSearchTest, FindAtEnd) {
+  vector<size_t> positions = find("Traditional potato salad with bacon", "Bacon", true);
+  ASSERT_EQ(1, positions.size());
+  EXPECT_EQ(30, positions[0]);
+}
+
+TEST(TitleSearchTest, KeepNonAsciiBytes) {
+  EXPECT_EQ(1, find("Käsekuchen", "kä", true).size());
+  EXPECT_TRUE(find("Käsekuchen", "kÄ", true).empty());
+}
+
+TEST(TitleSearchTest, AgreeWithScalarVersion) {
+  string text;
+  const char *words[] = {"Apple", "pie", "CAKE", "cakes", "Käse", "a", "aa", "soup"};
+  srand(42);
+  for (int i=0; i<2000; i++) {
+    text += words[rand() % (sizeof(words) / sizeof(*words))];
+    text += i % 5 == 0 ? '\0' : ' ';
+  };
+  const char *patterns[] = {"a", "aa", "cake", "pie c", "äse", "soup aa a", "apple pie"};
+  for (size_t i=0; i<sizeof(patterns) / sizeof(*patterns); i++) {
+    vector<size_t> simd;
+    vector<size_t> scalar;
+    string pattern(patterns[i]);
+    find_nocase(text.data(), text.size(), pattern, simd);
+    find_nocase_scalar(text.data(), text.size(), pattern, scalar);
+    EXPECT_EQ(scalar, simd) << patterns[i];
+  };
+}
+
+TEST(TitleSearchTest, SearchTitles) {
+  TitleArena titles;
+  titles.push_back(1, "Apple pie");
+  titles.push_back(2, "Cheese cake");
+  titles.push_back(3, "Pancakes");
+  titles.push_back(4, "Soup");
+  vector<size_t> rows = search_titles(titles, "CAKE");
+  ASSERT_EQ(2, rows.size());
+  EXPECT_EQ(1, rows[0]);
+  EXPECT_EQ(2, rows[1]);
+}
+
+TEST(TitleSearchTest, SearchTitlesFromRow) {
+  TitleArena titles;
+  titles.push_back(1, "Cheese cake");
+  titles.push_back(2, "Apple pie");
+  titles.push_back(3, "Pancakes");
+  vector<size_t> rows = search_titles(titles, "cake", 1);
+  ASSERT_EQ(1, rows.size());
+  EXPECT_EQ(2, rows[0]);
+  EXPECT_TRUE(search_titles(titles, "cake", 3).empty());
+  EXPECT_EQ(2, search_titles(titles, "", 1).size());
+}
+
+TEST(TitleSearchTest, SearchFromReplacedRow) {
+  TitleArena titles;
+  titles.push_back(1, "Soup");
+  titles.push_back(2, "Pancakes");
+  titles.push_back(3, "Bread");
+  titles.set(1, 2, "Cupcakes");
+  vector<size_t> rows = search_titles(titles, "cake", 1);
+  ASSERT_EQ(1, rows.size());
+  EXPECT_EQ(1, rows[0]);
+  rows = search_titles(titles, "bread", 1);
+  ASSERT_EQ(1, rows.size());
+  EXPECT_EQ(2, rows[0]);
+}
+
+TEST(TitleSearchTest, EmptyPatternMatchesAllTitles) {
+  TitleArena titles;
+  titles.push_back(1, "Apple pie");
+  titles.push_back(2, "Soup");
+  EXPECT_EQ(2, search_titles(titles, "").size());
+}
+
+TEST(TitleSearchTest, MatchDoesNotSpanTitles) {
+  TitleArena titles;
+  titles.push_back(1, "Apple");
+  titles.push_back(2, "pie");
+  EXPECT_TRUE(search_titles(titles, "applepie").empty());
+  EXPECT_EQ(1, search_titles(titles, "le").size());
+}
+
+TEST(TitleSearchTest, SearchReplacedTitles) {
+  TitleArena titles;
+  titles.push_back(1, "Apple pie");
+  titles.push_back(2, "Soup");
+  titles.set(0, 3, "Cherry pie");
+  EXPECT_TRUE(search_titles(titles, "apple").empty());
+  vector<size_t> rows = search_titles(titles, "cherry");
+  ASSERT_EQ(1, rows.size());
+  EXPECT_EQ(0, rows[0]);
+}
+
+TEST(TitleSearchTest, DISABLED_BenchmarkSearchTitles) {
+  TitleArena titles;
+  const char *words[] = {"Apple", "pie", "Cheese", "cake", "Tomato", "soup", "Chicken", "curry", "with", "rice"};
+  srand(42);
+  for (int i=0; i<250000; i++) {
+    char title[256];
+    snprintf(title, sizeof(title), "%s %s %s %s %d", words[rand() % 10], words[rand() % 10], words[rand() % 10],
+             words[rand() % 10], i);
+    titles.push_back(i + 1, title);
+  };
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
+  vector<size_t> rows = search_titles(titles, "cheese cake");
+  chrono::steady_clock::time_point stop = chrono::steady_clock::now();
+  cout << rows.size() << " matches in " << chrono::duration<double, milli>(stop - start).count() << " ms" << endl;
+  EXPECT_FALSE(rows.empty());
+}